@@ -0,0 +1,396 @@
+/**
+ *  @file  Benchmark.cpp
+ *
+ *  @brief  The bench command-line program.
+ *
+ *  The bench command-line program.  It generates synthetic acl/pcl pairs of increasing
+ *  size with a CorpusGenerator and measures the throughput of parsing (into lists and
+ *  tables, and through the parsed file cache), comparing and interning (with the fixed
+ *  and the open vocabulary) and confusion accumulation on them.  Each measurement is
+ *  the best of several repeats and is reported in MB/s and patches/s, on the console
+ *  and as JSON for regression tracking.
+ *
+ *    bench [--sizes N,N,...] [--subsamples S] [--distribution uniform|zipf|CODE:W,...]
+ *          [--none-rate R] [--agreement R] [--wrap K] [--spaced] [--seed N]
+ *          [--repeat R] [--stream-limit N] [--dir D] [--output results.json]
+ *          [--isa scalar|sse2|avx2|avx512]
+ *
+ *  Sizes are total patches per file (spread over the subsamples) and run from 1K to 10M
+ *  by default; 100M is supported but needs several GB for the parsed lists.  --isa
+ *  limits the delimiter search to the given instruction set (the best supported one
+ *  by default).
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include <boost/algorithm/string.hpp>
+  #include <boost/filesystem.hpp>
+  #include <boost/lexical_cast.hpp>
+
+  #include <chrono>
+  #include <fstream>
+  #include <iomanip>
+  #include <iostream>
+  #include <stdexcept>
+  #include <string>
+  #include <string_view>
+  #include <vector>
+
+  #include <cstdlib>
+
+  #include "ClassificationCache.h"
+  #include "ClassificationList.h"
+  #include "ClassificationTable.h"
+  #include "ConfusionMatrix.h"
+  #include "ConfusionTensor.h"
+  #include "CorpusGenerator.h"
+  #include "DelimiterScanner.h"
+  #include "DynamicConfusionMatrix.h"
+  #include "LabelTable.h"
+  #include "LockstepComparator.h"
+  #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  One throughput measurement.
+ */
+
+        struct Measurement
+          {
+            std::string name;     /**< @brief  the benchmark name                       */
+            uint64_t    patches;  /**< @brief  the patches processed per run            */
+            uint64_t    bytes;    /**< @brief  the input bytes per run (0 if not text)  */
+            double      seconds;  /**< @brief  the best time of a run                   */
+          };
+
+/**
+ *  A sink for benchmark results, so the measured work cannot be optimized away.
+ */
+
+        volatile uint64_t sink = 0;
+
+/**
+ *  Returns the best wall time of repeated runs of a function.
+ */
+
+        template <typename Function>
+          double BestTime(const uint32_t repeat,
+                          Function       function)
+            {
+              double best = 0.0;
+              for (uint32_t run = 0; run < repeat; ++run)
+                {
+                  const std::chrono::steady_clock::time_point
+                      start = std::chrono::steady_clock::now();
+                  function();
+                  const double seconds =
+                      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                  if ((run == 0) || (seconds < best))
+                    {
+                      best = seconds;
+                    }
+                }
+              return (best);
+            }
+
+/**
+ *  Returns a list of patch counts such as "1000,10000".
+ */
+
+        std::vector<uint64_t> ParseSizes(const std::string& sizes)
+          {
+            std::vector<std::string> fields;
+            boost::split(fields,sizes,boost::is_any_of(","));
+            std::vector<uint64_t> result;
+            for (const std::string& field : fields)
+              {
+                result.push_back(boost::lexical_cast<uint64_t>(field));
+              }
+            return (result);
+          }
+
+/**
+ *  Returns the counts of all the patches in a list.
+ */
+
+        uint64_t CountPatches(const APRT::ClassificationList& list)
+          {
+            uint64_t count = 0;
+            for (const std::vector<APRT::PatchClassification>& subsample : list.Classifications())
+              {
+                count += subsample.size();
+              }
+            return (count);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The main entry point to the program.
+ *
+ *  @param [in]  argc  the number of input arguments
+ *  @param [in]  argv  the strings of input arguments
+ *
+ *  @return  EXIT_SUCCESS, or EXIT_FAILURE upon an exception
+ */
+
+  int main(int argc, char* argv[])
+    {
+      try
+        {
+//
+//  Read the options ...
+//
+          APRT::CorpusOptions   options;
+          std::vector<uint64_t> sizes       = ParseSizes("1000,10000,100000,1000000,10000000");
+          std::string           distribution = "zipf";
+          uint32_t              repeat      = 3;
+          uint64_t              streamlimit = 10000000;
+          std::string           directory   =
+              (boost::filesystem::temp_directory_path() / "comparelist-bench").string();
+          std::string           output      = "bench_results.json";
+          std::string           isa         = APRT::DelimiterScanner::Name(APRT::DelimiterScanner::Best());
+          for (int i = 1; i < argc; ++i)
+            {
+              const std::string option(argv[i]);
+              const std::string value((i + 1 < argc) ? argv[i + 1] : "");
+              if      (option == "--spaced")       { options.spaced = true; continue; }
+              else if (i + 1 >= argc)              { throw std::runtime_error("Invalid argument list. Try again."); }
+              else if (option == "--sizes")        { sizes = ParseSizes(value); }
+              else if (option == "--subsamples")   { options.subsamples = boost::lexical_cast<uint32_t>(value); }
+              else if (option == "--distribution") { distribution = value; }
+              else if (option == "--none-rate")    { options.noneRate = boost::lexical_cast<double>(value); }
+              else if (option == "--agreement")    { options.agreement = boost::lexical_cast<double>(value); }
+              else if (option == "--wrap")         { options.wrap = boost::lexical_cast<uint32_t>(value); }
+              else if (option == "--seed")         { options.seed = boost::lexical_cast<uint64_t>(value); }
+              else if (option == "--repeat")       { repeat = boost::lexical_cast<uint32_t>(value); }
+              else if (option == "--stream-limit") { streamlimit = boost::lexical_cast<uint64_t>(value); }
+              else if (option == "--dir")          { directory = value; }
+              else if (option == "--output")       { output = value; }
+              else if (option == "--isa")          { isa = value; }
+              else                                 { throw std::runtime_error("Invalid argument list. Try again."); }
+              ++i;
+            }
+          options.weights = APRT::CorpusGenerator::Weights(distribution);
+          for (int named = APRT::DelimiterScanner::Scalar; ; ++named)
+            {
+              if (named > APRT::DelimiterScanner::Avx512)
+                {
+                  throw std::runtime_error("Invalid argument list. Try again.");
+                }
+              if (isa == APRT::DelimiterScanner::Name(APRT::DelimiterScanner::Isa(named)))
+                {
+                  isa = APRT::DelimiterScanner::Name(APRT::DelimiterScanner::Select(APRT::DelimiterScanner::Isa(named)));
+                  break;
+                }
+            }
+          if ((options.subsamples == 0) || (repeat == 0))
+            {
+              throw std::runtime_error("Invalid argument list. Try again.");
+            }
+          boost::filesystem::create_directories(directory);
+//
+//  Measure each size in turn ...
+//
+          std::vector<Measurement> measurements;
+          for (const uint64_t size : sizes)
+            {
+              options.patches = std::max<uint64_t>(size/options.subsamples,1);
+              const std::string acl = directory + "/bench.acl";
+              const std::string pcl = directory + "/bench.pcl";
+              const uint64_t patches = APRT::CorpusGenerator(options).Write(acl,pcl);
+              const uint64_t bytes   = boost::filesystem::file_size(pcl);
+              std::cout << "Measuring " << patches << " patches ("
+                        << bytes << " bytes) ..." << std::endl;
+//
+//  Parsing ...
+//
+              if (patches <= streamlimit)
+                {
+                  const double seconds = BestTime(repeat,[&]()
+                    {
+                      std::ifstream stream(pcl.c_str());
+                      sink = sink + CountPatches(APRT::ClassificationList(stream));
+                    });
+                  measurements.push_back(Measurement{"parse_stream",patches,bytes,seconds});
+                }
+              measurements.push_back(Measurement{"parse_mmap",patches,bytes,BestTime(repeat,[&]()
+                {
+                  sink = sink + CountPatches(APRT::ClassificationList(pcl));
+                })});
+              measurements.push_back(Measurement{"parse_selective",options.patches,bytes,BestTime(repeat,[&]()
+                {
+                  sink = sink + CountPatches(APRT::ClassificationList(pcl,std::vector<uint32_t>(1,1)));
+                })});
+              measurements.push_back(Measurement{"parse_table",patches,bytes,BestTime(repeat,[&]()
+                {
+                  const APRT::ClassificationTable table(pcl);
+                  sink = sink + table.Subsample(table.Subsamples()).size();
+                })});
+              const APRT::ClassificationCache cache(directory + "/cache");
+              cache.Load(pcl);
+              measurements.push_back(Measurement{"parse_cached",patches,bytes,BestTime(repeat,[&]()
+                {
+                  const APRT::ClassificationTable table = cache.Load(pcl);
+                  sink = sink + table.Subsample(table.Subsamples()).size();
+                })});
+//
+//  Comparing subsample 1, through tables and in lockstep ...
+//
+              const uint64_t pairbytes = bytes + boost::filesystem::file_size(acl);
+              measurements.push_back(Measurement{"compare_tables",options.patches,pairbytes,BestTime(repeat,[&]()
+                {
+                  const std::vector<uint32_t> subsample(1,1);
+                  const APRT::ClassificationTable pcltable(pcl,subsample);
+                  const APRT::ClassificationTable acltable(acl,subsample);
+                  const APRT::LabelSpan pclpatches = pcltable.Subsample(1);
+                  const APRT::LabelSpan aclpatches = acltable.Subsample(1);
+                  APRT::ConfusionMatrix<> conmatrix;
+                  for (size_t index = 0; index < std::min(pclpatches.size(),aclpatches.size()); ++index)
+                    {
+                      ++conmatrix(pclpatches[index],aclpatches[index]);
+                    }
+                  sink = sink + conmatrix(0,0);
+                })});
+              measurements.push_back(Measurement{"compare_lockstep",options.patches,pairbytes,BestTime(repeat,[&]()
+                {
+                  const APRT::MappedFile pclfile(pcl);
+                  const APRT::MappedFile aclfile(acl);
+                  APRT::ConfusionMatrix<> conmatrix;
+                  APRT::LockstepComparator::Compare(pclfile.Begin(),pclfile.End(),
+                                                    aclfile.Begin(),aclfile.End(),
+                                                    1,conmatrix);
+                  sink = sink + conmatrix(0,0);
+                })});
+              measurements.push_back(Measurement{"compare_all",patches,pairbytes,BestTime(repeat,[&]()
+                {
+                  const APRT::MappedFile pclfile(pcl);
+                  const APRT::MappedFile aclfile(acl);
+                  APRT::ConfusionTensor tensor;
+                  APRT::LockstepComparator::CompareAll(pclfile.Begin(),pclfile.End(),
+                                                       aclfile.Begin(),aclfile.End(),
+                                                       tensor);
+                  sink = sink + tensor.Subsamples();
+                })});
+              measurements.push_back(Measurement{"compare_lockstep_open",options.patches,pairbytes,BestTime(repeat,[&]()
+                {
+                  const APRT::MappedFile pclfile(pcl);
+                  const APRT::MappedFile aclfile(acl);
+                  APRT::LabelTable labels;
+                  APRT::DynamicConfusionMatrix conmatrix;
+                  APRT::LockstepComparator::Compare(pclfile.Begin(),pclfile.End(),
+                                                    aclfile.Begin(),aclfile.End(),
+                                                    1,labels,conmatrix);
+                  sink = sink + conmatrix(0,0);
+                })});
+//
+//  Interning and accumulation, on labels already in memory ...
+//
+              const APRT::ClassificationList pcllist(pcl);
+              const APRT::ClassificationList acllist(acl);
+              std::vector<std::string_view> labels;
+              std::vector<APRT::ClassId>    pclids;
+              std::vector<APRT::ClassId>    aclids;
+              for (uint32_t ssn = 0; ssn < pcllist.Classifications().size(); ++ssn)
+                {
+                  const std::vector<APRT::PatchClassification>& pclpatches = pcllist.Classifications()[ssn];
+                  const std::vector<APRT::PatchClassification>& aclpatches = acllist.Classifications()[ssn];
+                  for (size_t index = 0; index < pclpatches.size(); ++index)
+                    {
+                      labels.push_back(pclpatches[index].classification);
+                      pclids.push_back(pclpatches[index].classId);
+                      aclids.push_back(aclpatches[index].classId);
+                    }
+                }
+              measurements.push_back(Measurement{"intern",labels.size(),0,BestTime(repeat,[&]()
+                {
+                  uint64_t sum = 0;
+                  for (const std::string_view label : labels)
+                    {
+                      sum += APRT::ClassVocabulary::Intern(label);
+                    }
+                  sink = sink + sum;
+                })});
+              measurements.push_back(Measurement{"intern_open",labels.size(),0,BestTime(repeat,[&]()
+                {
+                  APRT::LabelTable table;
+                  uint64_t sum = 0;
+                  for (const std::string_view label : labels)
+                    {
+                      sum += table.Intern(label);
+                    }
+                  sink = sink + sum;
+                })});
+              measurements.push_back(Measurement{"accumulate",pclids.size(),0,BestTime(repeat,[&]()
+                {
+                  APRT::ConfusionMatrix<> conmatrix;
+                  for (size_t index = 0; index < pclids.size(); ++index)
+                    {
+                      ++conmatrix(pclids[index],aclids[index]);
+                    }
+                  sink = sink + conmatrix(0,0);
+                })});
+              boost::filesystem::remove(acl);
+              boost::filesystem::remove(pcl);
+            }
+//
+//  Report the measurements ...
+//
+          std::ofstream json(output.c_str());
+          json << "{\n  \"config\": {\"seed\": " << options.seed
+               << ", \"subsamples\": " << options.subsamples
+               << ", \"distribution\": \"" << distribution << "\""
+               << ", \"none_rate\": " << options.noneRate
+               << ", \"agreement\": " << options.agreement
+               << ", \"wrap\": " << options.wrap
+               << ", \"spaced\": " << (options.spaced ? "true" : "false")
+               << ", \"repeat\": " << repeat
+               << ", \"isa\": \"" << isa << "\"},\n  \"results\": [";
+          for (size_t index = 0; index < measurements.size(); ++index)
+            {
+              const Measurement& m = measurements[index];
+              const double mbps = (m.bytes != 0) ? m.bytes/m.seconds/1.0e6 : 0.0;
+              const double pps  = m.patches/m.seconds;
+              std::cout << std::left  << std::setw(22) << m.name
+                        << std::right << std::setw(12) << m.patches << " patches "
+                        << std::fixed << std::setprecision(1)
+                        << std::setw(10) << mbps << " MB/s "
+                        << std::setw(14) << pps  << " patches/s" << std::endl;
+              json << ((index != 0) ? ",\n" : "\n")
+                   << "    {\"name\": \"" << m.name << "\", \"patches\": " << m.patches
+                   << ", \"bytes\": " << m.bytes
+                   << ", \"seconds\": " << std::scientific << std::setprecision(6) << m.seconds
+                   << ", \"mb_per_s\": " << std::fixed << std::setprecision(3) << mbps
+                   << ", \"patches_per_s\": " << pps << "}";
+            }
+          json << "\n  ]\n}\n";
+          if (!json)
+            {
+              throw std::runtime_error("Unable to write " + output + ".");
+            }
+          std::cout << "Results written to " << output << std::endl;
+        }
+
+      catch (const boost::bad_lexical_cast&)
+        {
+          std::cout << "Invalid argument list. Try again." << std::endl;
+          return (EXIT_FAILURE);
+        }
+
+      catch (const std::exception& e)
+        {
+          std::cout << e.what() << std::endl;
+          return (EXIT_FAILURE);
+        }
+
+      return (EXIT_SUCCESS);
+    }
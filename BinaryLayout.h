@@ -0,0 +1,149 @@
+/**
+ *  @file  BinaryLayout.h
+ *
+ *  @brief  Definition of the helpers shared by the binary file formats.
+ *
+ *  Definition of the Padded, Concatenate, ReadHeader and Ascending functions, which lay
+ *  out and check the classification cache entries, disagreement indexes, patch
+ *  containers, patch tensors and feature stores.  Each of those starts with a fixed-size
+ *  header (whose first eight bytes are "APRT", a three-letter kind and the format
+ *  version), keeps its parts aligned to eight bytes and locates its strings and records
+ *  through tables of count + 1 offsets.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_BINARY_LAYOUT_H_INCLUDED
+    #define APRT_BINARY_LAYOUT_H_INCLUDED
+
+    #include <algorithm>
+    #include <string>
+    #include <vector>
+
+    #include <cstring>
+    #include <stdint.h>
+
+    #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+        uint64_t Padded(uint64_t length);
+
+        template <typename Strings>
+          std::string Concatenate(const Strings&         strings,
+                                  std::vector<uint64_t>& offsets);
+
+        template <typename Header>
+          bool ReadHeader(const MappedFile& file,
+                          const char        (&magic)[8],
+                          Header&           header);
+
+        bool Ascending(const uint64_t* offsets,
+                       uint64_t        count,
+                       uint64_t        end);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns a length padded to a multiple of eight bytes.
+ *
+ *  @param [in]  length  the length
+ *
+ *  @return  the padded length
+ */
+
+    inline uint64_t APRT::Padded(const uint64_t length)
+      {
+        return ((length + 7) & ~uint64_t(7));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Concatenates strings, returning the start of each (and the end) in offsets.  The text
+ *  is padded with NULs to a multiple of eight bytes; offsets.back() is its unpadded
+ *  length.
+ *
+ *  @param [in]   strings  the strings
+ *  @param [out]  offsets  the start of each string, plus the end of the last
+ *
+ *  @return  the padded text
+ */
+
+    template <typename Strings>
+      std::string APRT::Concatenate(const Strings&         strings,
+                                    std::vector<uint64_t>& offsets)
+        {
+          std::string text;
+          offsets.assign(1,0);
+          for (const auto& string : strings)
+            {
+              text.append(string.data(),string.size());
+              offsets.push_back(text.size());
+            }
+          text.resize(Padded(text.size()),'\0');
+          return (text);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Copies the header from the start of a mapped file, if the file is long enough and
+ *  starts with the expected magic.  The caller still checks the header's counts against
+ *  the file size.
+ *
+ *  @param [in]   file    the mapped file
+ *  @param [in]   magic   the expected magic and format version
+ *  @param [out]  header  the header (whose first member is the magic)
+ *
+ *  @return  true if the header has been copied and has the expected magic
+ */
+
+    template <typename Header>
+      bool APRT::ReadHeader(const MappedFile& file,
+                            const char        (&magic)[8],
+                            Header&           header)
+        {
+          if (file.Size() < sizeof(header))
+            {
+              return (false);
+            }
+          std::memcpy(&header,file.Begin(),sizeof(header));
+          return (std::memcmp(header.magic,magic,sizeof(magic)) == 0);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Checks a table of count + 1 offsets (the start of each string, record or row, plus the
+ *  end) read from a file, so that lookups through it stay in range.
+ *
+ *  @param [in]  offsets  the table
+ *  @param [in]  count    the number of entries
+ *  @param [in]  end      the expected last offset
+ *
+ *  @return  true if the table starts at 0, never decreases and ends at end
+ */
+
+    inline bool APRT::Ascending(const uint64_t* const offsets,
+                                const uint64_t        count,
+                                const uint64_t        end)
+      {
+        return ((offsets[0] == 0) && (offsets[count] == end) &&
+                std::is_sorted(offsets,offsets + count + 1));
+      }
+
+  #endif
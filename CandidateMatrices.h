@@ -0,0 +1,165 @@
+/**
+ *  @file  CandidateMatrices.h
+ *
+ *  @brief  Definition of the CandidateMatrices class.
+ *
+ *  Definition of the CandidateMatrices class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CANDIDATE_MATRICES_H_INCLUDED
+    #define APRT_CANDIDATE_MATRICES_H_INCLUDED
+
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ConfusionMatrix.h"
+    #include "PatchCounts.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The confusion matrices of several candidate apr classifications of a subsample
+ *  against the same user classification, one per candidate, with the number of patches
+ *  each candidate and the user had.  Candidates are numbered from zero, in the order
+ *  they were given.
+ */
+
+        class CandidateMatrices
+          {
+            public:
+              explicit CandidateMatrices(uint32_t candidates = 0);
+
+            public:
+              ConfusionMatrix<>&        operator () (uint32_t candidate);
+              const ConfusionMatrix<>&  operator () (uint32_t candidate) const;
+              PatchCounts&              Counts(uint32_t candidate);
+              const PatchCounts&        Counts(uint32_t candidate) const;
+              CandidateMatrices&        operator += (const CandidateMatrices& other);
+              uint32_t                  Candidates() const;
+            private:
+              std::vector<ConfusionMatrix<> >  matrices;
+                /**< @brief  the confusion matrix of each candidate */
+              std::vector<PatchCounts>         counts;
+                /**< @brief  the patch counts of each candidate */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates CandidateMatrices with all counts zero.
+ *
+ *  @param [in]  candidates  the number of candidates
+ */
+
+    inline APRT::CandidateMatrices::CandidateMatrices(const uint32_t candidates)
+      : matrices(candidates),
+        counts(candidates,PatchCounts{0,0})
+          {
+            ;
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the confusion matrix of a candidate.
+ *
+ *  @param [in]  candidate  the zero-based candidate number
+ *
+ *  @return  the confusion matrix
+ */
+
+    inline APRT::ConfusionMatrix<>& APRT::CandidateMatrices::operator () (const uint32_t candidate)
+      {
+        assert(candidate < this->Candidates());
+        return (this->matrices[candidate]);
+      }
+
+    inline const APRT::ConfusionMatrix<>& APRT::CandidateMatrices::operator () (const uint32_t candidate) const
+      {
+        assert(candidate < this->Candidates());
+        return (this->matrices[candidate]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the patch counts of a candidate.
+ *
+ *  @param [in]  candidate  the zero-based candidate number
+ *
+ *  @return  the patch counts
+ */
+
+    inline APRT::PatchCounts& APRT::CandidateMatrices::Counts(const uint32_t candidate)
+      {
+        assert(candidate < this->Candidates());
+        return (this->counts[candidate]);
+      }
+
+    inline const APRT::PatchCounts& APRT::CandidateMatrices::Counts(const uint32_t candidate) const
+      {
+        assert(candidate < this->Candidates());
+        return (this->counts[candidate]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the matrices and counts of another set to this one, candidate by candidate,
+ *  first growing this set to the candidates of the other if it has fewer.
+ *
+ *  @param [in]  other  the matrices to add
+ *
+ *  @return  these matrices
+ */
+
+    inline APRT::CandidateMatrices& APRT::CandidateMatrices::operator += (const CandidateMatrices& other)
+      {
+        if (other.Candidates() > this->Candidates())
+          {
+            this->matrices.resize(other.Candidates());
+            this->counts.resize(other.Candidates(),PatchCounts{0,0});
+          }
+        for (uint32_t candidate = 0; candidate < other.Candidates(); ++candidate)
+          {
+            (*this)(candidate) += other(candidate);
+            this->Counts(candidate) += other.Counts(candidate);
+          }
+        return (*this);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of candidates.
+ *
+ *  @return  the number of candidates
+ */
+
+    inline uint32_t APRT::CandidateMatrices::Candidates() const
+      {
+        return (uint32_t(this->matrices.size()));
+      }
+
+  #endif
@@ -0,0 +1,92 @@
+/**
+ *  @file  ClassVocabulary.h
+ *
+ *  @brief  Definition of the ClassVocabulary class.
+ *
+ *  Definition of the ClassVocabulary class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CLASS_VOCABULARY_H_INCLUDED
+    #define APRT_CLASS_VOCABULARY_H_INCLUDED
+
+    #include <string_view>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "Taxonomy.h"
+
+    #ifdef APRT_TAXONOMY_HEADER
+      #include APRT_TAXONOMY_HEADER
+    #else
+      #include "UrinalysisTaxonomy.h"
+    #endif
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The vocabulary of apr and user class codes: the AssayTaxonomy the program was built
+ *  for.  Codes are interned to a compact ClassId when a classification list is parsed,
+ *  so comparisons of classifications are integer comparisons.
+ */
+
+        class ClassVocabulary
+          {
+            public:
+              static constexpr uint32_t Size = AssayTaxonomy.Size;
+                /**< @brief  the number of classes (including NONE) */
+              static constexpr ClassId  None = AssayTaxonomy.None();
+                /**< @brief  the class of empty and unrecognized codes */
+
+            public:
+              static ClassId
+                Intern(std::string_view code);
+              static std::string_view
+                Code(ClassId id);
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Interns a class code.
+ *
+ *  @param [in]  code  the apr- or user-assigned class code
+ *
+ *  @return  the interned class
+ */
+
+    inline APRT::ClassId APRT::ClassVocabulary::Intern(const std::string_view code)
+      {
+        return (AssayTaxonomy.Intern(code));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of an interned class.
+ *
+ *  @param [in]  id  the interned class
+ *
+ *  @return  the class code
+ */
+
+    inline std::string_view APRT::ClassVocabulary::Code(const ClassId id)
+      {
+        assert(id < ClassVocabulary::Size);
+        return (AssayTaxonomy.Code(id));
+      }
+
+  #endif
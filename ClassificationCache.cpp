@@ -0,0 +1,322 @@
+/**
+ *  @file  ClassificationCache.cpp
+ *
+ *  @brief  Implementation of the ClassificationCache class.
+ *
+ *  Implementation of the ClassificationCache class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "ClassificationCache.h"
+
+  #include <boost/filesystem.hpp>
+
+  #include <algorithm>
+  #include <cstring>
+  #include <fstream>
+  #include <stdexcept>
+  #include <string_view>
+
+  #ifndef _WIN32
+    #include <sys/stat.h>
+  #endif
+
+  #include "BinaryLayout.h"
+  #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The fixed-size start of a cache entry.  It is followed by the source path (padded to
+ *  a multiple of eight bytes), subsamples + 1 offsets and then patches labels, all in
+ *  native byte order.
+ */
+
+        struct EntryHeader
+          {
+            char      magic[8];    /**< @brief  "APRTCLT" and the format version   */
+            uint64_t  vocabulary;  /**< @brief  the hash of the class vocabulary   */
+            uint64_t  size;        /**< @brief  the source file size               */
+            int64_t   mtime;       /**< @brief  the source modification time       */
+            uint64_t  pathlength;  /**< @brief  the length of the source path      */
+            uint64_t  subsamples;  /**< @brief  the number of subsamples           */
+            uint64_t  patches;     /**< @brief  the number of labels               */
+          };
+
+        const char Magic[8] = {'A','P','R','T','C','L','T','\x01'};
+
+/**
+ *  Returns the 64-bit FNV-1a hash of some bytes, continuing from a previous hash.
+ */
+
+        uint64_t Hash(const std::string_view bytes,
+                      uint64_t               hash = 14695981039346656037ULL)
+          {
+            for (const char byte : bytes)
+              {
+                hash = (hash ^ uint8_t(byte)) * 1099511628211ULL;
+              }
+            return (hash);
+          }
+
+/**
+ *  Returns a hash of the class codes in ClassId order, so entries interned with another
+ *  vocabulary are never loaded.
+ */
+
+        uint64_t VocabularyHash()
+          {
+            uint64_t hash = Hash(std::string_view());
+            for (uint32_t id = 0; id < APRT::ClassVocabulary::Size; ++id)
+              {
+                hash = Hash(APRT::ClassVocabulary::Code(APRT::ClassId(id)),hash);
+                hash = Hash(std::string_view(",",1),hash);
+              }
+            return (hash);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Opens (creating if necessary) a cache directory.
+ *
+ *  @param [in]  directory  the directory holding the cache entries
+ */
+
+  APRT::ClassificationCache::ClassificationCache(const std::string& directory)
+    : directory(directory)
+      {
+        boost::system::error_code error;
+        boost::filesystem::create_directories(directory,error);
+        if (!boost::filesystem::is_directory(directory))
+          {
+            throw std::runtime_error("Unable to create the cache directory " + directory + ".");
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the ClassificationTable of an acl/pcl file, from its cache entry if the entry
+ *  is current, and otherwise by parsing the file and (re)writing the entry.
+ *
+ *  @param [in]  path  the acl/pcl file path
+ *
+ *  @return  the table of all the subsamples of the file
+ */
+
+  APRT::ClassificationTable APRT::ClassificationCache::Load(const std::string& path) const
+    {
+//
+//  The identity is taken before parsing, so a file changed during the parse leaves
+//  an entry that is already stale ...
+//
+      const FileIdentity identity = Identify(path);
+      const std::string  entry    = this->EntryPath(path);
+      ClassificationTable table;
+      if (Read(entry,path,identity,table))
+        {
+          return (table);
+        }
+      table = ClassificationTable(path);
+      Write(entry,path,identity,table);
+
+      return (table);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the size and modification time of a file.
+ *
+ *  @param [in]  path  the file path
+ *
+ *  @return  the file identity
+ */
+
+  APRT::FileIdentity APRT::ClassificationCache::Identify(const std::string& path)
+    {
+      FileIdentity identity;
+      #ifndef _WIN32
+        struct stat status;
+        if (::stat(path.c_str(),&status) != 0)
+          {
+            throw std::runtime_error("Unable to read " + path + ".");
+          }
+        identity.size = uint64_t(status.st_size);
+        #ifdef __APPLE__
+          identity.mtime = int64_t(status.st_mtimespec.tv_sec) * 1000000000 + status.st_mtimespec.tv_nsec;
+        #else
+          identity.mtime = int64_t(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+        #endif
+      #else
+        identity.size  = uint64_t(boost::filesystem::file_size(path));
+        identity.mtime = int64_t(boost::filesystem::last_write_time(path)) * 1000000000;
+      #endif
+
+      return (identity);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the path of the cache entry of an acl/pcl file.
+ *
+ *  @param [in]  path  the acl/pcl file path
+ *
+ *  @return  the entry path
+ */
+
+  std::string APRT::ClassificationCache::EntryPath(const std::string& path) const
+    {
+      static const char digits[] = "0123456789abcdef";
+      uint64_t hash = Hash(boost::filesystem::absolute(path).string());
+      std::string name(16,'0');
+      for (size_t i = name.size(); i-- > 0; hash >>= 4)
+        {
+          name[i] = digits[hash & 0xF];
+        }
+
+      return ((boost::filesystem::path(this->directory) / (name + ".clt")).string());
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Loads a cache entry if it exists and is current.
+ *
+ *  @param [in]   entry     the entry path
+ *  @param [in]   path      the acl/pcl file path
+ *  @param [in]   identity  the current identity of the acl/pcl file
+ *  @param [out]  table     the cached table
+ *
+ *  @return  true if the entry was current and has been loaded
+ */
+
+  bool APRT::ClassificationCache::Read(const std::string&   entry,
+                                       const std::string&   path,
+                                       const FileIdentity&  identity,
+                                       ClassificationTable& table)
+    {
+      boost::system::error_code error;
+      if (!boost::filesystem::is_regular_file(entry,error))
+        {
+          return (false);
+        }
+      const MappedFile file(entry);
+      EntryHeader header;
+      if (!ReadHeader(file,Magic,header))
+        {
+          return (false);
+        }
+      const std::string source = boost::filesystem::absolute(path).string();
+      if ((header.vocabulary != VocabularyHash()) ||
+          (header.size       != identity.size)    ||
+          (header.mtime      != identity.mtime)   ||
+          (header.pathlength != source.size()))
+        {
+          return (false);
+        }
+      if ((header.subsamples >= file.Size() / sizeof(uint64_t)) ||
+          (header.patches    >  file.Size()))
+        {
+          return (false);
+        }
+      const uint64_t pathstart    = sizeof(header);
+      const uint64_t offsetsstart = pathstart + Padded(header.pathlength);
+      const uint64_t labelsstart  = offsetsstart + (header.subsamples + 1) * sizeof(uint64_t);
+      if ((file.Size() != labelsstart + header.patches) ||
+          (source.compare(0,source.size(),file.Begin() + pathstart,header.pathlength) != 0))
+        {
+          return (false);
+        }
+//
+//  Copy out the columns, treating an entry whose subsamples or classes are out of range
+//  (a damaged file) as a miss ...
+//
+      std::vector<uint64_t> offsets(header.subsamples + 1);
+      std::memcpy(offsets.data(),file.Begin() + offsetsstart,offsets.size() * sizeof(uint64_t));
+      if (!Ascending(offsets.data(),header.subsamples,header.patches))
+        {
+          return (false);
+        }
+      std::vector<ClassId> labels(file.Begin() + labelsstart,file.End());
+      if (std::any_of(labels.begin(),labels.end(),[](const ClassId label) { return (label >= ClassVocabulary::Size); }))
+        {
+          return (false);
+        }
+      table = ClassificationTable(std::move(labels),std::move(offsets));
+
+      return (true);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes a cache entry.  The entry is written to a temporary file and renamed into
+ *  place.  A failure leaves no entry (the cache is only an optimization) and is not
+ *  reported.
+ *
+ *  @param [in]  entry     the entry path
+ *  @param [in]  path      the acl/pcl file path
+ *  @param [in]  identity  the identity of the acl/pcl file when it was parsed
+ *  @param [in]  table     the parsed table
+ */
+
+  void APRT::ClassificationCache::Write(const std::string&         entry,
+                                        const std::string&         path,
+                                        const FileIdentity&        identity,
+                                        const ClassificationTable& table)
+    {
+      const std::string source = boost::filesystem::absolute(path).string();
+      EntryHeader header;
+      std::memcpy(header.magic,Magic,sizeof(Magic));
+      header.vocabulary = VocabularyHash();
+      header.size       = identity.size;
+      header.mtime      = identity.mtime;
+      header.pathlength = source.size();
+      header.subsamples = table.Subsamples();
+      header.patches    = table.Labels().size();
+
+      const std::string temporary = entry + "." + boost::filesystem::unique_path().string();
+      std::ofstream stream(temporary.c_str(),std::ios_base::binary | std::ios_base::trunc);
+      stream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+      stream.write(source.data(),std::streamsize(source.size()));
+      stream.write("\0\0\0\0\0\0\0",std::streamsize(Padded(source.size()) - source.size()));
+      stream.write(reinterpret_cast<const char*>(table.Offsets().data()),
+                   std::streamsize(table.Offsets().size() * sizeof(uint64_t)));
+      stream.write(reinterpret_cast<const char*>(table.Labels().data()),
+                   std::streamsize(table.Labels().size()));
+      stream.close();
+//
+//  Publish the entry, or discard it if it could not be written ...
+//
+      boost::system::error_code error;
+      if (stream)
+        {
+          boost::filesystem::rename(temporary,entry,error);
+        }
+      if (!stream || error)
+        {
+          boost::filesystem::remove(temporary,error);
+        }
+    }
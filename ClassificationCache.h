@@ -0,0 +1,72 @@
+/**
+ *  @file  ClassificationCache.h
+ *
+ *  @brief  Definition of the ClassificationCache class.
+ *
+ *  Definition of the ClassificationCache class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CLASSIFICATION_CACHE_H_INCLUDED
+    #define APRT_CLASSIFICATION_CACHE_H_INCLUDED
+
+    #include <string>
+
+    #include <stdint.h>
+
+    #include "ClassificationTable.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The identity of an acl/pcl file: a cache entry is current while the file keeps the
+ *  size and modification time it had when the entry was made.
+ */
+
+        struct FileIdentity
+          {
+            uint64_t  size;   /**< @brief  the file size in bytes                   */
+            int64_t   mtime;  /**< @brief  the modification time, in nanoseconds    */
+          };
+
+/**
+ *  An on-disk cache of parsed acl/pcl files.  Each file is stored as a binary
+ *  ClassificationTable (a header, the subsample offsets and one byte per patch) in an
+ *  entry named after a hash of its absolute path.  The header records the path, the
+ *  file identity and the class vocabulary the labels were interned with; an entry that
+ *  does not match all three is stale and is rebuilt from the text on the next Load().
+ *  Loading a current entry takes one mapping and no parsing.  Entries are written to a
+ *  temporary file and renamed into place, so concurrent loads are safe.
+ */
+
+        class ClassificationCache
+          {
+            public:
+              explicit ClassificationCache(const std::string& directory);
+
+            public:
+              ClassificationTable  Load(const std::string& path) const;
+              static FileIdentity  Identify(const std::string& path);
+            private:
+              std::string  EntryPath(const std::string& path) const;
+              static bool  Read(const std::string&  entry,
+                                const std::string&  path,
+                                const FileIdentity& identity,
+                                ClassificationTable& table);
+              static void  Write(const std::string&         entry,
+                                 const std::string&         path,
+                                 const FileIdentity&        identity,
+                                 const ClassificationTable& table);
+            private:
+              std::string  directory;
+                /**< @brief  the directory holding the cache entries */
+          };
+      }
+
+  #endif
@@ -13,7 +13,12 @@
   #include <boost/algorithm/string.hpp>
   #include <boost/lexical_cast.hpp>
 
+  #include <algorithm>
   #include <iostream>
+  #include <iterator>
+
+  #include "ClassificationScanner.h"
+  #include "MappedFile.h"
 
 
 //-----------------------------------------------------------------------------------------------
@@ -48,6 +53,87 @@
     }
 
 
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Constructs a ClassificationList from the acl/pcl file at the given path.  The file is
+ *  memory-mapped and parsed in place with a ClassificationScanner, giving the same
+ *  result as the stream constructor without the per-character stream extraction.  The
+ *  class names are slices of the mapping, and short names fit in the small-string
+ *  buffer, so no patch needs a heap allocation.
+ *
+ *  @param [in]  path  the acl/pcl file path
+ */
+
+  APRT::ClassificationList::ClassificationList(const std::string& path)
+    {
+      this->Parse(path,std::vector<uint32_t>());
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Constructs a ClassificationList holding only the given subsamples of the acl/pcl file
+ *  at the given path.  The other subsamples are skipped without being parsed and are
+ *  left empty, so Classifications()[ssn-1] still addresses subsample ssn; the list ends
+ *  at the last requested subsample.
+ *
+ *  @param [in]  path        the acl/pcl file path
+ *  @param [in]  subsamples  the one-based numbers of the subsamples to parse
+ */
+
+  APRT::ClassificationList::ClassificationList(const std::string&           path,
+                                               const std::vector<uint32_t>& subsamples)
+    {
+      assert(!subsamples.empty());
+      this->Parse(path,subsamples);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps an acl/pcl file and parses the requested subsamples from it.
+ *
+ *  @param [in]  path        the acl/pcl file path
+ *  @param [in]  subsamples  the subsamples to parse (all of them if empty)
+ */
+
+  void APRT::ClassificationList::Parse(const std::string&           path,
+                                       const std::vector<uint32_t>& subsamples)
+    {
+      const MappedFile file(path);
+      ClassificationScanner scanner(file.Begin(),file.End());
+      const uint32_t stop = subsamples.empty() ?
+                                UINT32_MAX :
+                                *std::max_element(subsamples.begin(),subsamples.end());
+//
+//  Parse each <CLASS> block in the mapping (leaving unrequested blocks empty) ...
+//
+      while ((scanner.Subsample() < stop) && scanner.NextSubsample())
+        {
+          const uint32_t ssn = scanner.Subsample();
+          this->classifications.push_back(std::vector<PatchClassification>());
+          if (subsamples.empty() ||
+              (std::find(subsamples.begin(),subsamples.end(),ssn) != subsamples.end()))
+            {
+              std::vector<PatchClassification>& result = this->classifications.back();
+              result.reserve(scanner.PatchHint());
+              std::string_view className;
+              uint32_t index = 0;
+              while (scanner.NextPatch(className))
+                {
+                  result.emplace_back(ssn,index++,className);
+                }
+            }
+        }
+    }
+
+
 //-----------------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------------
 
@@ -15,12 +15,15 @@
 
     #include <iosfwd>
     #include <string>
+    #include <string_view>
     #include <vector>
 
     #include <cassert>
 
     #include <stdint.h>
 
+    #include "ClassVocabulary.h"
+
 
 //-----------------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------------
@@ -34,12 +37,13 @@
 
         struct PatchClassification
           {
-            PatchClassification(uint32_t           ssn,
-                                uint32_t           idx,
-                                const std::string& cls);
+            PatchClassification(uint32_t         ssn,
+                                uint32_t         idx,
+                                std::string_view cls);
             uint32_t    subsampleNumber;  /**< @brief  one-based subsample number      */
             uint32_t    patchIndex;       /**< @brief  zero-based for each subsample   */
             std::string classification;   /**< @brief  the apr- or user-assigned class */
+            ClassId     classId;          /**< @brief  the interned classification     */
           };
 
         inline bool operator == (const PatchClassification& A,
@@ -58,11 +62,16 @@
             public:
               ClassificationList();
               ClassificationList(std::istream& stream);
+              explicit ClassificationList(const std::string& path);
+              ClassificationList(const std::string&           path,
+                                 const std::vector<uint32_t>& subsamples);
 
             public:
               const std::vector<std::vector<PatchClassification> >&
                 Classifications() const;
             private:
+              void  Parse(const std::string&           path,
+                          const std::vector<uint32_t>& subsamples);
               static std::vector<PatchClassification>
                 SubsampleClassifications(std::istream& stream,
                                          uint32_t      ssn);
@@ -80,12 +89,13 @@
  *  Creates a PatchClassification with the given values.
  */
 
-    inline APRT::PatchClassification::PatchClassification(const uint32_t     ssn,
-                                                          const uint32_t     idx,
-                                                          const std::string& cls)
+    inline APRT::PatchClassification::PatchClassification(const uint32_t         ssn,
+                                                          const uint32_t         idx,
+                                                          const std::string_view cls)
       : subsampleNumber(ssn),
         patchIndex(idx),
-        classification(cls)
+        classification(cls),
+        classId(ClassVocabulary::Intern(cls))
           {
             ;
           }
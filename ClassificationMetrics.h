@@ -0,0 +1,255 @@
+/**
+ *  @file  ClassificationMetrics.h
+ *
+ *  @brief  Definition of the ClassificationMetrics struct.
+ *
+ *  Definition of the ClassificationMetrics struct.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CLASSIFICATION_METRICS_H_INCLUDED
+    #define APRT_CLASSIFICATION_METRICS_H_INCLUDED
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+    #include "ConfusionMatrix.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The agreement of the apr with the user classifications summed up from a confusion
+ *  matrix.  Precision, recall and F1 are averaged over the classes either side used
+ *  (macro averages); a class never called has a precision of zero, and one never
+ *  present a recall of zero.
+ */
+
+        struct ClassificationMetrics
+          {
+            uint64_t  patches;    /**< @brief  the patches counted                        */
+            double    accuracy;   /**< @brief  the fraction classified as the user did    */
+            double    precision;  /**< @brief  the mean precision of the classes          */
+            double    recall;     /**< @brief  the mean recall of the classes             */
+            double    f1;         /**< @brief  the mean F1 score of the classes           */
+            double    kappa;      /**< @brief  Cohen's kappa                              */
+          };
+
+/**
+ *  The margins of a confusion matrix: per class the patches the apr called it, the
+ *  patches the user did and the patches both did.  They are all the metrics need, so
+ *  tallies are summed and summed up in O(N) rather than O(N * N).
+ *
+ *  @tparam  N  the number of classes
+ */
+
+        template <uint32_t N = ClassVocabulary::Size>
+          struct ClassTally
+            {
+              uint64_t  called[N];   /**< @brief  the patches of each apr class     */
+              uint64_t  present[N];  /**< @brief  the patches of each user class    */
+              uint64_t  agreed[N];   /**< @brief  the patches both classes agree on */
+              uint64_t  patches;     /**< @brief  the patches counted               */
+
+              ClassTally() : called(), present(), agreed(), patches(0) {}
+              explicit ClassTally(const ConfusionMatrix<N>& matrix);
+              ClassTally& operator += (const ClassTally& other);
+              double      Precision(uint32_t id) const;
+              double      Recall(uint32_t id) const;
+              double      F1(uint32_t id) const;
+            };
+
+        template <uint32_t N>
+          ClassificationMetrics Summarize(const ClassTally<N>& tally);
+        template <uint32_t N>
+          ClassificationMetrics Summarize(const ConfusionMatrix<N>& matrix);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Tallies the margins of a confusion matrix.
+ *
+ *  @param [in]  matrix  the counts by apr (row) and user (column) class
+ */
+
+    template <uint32_t N>
+      inline APRT::ClassTally<N>::ClassTally(const ConfusionMatrix<N>& matrix)
+        : called(),
+          present(),
+          agreed(),
+          patches(0)
+          {
+            for (uint32_t pcl = 0; pcl < N; ++pcl)
+              {
+                for (uint32_t acl = 0; acl < N; ++acl)
+                  {
+                    called[pcl]  += uint64_t(matrix(pcl,acl));
+                    present[acl] += uint64_t(matrix(pcl,acl));
+                  }
+                agreed[pcl] = uint64_t(matrix(pcl,pcl));
+                patches    += called[pcl];
+              }
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds another tally (of another runfile, ...) to this one.
+ *
+ *  @param [in]  other  the tally to add
+ *
+ *  @return  this tally
+ */
+
+    template <uint32_t N>
+      inline APRT::ClassTally<N>& APRT::ClassTally<N>::operator += (const ClassTally& other)
+        {
+          for (uint32_t id = 0; id < N; ++id)
+            {
+              called[id]  += other.called[id];
+              present[id] += other.present[id];
+              agreed[id]  += other.agreed[id];
+            }
+          patches += other.patches;
+          return (*this);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the precision of a class: the fraction of the patches the apr called it that
+ *  the user did too.
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  the precision (zero for a class never called)
+ */
+
+    template <uint32_t N>
+      inline double APRT::ClassTally<N>::Precision(const uint32_t id) const
+        {
+          assert(id < N);
+          return ((called[id] != 0) ? double(agreed[id]) / called[id] : 0.0);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the recall of a class: the fraction of the patches the user called it that
+ *  the apr did too.
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  the recall (zero for a class never present)
+ */
+
+    template <uint32_t N>
+      inline double APRT::ClassTally<N>::Recall(const uint32_t id) const
+        {
+          assert(id < N);
+          return ((present[id] != 0) ? double(agreed[id]) / present[id] : 0.0);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the F1 score of a class, the harmonic mean of its precision and recall.
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  the F1 score (zero when both are)
+ */
+
+    template <uint32_t N>
+      inline double APRT::ClassTally<N>::F1(const uint32_t id) const
+        {
+          const double precision = this->Precision(id);
+          const double recall    = this->Recall(id);
+          return ((precision + recall > 0) ? 2 * precision * recall / (precision + recall) : 0.0);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Sums up the margins of a confusion matrix.
+ *
+ *  @param [in]  tally  the margins
+ *
+ *  @return  the metrics (all zero for an empty tally)
+ */
+
+    template <uint32_t N>
+      APRT::ClassificationMetrics APRT::Summarize(const ClassTally<N>& tally)
+        {
+          ClassificationMetrics metrics = {};
+          metrics.patches = tally.patches;
+          if (metrics.patches == 0)
+            {
+              return (metrics);
+            }
+//
+//  Average the per-class scores over the classes in use ...
+//
+          const double patches  = double(metrics.patches);
+          uint32_t     classes  = 0;
+          uint64_t     agreed   = 0;
+          double       expected = 0;
+          for (uint32_t id = 0; id < N; ++id)
+            {
+              agreed   += tally.agreed[id];
+              expected += (double(tally.called[id]) / patches) * (double(tally.present[id]) / patches);
+              if ((tally.called[id] != 0) || (tally.present[id] != 0))
+                {
+                  metrics.precision += tally.Precision(id);
+                  metrics.recall    += tally.Recall(id);
+                  metrics.f1        += tally.F1(id);
+                  ++classes;
+                }
+            }
+          metrics.accuracy   = double(agreed) / patches;
+          metrics.precision /= classes;
+          metrics.recall    /= classes;
+          metrics.f1        /= classes;
+          metrics.kappa      = (expected < 1) ? (metrics.accuracy - expected) / (1 - expected) : 1.0;
+          return (metrics);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Sums up a confusion matrix.
+ *
+ *  @param [in]  matrix  the counts by apr (row) and user (column) class
+ *
+ *  @return  the metrics (all zero for an empty matrix)
+ */
+
+    template <uint32_t N>
+      inline APRT::ClassificationMetrics APRT::Summarize(const ConfusionMatrix<N>& matrix)
+        {
+          return (Summarize(ClassTally<N>(matrix)));
+        }
+
+  #endif
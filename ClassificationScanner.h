@@ -0,0 +1,285 @@
+/**
+ *  @file  ClassificationScanner.h
+ *
+ *  @brief  Definition of the ClassificationScanner class.
+ *
+ *  Definition of the ClassificationScanner class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CLASSIFICATION_SCANNER_H_INCLUDED
+    #define APRT_CLASSIFICATION_SCANNER_H_INCLUDED
+
+    #include <algorithm>
+    #include <string>
+    #include <string_view>
+
+    #include <stdint.h>
+
+    #include "DelimiterScanner.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  A tokenizer for the <CLASS> blocks of acl/pcl text held in memory.  It visits the
+ *  subsamples and the class names within them in order, without copying: each class
+ *  name is a slice of the text.  The tokens are exactly those the stream parser of
+ *  ClassificationList produces: whitespace is ignored, an empty field is NONE, and an
+ *  unterminated field at the end of the text is dropped.  The delimiters are found by
+ *  the DelimiterScanner, those ending fields 64 bytes at a time.
+ */
+
+        class ClassificationScanner
+          {
+            public:
+              ClassificationScanner(const char* first,
+                                    const char* last);
+
+            public:
+              bool      NextSubsample();
+              bool      NextPatch(std::string_view& className);
+              uint32_t  Subsample() const;
+              size_t    PatchHint() const;
+            private:
+              static bool
+                IsSpace(char c);
+              static const char*
+                SkipSpace(const char* next, const char* last);
+              static const char*
+                SkipTerminator(const char* next, const char* last);
+            private:
+              const char*  next;
+                /**< @brief  the scan position */
+              const char*  last;
+                /**< @brief  the end of the text */
+              DelimiterCursor
+                           fields;
+                /**< @brief  the search for the ',' and '<' that end the fields */
+              uint32_t     ssn;
+                /**< @brief  the current (one-based) subsample number */
+              bool         inSubsample;
+                /**< @brief  whether patches remain in the current subsample */
+              std::string  packed;
+                /**< @brief  the current class name, when it has embedded whitespace */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a ClassificationScanner over the given text.
+ *
+ *  @param [in]  first  the start of the text
+ *  @param [in]  last   the end of the text
+ */
+
+    inline APRT::ClassificationScanner::ClassificationScanner(const char* const first,
+                                                              const char* const last)
+      : next(first),
+        last(last),
+        fields(last,',','<'),
+        ssn(0),
+        inSubsample(false)
+          {
+            ;
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Advances to the next <CLASS> block, skipping any patches left in the current one.
+ *  Lines are matched as the stream parser matches them: the text up to each '>' is the
+ *  tag (less leading whitespace), and when it is not "<CLASS" the rest of that line is
+ *  discarded.
+ *
+ *  @return  true if there is another subsample
+ */
+
+    inline bool APRT::ClassificationScanner::NextSubsample()
+      {
+        if (this->inSubsample)
+          {
+            this->next = SkipTerminator(DelimiterScanner::Find(this->next,this->last,'<'),this->last);
+            this->inSubsample = false;
+          }
+        static const std::string_view tag("<CLASS");
+        while (this->next != this->last)
+          {
+            const char* const delimiter = DelimiterScanner::Find(this->next,this->last,'>');
+            const char* const first     = SkipSpace(this->next,delimiter);
+            this->next = (delimiter != this->last) ? delimiter + 1 : this->last;
+            if (std::string_view(first,delimiter - first) == tag)
+              {
+                ++this->ssn;
+                this->inSubsample = true;
+                return (true);
+              }
+            this->next = DelimiterScanner::Find(this->next,this->last,'\n');  // discard the rest of the line
+            if (this->next != this->last)
+              {
+                ++this->next;
+              }
+          }
+        return (false);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Reads the next class name of the current subsample.  The name is valid until the next
+ *  call.
+ *
+ *  @param [out]  className  the class name
+ *
+ *  @return  true if the subsample had another patch
+ */
+
+    inline bool APRT::ClassificationScanner::NextPatch(std::string_view& className)
+      {
+        if (!this->inSubsample)
+          {
+            return (false);
+          }
+        const char* const first = SkipSpace(this->next,this->last);
+        const char* const delimiter = this->fields.Find(first);
+        if (delimiter == this->last)
+          {
+            this->next        = this->last;  // an unterminated class name is discarded
+            this->inSubsample = false;
+            return (false);
+          }
+        const char* end = delimiter;
+        while ((end != first) && IsSpace(*(end - 1)))
+          {
+            --end;
+          }
+        className = std::string_view(first,end - first);
+        if (className.empty())
+          {
+            className = "NONE";
+          }
+        else if (std::find_if(first,end,IsSpace) != end)
+          {
+            this->packed.assign(first,end);
+            this->packed.erase(std::remove_if(this->packed.begin(),this->packed.end(),IsSpace),
+                               this->packed.end());
+            className = this->packed;
+          }
+        if (*delimiter == '<')
+          {
+            this->next        = SkipTerminator(delimiter,this->last);
+            this->inSubsample = false;
+          }
+        else
+          {
+            this->next = delimiter + 1;
+          }
+        return (true);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of the current subsample.
+ *
+ *  @return  the one-based subsample number (zero before the first subsample)
+ */
+
+    inline uint32_t APRT::ClassificationScanner::Subsample() const
+      {
+        return (this->ssn);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of patches left in the current subsample, counted from the field
+ *  delimiters up to its terminating '<', for sizing containers.
+ *
+ *  @return  the patch count (zero for an unterminated subsample)
+ */
+
+    inline size_t APRT::ClassificationScanner::PatchHint() const
+      {
+        if (!this->inSubsample)
+          {
+            return (0);
+          }
+        const char* const terminator = DelimiterScanner::Find(this->next,this->last,'<');
+        return ((terminator != this->last) ?
+                    DelimiterScanner::Count(this->next,terminator,',') + 1 : 0);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns true for the characters skipped by formatted stream extraction.
+ */
+
+    inline bool APRT::ClassificationScanner::IsSpace(const char c)
+      {
+        return (c == ' '  || c == '\t' || c == '\n' ||
+                c == '\v' || c == '\f' || c == '\r');
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the first non-whitespace position in [next,last).
+ */
+
+    inline const char* APRT::ClassificationScanner::SkipSpace(const char* next,
+                                                              const char* const last)
+      {
+        while ((next != last) && IsSpace(*next))
+          {
+            ++next;
+          }
+        return (next);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the position following the subsample terminator '<' at next.  The stream
+ *  iterator used by the stream parser reads one character ahead, so it leaves the
+ *  stream just past the first non-whitespace character that follows the '<'.
+ */
+
+    inline const char* APRT::ClassificationScanner::SkipTerminator(const char* next,
+                                                                   const char* const last)
+      {
+        if (next != last)
+          {
+            next = SkipSpace(next + 1,last);
+            if (next != last)
+              {
+                ++next;
+              }
+          }
+        return (next);
+      }
+
+  #endif
@@ -0,0 +1,90 @@
+/**
+ *  @file  ClassificationTable.cpp
+ *
+ *  @brief  Implementation of the ClassificationTable class.
+ *
+ *  Implementation of the ClassificationTable class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "ClassificationTable.h"
+
+  #include <algorithm>
+
+  #include "ClassificationScanner.h"
+  #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Constructs a ClassificationTable from the acl/pcl file at the given path.
+ *
+ *  @param [in]  path  the acl/pcl file path
+ */
+
+  APRT::ClassificationTable::ClassificationTable(const std::string& path)
+    : offsets(1,0)
+      {
+        this->Parse(path,std::vector<uint32_t>());
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Constructs a ClassificationTable holding only the given subsamples of the acl/pcl
+ *  file at the given path.  The other subsamples are skipped and left empty; the table
+ *  ends at the last requested subsample.
+ *
+ *  @param [in]  path        the acl/pcl file path
+ *  @param [in]  subsamples  the one-based numbers of the subsamples to parse
+ */
+
+  APRT::ClassificationTable::ClassificationTable(const std::string&           path,
+                                                 const std::vector<uint32_t>& subsamples)
+    : offsets(1,0)
+      {
+        assert(!subsamples.empty());
+        this->Parse(path,subsamples);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps an acl/pcl file and interns the classes of the requested subsamples.
+ *
+ *  @param [in]  path        the acl/pcl file path
+ *  @param [in]  subsamples  the subsamples to parse (all of them if empty)
+ */
+
+  void APRT::ClassificationTable::Parse(const std::string&           path,
+                                        const std::vector<uint32_t>& subsamples)
+    {
+      const MappedFile file(path);
+      ClassificationScanner scanner(file.Begin(),file.End());
+      const uint32_t stop = subsamples.empty() ?
+                                UINT32_MAX :
+                                *std::max_element(subsamples.begin(),subsamples.end());
+//
+//  Intern each <CLASS> block in the mapping (leaving unrequested blocks empty) ...
+//
+      while ((scanner.Subsample() < stop) && scanner.NextSubsample())
+        {
+          if (subsamples.empty() ||
+              (std::find(subsamples.begin(),subsamples.end(),scanner.Subsample()) != subsamples.end()))
+            {
+              std::string_view className;
+              while (scanner.NextPatch(className))
+                {
+                  this->labels.push_back(ClassVocabulary::Intern(className));
+                }
+            }
+          this->offsets.push_back(this->labels.size());
+        }
+    }
@@ -0,0 +1,180 @@
+/**
+ *  @file  ClassificationTable.h
+ *
+ *  @brief  Definition of the ClassificationTable class.
+ *
+ *  Definition of the ClassificationTable class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CLASSIFICATION_TABLE_H_INCLUDED
+    #define APRT_CLASSIFICATION_TABLE_H_INCLUDED
+
+    #include <string>
+    #include <utility>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  A view of the interned classes of one subsample, indexed by patch index.
+ */
+
+        struct LabelSpan
+          {
+            const ClassId*  begin() const               { return (this->first);            }
+            const ClassId*  end() const                 { return (this->last);             }
+            size_t          size() const                { return (this->last - this->first); }
+            ClassId         operator [] (size_t i) const { return (this->first[i]);         }
+            const ClassId*  first;  /**< @brief  the class of patch 0        */
+            const ClassId*  last;   /**< @brief  one past the last patch      */
+          };
+
+/**
+ *  The columnar counterpart of ClassificationList: the interned classes of all the
+ *  subsamples of an acl/pcl file stored contiguously, one byte per patch, with the
+ *  subsample boundaries kept as offsets.  The patch index of a class is its position
+ *  within its subsample.
+ */
+
+        class ClassificationTable
+          {
+            public:
+              ClassificationTable();
+              explicit ClassificationTable(const std::string& path);
+              ClassificationTable(const std::string&           path,
+                                  const std::vector<uint32_t>& subsamples);
+              ClassificationTable(std::vector<ClassId>  labels,
+                                  std::vector<uint64_t> offsets);
+
+            public:
+              uint32_t   Subsamples() const;
+              LabelSpan  Subsample(uint32_t ssn) const;
+              const std::vector<ClassId>&   Labels() const;
+              const std::vector<uint64_t>&  Offsets() const;
+            private:
+              void  Parse(const std::string&           path,
+                          const std::vector<uint32_t>& subsamples);
+            private:
+              std::vector<ClassId>   labels;
+                /**< @brief  the classes of all the patches, subsample by subsample */
+              std::vector<uint64_t>  offsets;
+                /**< @brief  the start of each subsample in labels, plus the end */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates an empty ClassificationTable.
+ */
+
+    inline APRT::ClassificationTable::ClassificationTable()
+      : offsets(1,0)
+          {
+            ;
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a ClassificationTable from its columns (as saved by a ClassificationCache).
+ *
+ *  @param [in]  labels   the classes of all the patches, subsample by subsample
+ *  @param [in]  offsets  the start of each subsample in labels, plus the end
+ */
+
+    inline APRT::ClassificationTable::ClassificationTable(std::vector<ClassId>  labels,
+                                                          std::vector<uint64_t> offsets)
+      : labels(std::move(labels)),
+        offsets(std::move(offsets))
+          {
+            assert(!this->offsets.empty() && (this->offsets.back() == this->labels.size()));
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of subsamples in the table.
+ *
+ *  @return  the number of subsamples
+ */
+
+    inline uint32_t APRT::ClassificationTable::Subsamples() const
+      {
+        return (uint32_t(this->offsets.size() - 1));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the classes of the patches of a subsample.  A subsample beyond the end of the
+ *  table is empty.
+ *
+ *  @param [in]  ssn  the one-based subsample number
+ *
+ *  @return  the classes, indexed by patch index
+ */
+
+    inline APRT::LabelSpan APRT::ClassificationTable::Subsample(const uint32_t ssn) const
+      {
+        assert(ssn != 0);
+        const ClassId* const base = this->labels.data();
+        if (ssn > this->Subsamples())
+          {
+            return (LabelSpan{base,base});
+          }
+        return (LabelSpan{base + this->offsets[ssn - 1],base + this->offsets[ssn]});
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the classes of all the patches, subsample by subsample.
+ *
+ *  @return  the label column
+ */
+
+    inline const std::vector<APRT::ClassId>& APRT::ClassificationTable::Labels() const
+      {
+        return (this->labels);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the start of each subsample in Labels(), plus the end.
+ *
+ *  @return  the offset column
+ */
+
+    inline const std::vector<uint64_t>& APRT::ClassificationTable::Offsets() const
+      {
+        return (this->offsets);
+      }
+
+  #endif
@@ -1,311 +1,62 @@
 /**
- *  @file  PatchExtractor.cpp
+ *  @file  CompareList.cpp
  *
- *  @brief  Implementation of the PatchExtractor.
+ *  @brief  The CompareList command-line program.
  *
- *  Implementation of the PatchExtractor.  The PatchExtractor is a command-line program
- *  for extracting and correcting patches from a runfile into a desired directory. It
- *  operates in two modes. In the first mode, the expert classification file is not used
- *  and all the patches in each runfile are extracted to a directory created specifically
- *  for that runfile.  The second mode uses the expert classification file.  All the
- *  patches that belong to a particular class are extracted to a directory for that class
- *  regardless of the runfile from which the patch originated.  In the first mode, there
- *  is a directory for each runfile, so the labeling of patches only reflects their
- *  positions within their source runfile.  In the second mode, all the patches of a
- *  given class are stored together in one directory, so the labeling of the patches
- *  reflects the runfiles from which the patches come.
+ *  The CompareList command-line program.  It compares the apr (.pcl) and user (.acl)
+ *  classifications of a subsample of each runfile on a runfile list with a
+ *  PatchExtractor and appends the confusion matrix of each runfile to the
+ *  ConfusionMatrix.txt file in the destination directory.
  *
  *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
  */
 
-  #include <ISL/APR/Runfile.h>
-  #include <ISL/APR/Particle.h>
-  #include <ISL/APR/Features.h>
-  #include <ISL/APR/Calculators.h>
-
-  #include <ISL/Image/BayerImage.h>
-  #include <ISL/Image/Debayering.h>
-  #include <ISL/Image/DirectImage.h>
-  #include <ISL/Image/GrayscaleImage.h>
-  #include <ISL/Image/RGB_Image.h>
-  #include <ISL/Math/Matrix.h>
-
-  #include <boost/filesystem.hpp>
+  #include <boost/lexical_cast.hpp>
 
+  #include <algorithm>
   #include <iostream>
-  #include <iomanip>
-
-  #include "ClassificationList.h"
-
-
-//-----------------------------------------------------------------------------------------------
-//-----------------------------------------------------------------------------------------------
-
-    namespace APRT
-      {
-
-/**
- *  @brief  A class for extracting patches from runfiles and storing the patches in
- *          directories corresponding to either their runfiles or their patch
- *          classifications.
- */
+  #include <stdexcept>
+  #include <string>
+  #include <vector>
 
-        class PatchExtractor
-          {
-            public:
-              PatchExtractor(const std::string destination,
-                             const uint8_t     sample);
-                /**< @brief  creates a PatchExtractor for a
-                             runfilelist and subsample number */
-
-            public:
-              void  Sort(const std::string runfilelist);
-                /**< @brief  a driver function used to iterate through a
-                             runfile list to extract all the patches of a specific
-                             classification to a single directory for that type of
-                             patch, ideal for optimizing classifiers and feature
-                             generators over particular classes/types of patches */
-
-            private:
-              void  WriteSort(const std::string runfilename);
-                /**< @brief  a worker function that writes the contents of a
-                             runfile to directories created for their patch types */
-
-            private:
-              std::string  outputdirectory;
-                /**< @brief  the output directory containing images */
-              std::string  inputdirectory;
-                /**< @brief  the input directory containing runfiles */
-              const uint8_t subsamplenumber;
-                /**< @brief  the runfile subsample (stream) to write */
-          };
-
-/**
- *  @brief  An external function to create and run a PatchExtractor to write particles
- *          contained in all the runfiles listed on a runfilelist into directories
- *          associated created for their particle types.
- */
+  #include <cstdlib>
 
-        void Sort(const std::string runfilelist,
-                  const std::string destination,
-                  const uint8_t     sample);
-      }
+  #include "DisagreementIndex.h"
+  #include "PatchExtractor.h"
 
 
 //-----------------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------------
 
-/**
- *  Creates an APRT::PatchExtractor object for extracting patches contained in runfiles
- *  listed on a runfilelist to either their respective expert classification folders or
- *  to a single folder for each runfile on the list.
- *
- *  @param [in]  destination  the output destination
- *  @param [in]  runfilelist  the subsample number
- */
-
-  APRT::PatchExtractor::PatchExtractor(const std::string destination,
-                                       const uint8_t     sample)
-   : outputdirectory(destination),
-     subsamplenumber(sample)
+    namespace
       {
-        ;
-      }
-
-
-//-----------------------------------------------------------------------------------------------
-//-----------------------------------------------------------------------------------------------
 
 /**
- *  A driver function used to iterate through a runfile list to extract all the patches
- *  of a specific classification to a single directory for that type of patch. This form
- *  of output is ideal for optimizing classifiers and feature generators over particular
- *  classes/types of patches.
+ *  Parses a subsample number, which runs from 1 to 255 (0 stands for every subsample,
+ *  so it is only given as "all").
  *
- *  @param [in]  runfilelist  the input list of runfiles
- */
-
-  void APRT::PatchExtractor::Sort(const std::string runfilelist)
-    {
-//
-//  Read the input list of runfiles ...
-//
-      std::ifstream runfileliststream(runfilelist.c_str());
-//
-//  Get the output runfile directory ...
-//
-      std::getline(runfileliststream,this->inputdirectory);
-//
-//  Process each listed runfile in turn ...
-//
-      while (!runfileliststream.eof())
-        {
-//
-//  Get the runfilename to process ...
-//
-          std::string nextline;
-          std::getline(runfileliststream,nextline);
-          std::cout << "Processing -> "
-                    << nextline.c_str()
-                    << std::endl;
-          this->WriteSort(nextline.c_str());
-        }
-    }
-
-
-//-----------------------------------------------------------------------------------------------
-//-----------------------------------------------------------------------------------------------
-
-/**
- *  A worker function that writes the contents of a runfile to directories common to their
- *  patch types. This is ideal for optimizing the features and classifiers on all the
- *  particles of a particular class contained in a group of runfiles.
+ *  @param [in]  argument  the subsample argument
  *
- *  @param [in]  runfilename  the input runfile name
- */
-
-  void APRT::PatchExtractor::WriteSort(const std::string runfilename)
-    {
-//
-//  Read the classification file ...
-//
-      std::ifstream
-          pclfilestream((this->inputdirectory +
-                         runfilename +
-                         ".pcl").c_str(),
-                        std::ios_base::in);
-      APRT::ClassificationList
-          pclpatchlist = ClassificationList(pclfilestream);
-
-	  std::ifstream
-          aclfilestream((this->inputdirectory +
-                         runfilename +
-                         ".acl").c_str(),
-                        std::ios_base::in);
-      APRT::ClassificationList
-          aclpatchlist = ClassificationList(aclfilestream);
-//
-//  Schedule the particles in the runfile subsample in turn ...
-//
-	  ISL::Math::Matrix<int32_t,2> conmatrix(26,26);
-      uint32_t count = 0;
-      while ((count < pclpatchlist.Classifications()[this->subsamplenumber-1].size()) &&
-		     (count < aclpatchlist.Classifications()[this->subsamplenumber-1].size()))
-        {
-          std::string pclclassification =
-              std::string(pclpatchlist.Classifications()[this->subsamplenumber-1][count].classification);
-		  std::string aclclassification =
-              std::string(aclpatchlist.Classifications()[this->subsamplenumber-1][count].classification);
-		  uint32_t pclindex = 25,aclindex = 25;
-		  if (pclclassification.compare("RBC") == 0) pclindex = 0;
-		  else if (pclclassification.compare("DRBC") == 0) pclindex = 1;
-		  else if (pclclassification.compare("RBCC") == 0) pclindex = 2;
-		  else if (pclclassification.compare("WBC") == 0)  pclindex = 3;
-		  else if (pclclassification.compare("WBCC") == 0) pclindex = 4;
-		  else if (pclclassification.compare("BACT") == 0) pclindex = 5;
-		  else if (pclclassification.compare("SQEP") == 0) pclindex = 6;
-		  else if (pclclassification.compare("NSE") == 0)  pclindex = 7;
-		  else if (pclclassification.compare("TREP") == 0) pclindex = 8;
-		  else if (pclclassification.compare("REEP") == 0) pclindex = 9;
-		  else if (pclclassification.compare("CAOX") == 0) pclindex = 10;
-		  else if (pclclassification.compare("URIC") == 0) pclindex = 11;
-		  else if (pclclassification.compare("TPO4") == 0) pclindex = 12;
-		  else if (pclclassification.compare("CAPH") == 0) pclindex = 13;
-		  else if (pclclassification.compare("CYST") == 0) pclindex = 14;
-		  else if (pclclassification.compare("LEUC") == 0) pclindex = 15;
-		  else if (pclclassification.compare("AMOR") == 0) pclindex = 16;
-		  else if (pclclassification.compare("CELL") == 0) pclindex = 17;
-		  else if (pclclassification.compare("GRAN") == 0) pclindex = 18;
-		  else if (pclclassification.compare("MUCS") == 0) pclindex = 19;
-		  else if (pclclassification.compare("SPRM") == 0) pclindex = 20;
-		  else if (pclclassification.compare("BYST") == 0) pclindex = 21;
-		  else if (pclclassification.compare("HYST") == 0) pclindex = 22;
-		  else if (pclclassification.compare("TRCH") == 0) pclindex = 23;
-		  else if (pclclassification.compare("BUBB") == 0) pclindex = 24;
-		  else if (pclclassification.compare("NONE") == 0) pclindex = 25;
-
-		  if (aclclassification.compare("RBC") == 0) aclindex = 0;
-		  else if (aclclassification.compare("DRBC") == 0) aclindex = 1;
-		  else if (aclclassification.compare("RBCC") == 0) aclindex = 2;
-		  else if (aclclassification.compare("WBC") == 0)  aclindex = 3;
-		  else if (aclclassification.compare("WBCC") == 0) aclindex = 4;
-		  else if (aclclassification.compare("BACT") == 0) aclindex = 5;
-		  else if (aclclassification.compare("SQEP") == 0) aclindex = 6;
-		  else if (aclclassification.compare("NSE") == 0)  aclindex = 7;
-		  else if (aclclassification.compare("TREP") == 0) aclindex = 8;
-		  else if (aclclassification.compare("REEP") == 0) aclindex = 9;
-		  else if (aclclassification.compare("CAOX") == 0) aclindex = 10;
-		  else if (aclclassification.compare("URIC") == 0) aclindex = 11;
-		  else if (aclclassification.compare("TPO4") == 0) aclindex = 12;
-		  else if (aclclassification.compare("CAPH") == 0) aclindex = 13;
-		  else if (aclclassification.compare("CYST") == 0) aclindex = 14;
-		  else if (aclclassification.compare("LEUC") == 0) aclindex = 15;
-		  else if (aclclassification.compare("AMOR") == 0) aclindex = 16;
-		  else if (aclclassification.compare("CELL") == 0) aclindex = 17;
-		  else if (aclclassification.compare("GRAN") == 0) aclindex = 18;
-		  else if (aclclassification.compare("MUCS") == 0) aclindex = 19;
-		  else if (aclclassification.compare("SPRM") == 0) aclindex = 20;
-		  else if (aclclassification.compare("BYST") == 0) aclindex = 21;
-		  else if (aclclassification.compare("HYST") == 0) aclindex = 22;
-		  else if (aclclassification.compare("TRCH") == 0) aclindex = 23;
-		  else if (aclclassification.compare("BUBB") == 0) aclindex = 24;
-		  else if (aclclassification.compare("NONE") == 0) aclindex = 25;
-		  ++conmatrix(pclindex,aclindex); 
-          ++count;
-        }
-	   std::string basefolder =
-          std::string(this->outputdirectory + "/");
-      boost::filesystem::path base(basefolder);
-	  std::ostringstream confile;
-          confile
-              << basefolder
-              << "ConfusionMatrix.txt";
-             
-	  FILE *fp = fopen(confile.str().c_str(),"a+");
-	  for (uint32_t i = 0; i < conmatrix.Dim1(); ++i)
-	  {
-		  for (uint32_t j = 0; j < conmatrix.Dim2(); ++j)
-		  {
-			  fprintf(fp,"%d\t",conmatrix(i,j)); 
-		  }
-		  fprintf(fp,"\n");
-	  }
-	  
-	  fclose(fp);
-    }
-
-
-//-----------------------------------------------------------------------------------------------
-//-----------------------------------------------------------------------------------------------
-
-/**
- *  An external function to create and run a PatchExtractor to write particles
- *  contained in all the runfiles listed on a runfilelist into directories associated
- *  created for their particle types. This is ideal for opitmizing a feature selector
- *  or classifier over images of particular types/classes obtained from a collection
- *  of runfiles in a runfilelist.
+ *  @return  the subsample number
  *
- *  @param [in]  runfilelist  the list of runfiles to extract
- *  @param [in]  destination  the output image directory
- *  @param [in]  sample       the runfile sample number of interest
+ *  @throw  boost::bad_lexical_cast  for anything but a decimal number from 1 to 255
  */
 
-  void APRT::Sort(const std::string runfilelist,
-                  const std::string destination,
-                  const uint8_t     sample)
-    {
-//
-//  Extract the patches contained in the runfile listed in the runfilelist
-//  into the output image directories ...
-//
-      PatchExtractor extractor = PatchExtractor(destination,sample);
-      extractor.Sort(runfilelist);
-//
-//  Characterize the contents of the output directories ...
-//
-      /* Skipped for now.  This would produce the "Runfile List
-         Statistics Report" file. */
-    }
+        uint32_t ParseSubsample(const std::string& argument)
+          {
+            if (argument.empty() ||
+                !std::all_of(argument.begin(),argument.end(),[](const char c) { return ((c >= '0') && (c <= '9')); }))
+              {
+                throw boost::bad_lexical_cast();
+              }
+            const uint32_t subsample = boost::lexical_cast<uint32_t>(argument);
+            if ((subsample < 1) || (subsample > 255))
+              {
+                throw boost::bad_lexical_cast();
+              }
+            return (subsample);
+          }
+      }
 
 
 //-----------------------------------------------------------------------------------------------
@@ -314,34 +65,154 @@
 /**
  *  The main entry point to the program.
  *
+ *    CompareList runfilelist destination subsample [--jobs N] [--prefetch K] [--cache DIR]
+ *                [--open-taxonomy] [--subsample-jobs N] [--candidate DIR]...
+ *                [--candidate-jobs N] [--disagreements] [--metrics]
+ *    CompareList runfilelist destination subsample --extract class|runfile|packed|tensor|features
+ *                [--jobs N] [--particle-jobs N] [--patch-size N] [--cache DIR]
+ *    CompareList --find index pcl acl
+ *
+ *  A subsample of "all" compares every subsample of each runfile in one pass.  Each
+ *  --candidate names a directory of apr (.pcl) files to compare, instead of those of the
+ *  runfile list, against the user classifications of the runfile list.  --disagreements
+ *  also writes every patch whose classes differ to Disagreements.idx in the destination;
+ *  --find lists the runfile, subsample and patch index of the patches of one (pcl,acl)
+ *  cell of such an index.  --metrics reports the accuracy, F1 and kappa of each runfile
+ *  and of the runfiles so far as they are written, and writes the totals (with the
+ *  per-class scores) to Metrics.txt in the destination at the end.  --extract writes the debayered patches of the subsample into a
+ *  directory per user class (or per runfile, or packed into one container file per user
+ *  class, or fitted into one labelled tensor of --patch-size square patches) instead of
+ *  comparing; --extract features measures the particles into one feature store instead.
+ *  Both need a ParticleSource decoding the runfiles, which this program does not link,
+ *  so here they report an error.
+ *
  *  @param [in]  argc  the number of input arguments
  *  @param [in]  argv  the strings of input arguments
  *
- *  @return  EXIT_FAILURE (upon an exception or forced termination)
+ *  @return  EXIT_SUCCESS, or EXIT_FAILURE (upon an exception or forced termination)
  */
 
   int main(int argc, char* argv[])
     {
       try
         {
-          //if (argc == 5)
+//
+//  Separate the options from the positional arguments ...
+//
+          std::vector<std::string> arguments;
+          std::vector<std::string> query;
+          APRT::SortOptions options;
+          for (int i = 1; i < argc; ++i)
             {
-              const std::string runfilelist = "E:/rundata/runfile.txt";//argv[1];
-              const std::string destination = "D:/Dataout/";//argv[2];
-              const int         subsample   = 1;//std::atoi(argv[3]);
+              const std::string argument(argv[i]);
+              if ((argument == "--jobs") && (i + 1 < argc))
+                {
+                  options.jobs = boost::lexical_cast<uint32_t>(argv[++i]);
+                }
+              else if ((argument == "--prefetch") && (i + 1 < argc))
+                {
+                  options.prefetch = boost::lexical_cast<uint32_t>(argv[++i]);
+                }
+              else if ((argument == "--cache") && (i + 1 < argc))
+                {
+                  options.cache = argv[++i];
+                }
+              else if (argument == "--open-taxonomy")
+                {
+                  options.open = true;
+                }
+              else if ((argument == "--subsample-jobs") && (i + 1 < argc))
+                {
+                  options.subsamplejobs = boost::lexical_cast<uint32_t>(argv[++i]);
+                }
+              else if ((argument == "--candidate") && (i + 1 < argc))
+                {
+                  options.candidates.push_back(argv[++i]);
+                }
+              else if ((argument == "--candidate-jobs") && (i + 1 < argc))
+                {
+                  options.candidatejobs = boost::lexical_cast<uint32_t>(argv[++i]);
+                }
+              else if (argument == "--disagreements")
+                {
+                  options.disagreements = true;
+                }
+              else if (argument == "--metrics")
+                {
+                  options.metrics = true;
+                }
+              else if ((argument == "--extract") && (i + 1 < argc))
+                {
+                  const std::string layout(argv[++i]);
+                  if ((layout != "class") && (layout != "runfile") && (layout != "packed") && (layout != "tensor") &&
+                      (layout != "features"))
+                    {
+                      throw boost::bad_lexical_cast();
+                    }
+                  options.extract = (layout == "class")   ? APRT::PatchLayout::ByClass   :
+                                    (layout == "runfile") ? APRT::PatchLayout::ByRunfile :
+                                    (layout == "packed")  ? APRT::PatchLayout::Packed    :
+                                    (layout == "tensor")  ? APRT::PatchLayout::Tensor    :
+                                                            APRT::PatchLayout::Features;
+                }
+              else if ((argument == "--particle-jobs") && (i + 1 < argc))
+                {
+                  options.particlejobs = boost::lexical_cast<uint32_t>(argv[++i]);
+                }
+              else if ((argument == "--patch-size") && (i + 1 < argc))
+                {
+                  options.patchsize = boost::lexical_cast<uint32_t>(argv[++i]);
+                }
+              else if ((argument == "--find") && (i + 3 < argc))
+                {
+                  query.assign(argv + i + 1,argv + i + 4);
+                  i += 3;
+                }
+              else
+                {
+                  arguments.push_back(argument);
+                }
+            }
+          if ((query.size() == 3) && arguments.empty())
+            {
+              const APRT::DisagreementIndex index(query[0]);
+              for (const APRT::Disagreement& disagreement : index.Find(query[1],query[2]))
+                {
+                  std::cout << index.Runfile(disagreement.runfile)
+                            << '\t'
+                            << disagreement.subsample
+                            << '\t'
+                            << disagreement.patch
+                            << '\n';
+                }
+              return (EXIT_SUCCESS);
+            }
+          else if (arguments.size() == 3)
+            {
+              const std::string runfilelist = arguments[0];
+              const std::string destination = arguments[1];
+              const bool        all         = (arguments[2] == "all");
+              const uint32_t    subsample   = all ? 0 : ParseSubsample(arguments[2]);
+              options.allsubsamples = all;
 
               std::cout << "Readying "
                         << runfilelist
                         << " for processing."
                         << std::endl;
-              APRT::Sort(runfilelist,destination,subsample);
+              APRT::Sort(runfilelist,destination,uint8_t(subsample),options);
+              return (EXIT_SUCCESS);
             }
-          //else
+          else
             {
               std::cout << "Invalid argument list. Try again." << std::endl;
             }
         }
 
+      catch (const boost::bad_lexical_cast&)
+        {
+          std::cout << "Invalid argument list. Try again." << std::endl;
+        }
+
       catch (const std::runtime_error& e)
         {
           std::cout << e.what() << std::endl;
@@ -355,11 +226,3 @@
 
       return (EXIT_FAILURE);
     }
-
-
-
-
-              
-
-
-
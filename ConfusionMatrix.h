@@ -0,0 +1,157 @@
+/**
+ *  @file  ConfusionMatrix.h
+ *
+ *  @brief  Definition of the ConfusionMatrix class.
+ *
+ *  Definition of the ConfusionMatrix class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CONFUSION_MATRIX_H_INCLUDED
+    #define APRT_CONFUSION_MATRIX_H_INCLUDED
+
+    #include <algorithm>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  A count of patches by apr (row) and user (column) classification over a taxonomy of N
+ *  classes (by default the ClassVocabulary of the build).  The counts are held in the
+ *  matrix itself, so the size is fixed at compile time and the indexing needs no
+ *  multiply by a run-time stride.  The matrix is aligned to a cache line so that the
+ *  matrices of concurrent workers never share one.
+ *
+ *  @tparam  N  the number of classes
+ */
+
+        template <uint32_t N = ClassVocabulary::Size>
+          class alignas(64) ConfusionMatrix
+            {
+              public:
+                ConfusionMatrix();
+
+              public:
+                int32_t&  operator () (uint32_t pcl, uint32_t acl);
+                int32_t   operator () (uint32_t pcl, uint32_t acl) const;
+                ConfusionMatrix&
+                          operator += (const ConfusionMatrix& other);
+                uint32_t  Dim1() const;
+                uint32_t  Dim2() const;
+              private:
+                int32_t cells[N][N];
+                  /**< @brief  the counts, indexed by [pcl][acl] */
+            };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a ConfusionMatrix with all counts zero.
+ */
+
+    template <uint32_t N>
+      inline APRT::ConfusionMatrix<N>::ConfusionMatrix()
+        {
+          std::fill(&this->cells[0][0],&this->cells[0][0] + N*N,0);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the count of patches with the given classifications.
+ *
+ *  @param [in]  pcl  the apr classification
+ *  @param [in]  acl  the user classification
+ *
+ *  @return  the count
+ */
+
+    template <uint32_t N>
+      inline int32_t& APRT::ConfusionMatrix<N>::operator () (const uint32_t pcl,
+                                                             const uint32_t acl)
+        {
+          assert((pcl < N) && (acl < N));
+          return (this->cells[pcl][acl]);
+        }
+
+    template <uint32_t N>
+      inline int32_t APRT::ConfusionMatrix<N>::operator () (const uint32_t pcl,
+                                                            const uint32_t acl) const
+        {
+          assert((pcl < N) && (acl < N));
+          return (this->cells[pcl][acl]);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the counts of another matrix to this one.
+ *
+ *  @param [in]  other  the matrix to add
+ *
+ *  @return  this matrix
+ */
+
+    template <uint32_t N>
+      inline APRT::ConfusionMatrix<N>&
+        APRT::ConfusionMatrix<N>::operator += (const ConfusionMatrix& other)
+          {
+            std::transform(&this->cells[0][0],
+                           &this->cells[0][0] + N*N,
+                           &other.cells[0][0],
+                           &this->cells[0][0],
+                           [](const int32_t a, const int32_t b) { return (a + b); });
+            return (*this);
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of rows (apr classes).
+ *
+ *  @return  the number of rows
+ */
+
+    template <uint32_t N>
+      inline uint32_t APRT::ConfusionMatrix<N>::Dim1() const
+        {
+          return (N);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of columns (user classes).
+ *
+ *  @return  the number of columns
+ */
+
+    template <uint32_t N>
+      inline uint32_t APRT::ConfusionMatrix<N>::Dim2() const
+        {
+          return (N);
+        }
+
+  #endif
@@ -0,0 +1,176 @@
+/**
+ *  @file  ConfusionTensor.h
+ *
+ *  @brief  Definition of the ConfusionTensor class.
+ *
+ *  Definition of the ConfusionTensor class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CONFUSION_TENSOR_H_INCLUDED
+    #define APRT_CONFUSION_TENSOR_H_INCLUDED
+
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ConfusionMatrix.h"
+    #include "PatchCounts.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The confusion matrices of every subsample of a runfile, indexed [subsample][pcl][acl],
+ *  with the number of patches each input had in each subsample.  Subsamples are numbered
+ *  from one, as elsewhere; the tensor grows to the subsamples it is given.
+ */
+
+        class ConfusionTensor
+          {
+            public:
+              ConfusionTensor();
+
+            public:
+              ConfusionMatrix<>&        operator () (uint32_t ssn);
+              const ConfusionMatrix<>&  operator () (uint32_t ssn) const;
+              PatchCounts&              Counts(uint32_t ssn);
+              const PatchCounts&        Counts(uint32_t ssn) const;
+              ConfusionTensor&          operator += (const ConfusionTensor& other);
+              void                      Resize(uint32_t subsamples);
+              uint32_t                  Subsamples() const;
+            private:
+              std::vector<ConfusionMatrix<> >  matrices;
+                /**< @brief  the confusion matrix of each subsample */
+              std::vector<PatchCounts>         counts;
+                /**< @brief  the patch counts of each subsample */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a ConfusionTensor with no subsamples.
+ */
+
+    inline APRT::ConfusionTensor::ConfusionTensor()
+      {
+        ;
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the confusion matrix of a subsample.
+ *
+ *  @param [in]  ssn  the one-based subsample number
+ *
+ *  @return  the confusion matrix
+ */
+
+    inline APRT::ConfusionMatrix<>& APRT::ConfusionTensor::operator () (const uint32_t ssn)
+      {
+        assert((ssn != 0) && (ssn <= this->Subsamples()));
+        return (this->matrices[ssn - 1]);
+      }
+
+    inline const APRT::ConfusionMatrix<>& APRT::ConfusionTensor::operator () (const uint32_t ssn) const
+      {
+        assert((ssn != 0) && (ssn <= this->Subsamples()));
+        return (this->matrices[ssn - 1]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the patch counts of a subsample.
+ *
+ *  @param [in]  ssn  the one-based subsample number
+ *
+ *  @return  the patch counts
+ */
+
+    inline APRT::PatchCounts& APRT::ConfusionTensor::Counts(const uint32_t ssn)
+      {
+        assert((ssn != 0) && (ssn <= this->Subsamples()));
+        return (this->counts[ssn - 1]);
+      }
+
+    inline const APRT::PatchCounts& APRT::ConfusionTensor::Counts(const uint32_t ssn) const
+      {
+        assert((ssn != 0) && (ssn <= this->Subsamples()));
+        return (this->counts[ssn - 1]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the matrices and counts of another tensor to this one, subsample by subsample,
+ *  first growing this one to the subsamples of the other if it has fewer.
+ *
+ *  @param [in]  other  the tensor to add
+ *
+ *  @return  this tensor
+ */
+
+    inline APRT::ConfusionTensor& APRT::ConfusionTensor::operator += (const ConfusionTensor& other)
+      {
+        this->Resize(other.Subsamples());
+        for (uint32_t ssn = 1; ssn <= other.Subsamples(); ++ssn)
+          {
+            (*this)(ssn) += other(ssn);
+            this->Counts(ssn) += other.Counts(ssn);
+          }
+        return (*this);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Grows the tensor to at least the given number of subsamples, the new ones empty.
+ *
+ *  @param [in]  subsamples  the number of subsamples
+ */
+
+    inline void APRT::ConfusionTensor::Resize(const uint32_t subsamples)
+      {
+        if (subsamples > this->Subsamples())
+          {
+            this->matrices.resize(subsamples);
+            this->counts.resize(subsamples,PatchCounts{0,0});
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of subsamples in the tensor.
+ *
+ *  @return  the number of subsamples
+ */
+
+    inline uint32_t APRT::ConfusionTensor::Subsamples() const
+      {
+        return (uint32_t(this->matrices.size()));
+      }
+
+  #endif
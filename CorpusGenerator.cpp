@@ -0,0 +1,216 @@
+/**
+ *  @file  CorpusGenerator.cpp
+ *
+ *  @brief  Implementation of the CorpusGenerator class.
+ *
+ *  Implementation of the CorpusGenerator class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "CorpusGenerator.h"
+
+  #include <boost/algorithm/string.hpp>
+  #include <boost/lexical_cast.hpp>
+
+  #include <algorithm>
+  #include <fstream>
+  #include <stdexcept>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a CorpusGenerator for the given corpus shape.
+ *
+ *  @param [in]  options  the corpus shape
+ */
+
+  APRT::CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : options(options),
+      engine(options.seed)
+      {
+        assert(options.weights.size() == ClassVocabulary::None);
+        double sum = 0.0;
+        for (const double weight : options.weights)
+          {
+            this->cumulative.push_back(sum += weight);
+          }
+        if (sum <= 0.0)
+          {
+            throw std::runtime_error("The class weights must not all be zero.");
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes a synthetic acl file and the matching pcl file.  Each file starts with a
+ *  non-<CLASS> header line, then holds one <CLASS> block per subsample.  A pcl label
+ *  agrees with its acl label at the configured rate and is otherwise drawn afresh.
+ *
+ *  @param [in]  aclpath  the acl file to write
+ *  @param [in]  pclpath  the pcl file to write
+ *
+ *  @return  the number of patches written to each file
+ */
+
+  uint64_t APRT::CorpusGenerator::Write(const std::string& aclpath,
+                                        const std::string& pclpath)
+    {
+      std::ofstream aclstream(aclpath.c_str(),std::ios_base::binary);
+      std::ofstream pclstream(pclpath.c_str(),std::ios_base::binary);
+      if (!aclstream || !pclstream)
+        {
+          throw std::runtime_error("Unable to create " + aclpath + " or " + pclpath + ".");
+        }
+      std::string aclbuffer = "<HEADER>synthetic corpus</HEADER>\n";
+      std::string pclbuffer = aclbuffer;
+      const size_t chunk = size_t(1) << 20;
+//
+//  Write each subsample in turn ...
+//
+      for (uint32_t ssn = 0; ssn < this->options.subsamples; ++ssn)
+        {
+          aclbuffer += "<CLASS>";
+          pclbuffer += "<CLASS>";
+          for (uint64_t index = 0; index < this->options.patches; ++index)
+            {
+              if (index != 0)
+                {
+                  const char* separator = ",";
+                  if ((this->options.wrap != 0) && ((index % this->options.wrap) == 0))
+                    {
+                      separator = ",\n";
+                    }
+                  else if (this->options.spaced)
+                    {
+                      separator = ", ";
+                    }
+                  aclbuffer += separator;
+                  pclbuffer += separator;
+                }
+              const ClassId acl = this->Draw();
+              const ClassId pcl = (this->Uniform() < this->options.agreement) ?
+                                      acl : this->Draw();
+              if (acl != ClassVocabulary::None)
+                {
+                  aclbuffer += ClassVocabulary::Code(acl);
+                }
+              if (pcl != ClassVocabulary::None)
+                {
+                  pclbuffer += ClassVocabulary::Code(pcl);
+                }
+              if (aclbuffer.size() >= chunk)
+                {
+                  aclstream.write(aclbuffer.data(),aclbuffer.size());
+                  aclbuffer.clear();
+                }
+              if (pclbuffer.size() >= chunk)
+                {
+                  pclstream.write(pclbuffer.data(),pclbuffer.size());
+                  pclbuffer.clear();
+                }
+            }
+          aclbuffer += "</CLASS>\n";
+          pclbuffer += "</CLASS>\n";
+        }
+      aclstream.write(aclbuffer.data(),aclbuffer.size());
+      pclstream.write(pclbuffer.data(),pclbuffer.size());
+      if (!aclstream || !pclstream)
+        {
+          throw std::runtime_error("Unable to write " + aclpath + " or " + pclpath + ".");
+        }
+
+      return (this->options.patches*this->options.subsamples);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the class weights for a named distribution: "uniform", "zipf" (weight 1/k for
+ *  the k-th class, so RBC dominates) or a list of CODE:WEIGHT pairs such as
+ *  "RBC:50,WBC:20,BACT:5" (unlisted classes get no weight).
+ *
+ *  @param [in]  distribution  the distribution
+ *
+ *  @return  the weight of each class, indexed by ClassId
+ */
+
+  std::vector<double> APRT::CorpusGenerator::Weights(const std::string& distribution)
+    {
+      std::vector<double> weights(ClassVocabulary::None,0.0);
+      if (distribution == "uniform")
+        {
+          std::fill(weights.begin(),weights.end(),1.0);
+        }
+      else if (distribution == "zipf")
+        {
+          for (uint32_t id = 0; id < weights.size(); ++id)
+            {
+              weights[id] = 1.0/(id + 1);
+            }
+        }
+      else
+        {
+          std::vector<std::string> pairs;
+          boost::split(pairs,distribution,boost::is_any_of(","));
+          for (const std::string& pair : pairs)
+            {
+              const std::string::size_type colon = pair.find(':');
+              const ClassId id = ClassVocabulary::Intern(pair.substr(0,colon));
+              if ((colon == std::string::npos) || (id == ClassVocabulary::None))
+                {
+                  throw std::runtime_error("Invalid class distribution " + distribution + ".");
+                }
+              weights[id] = boost::lexical_cast<double>(pair.substr(colon + 1));
+            }
+        }
+
+      return (weights);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Draws a class: None at the configured empty-field rate, otherwise a class drawn from
+ *  the class weights.
+ *
+ *  @return  the class
+ */
+
+  APRT::ClassId APRT::CorpusGenerator::Draw()
+    {
+      if (this->Uniform() < this->options.noneRate)
+        {
+          return (ClassVocabulary::None);
+        }
+      const double draw = this->Uniform()*this->cumulative.back();
+      const std::vector<double>::const_iterator
+          bin = std::upper_bound(this->cumulative.begin(),this->cumulative.end(),draw);
+
+      return (ClassId(std::min<ptrdiff_t>(bin - this->cumulative.begin(),
+                                          this->cumulative.size() - 1)));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Draws a uniform value in [0,1) from the top 53 bits of the engine output.
+ *
+ *  @return  the value
+ */
+
+  double APRT::CorpusGenerator::Uniform()
+    {
+      return (double(this->engine() >> 11)*(1.0/9007199254740992.0));
+    }
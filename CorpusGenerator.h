@@ -0,0 +1,98 @@
+/**
+ *  @file  CorpusGenerator.h
+ *
+ *  @brief  Definition of the CorpusGenerator class.
+ *
+ *  Definition of the CorpusGenerator class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CORPUS_GENERATOR_H_INCLUDED
+    #define APRT_CORPUS_GENERATOR_H_INCLUDED
+
+    #include <random>
+    #include <string>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The shape of a synthetic acl/pcl pair.
+ */
+
+        struct CorpusOptions
+          {
+            CorpusOptions();
+            uint64_t            seed;        /**< @brief  the random seed                       */
+            uint32_t            subsamples;  /**< @brief  the <CLASS> blocks per file           */
+            uint64_t            patches;     /**< @brief  the patches per subsample             */
+            std::vector<double> weights;     /**< @brief  the relative frequency of each class  */
+            double              noneRate;    /**< @brief  the fraction of empty (NONE) fields   */
+            double              agreement;   /**< @brief  the fraction of pcl labels that agree */
+            uint32_t            wrap;        /**< @brief  fields per line (0 for one line)      */
+            bool                spaced;      /**< @brief  whether a space follows each comma    */
+          };
+
+/**
+ *  Writes deterministic synthetic acl/pcl files in the <CLASS> format.  The same options
+ *  always produce the same bytes: the generator draws from a std::mt19937_64 and maps
+ *  the draws itself rather than through the (implementation-defined) standard
+ *  distributions.
+ */
+
+        class CorpusGenerator
+          {
+            public:
+              CorpusGenerator(const CorpusOptions& options);
+
+            public:
+              uint64_t  Write(const std::string& aclpath,
+                              const std::string& pclpath);
+              static std::vector<double>
+                        Weights(const std::string& distribution);
+            private:
+              ClassId   Draw();
+              double    Uniform();
+            private:
+              CorpusOptions        options;
+                /**< @brief  the corpus shape */
+              std::mt19937_64      engine;
+                /**< @brief  the random source */
+              std::vector<double>  cumulative;
+                /**< @brief  the cumulative class weights */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates the default options: one subsample of 1000 uniformly distributed patches,
+ *  no empty fields, 90% agreement and one line per block.
+ */
+
+    inline APRT::CorpusOptions::CorpusOptions()
+      : seed(1),
+        subsamples(1),
+        patches(1000),
+        weights(ClassVocabulary::None,1.0),
+        noneRate(0.0),
+        agreement(0.9),
+        wrap(0),
+        spaced(false)
+          {
+            ;
+          }
+
+  #endif
@@ -0,0 +1,130 @@
+/**
+ *  @file  CrossValidation.cpp
+ *
+ *  @brief  Implementation of the CrossValidation class.
+ *
+ *  Implementation of the CrossValidation class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "CrossValidation.h"
+
+  #include <algorithm>
+  #include <numeric>
+  #include <stdexcept>
+
+  #include "ParallelFor.h"
+  #include "ResultWriter.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a CrossValidation, dealing the runfiles of the corpus into the folds.
+ *
+ *  @param [in]  corpus  the loaded feature vectors and user classes (kept by reference)
+ *  @param [in]  folds   the number of folds (from 2 to the number of runfiles)
+ */
+
+  APRT::CrossValidation::CrossValidation(const FeatureEvaluator& corpus,
+                                         const uint32_t          folds)
+    : corpus(corpus),
+      runfiles(folds),
+      matrices(folds)
+      {
+        const uint32_t count = uint32_t(corpus.Runfiles().size());
+        if ((folds < 2) || (folds > count))
+          {
+            throw std::runtime_error("Cross-validation needs from 2 to " + std::to_string(count) + " folds.");
+          }
+//
+//  Deal the runfiles, largest first (list order among equals), each to the fold with
+//  the fewest particles so far (the first among equals) ...
+//
+        std::vector<uint32_t> order(count);
+        std::iota(order.begin(),order.end(),0U);
+        std::stable_sort(order.begin(),order.end(),[&](const uint32_t a, const uint32_t b)
+          {
+            return (corpus.FirstPatch(a + 1) - corpus.FirstPatch(a) > corpus.FirstPatch(b + 1) - corpus.FirstPatch(b));
+          });
+        std::vector<uint64_t> sizes(folds,0);
+        for (const uint32_t runfile : order)
+          {
+            const uint32_t fold = uint32_t(std::min_element(sizes.begin(),sizes.end()) - sizes.begin());
+            sizes[fold] += corpus.FirstPatch(runfile + 1) - corpus.FirstPatch(runfile);
+            this->runfiles[fold].push_back(runfile);
+          }
+//
+//  ... and keep each fold in list order.
+//
+        for (std::vector<uint32_t>& fold : this->runfiles)
+          {
+            std::sort(fold.begin(),fold.end());
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Runs every fold, spread over the jobs.  A worker trains the classifier of a fold on
+ *  the runfiles of the other folds, classifies the fold's own runfiles with it, then
+ *  claims the next fold.  The results replace those of any previous run.
+ *
+ *  @param [in]  trainer  trains a classifier on a set of runfiles
+ *  @param [in]  jobs     the number of folds run concurrently
+ *
+ *  @throw  std::runtime_error  if a trained classifier returns a class outside the
+ *                              vocabulary
+ */
+
+  void APRT::CrossValidation::Run(const Trainer& trainer,
+                                  const uint32_t jobs)
+    {
+      const uint32_t folds = this->Folds();
+      this->matrices.assign(folds,ConfusionMatrix<>());
+      ParallelFor(0,folds,jobs,[&](const uint32_t fold)
+        {
+          std::vector<uint32_t> training;
+          for (uint32_t other = 0; other < folds; ++other)
+            {
+              if (other != fold)
+                {
+                  training.insert(training.end(),this->runfiles[other].begin(),this->runfiles[other].end());
+                }
+            }
+          std::sort(training.begin(),training.end());
+          const Classifier classifier = trainer(this->corpus,training);
+          this->matrices[fold] = this->corpus.Evaluate(classifier,this->runfiles[fold],1);
+        });
+
+      this->pooled = ConfusionMatrix<>();
+      for (const ConfusionMatrix<>& matrix : this->matrices)
+        {
+          this->pooled += matrix;
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes the matrices of the last run to a results file: one labeled "fold N" (from 1)
+ *  per fold, then the one labeled "pooled".
+ *
+ *  @param [in]  path  the results file path (appended to)
+ */
+
+  void APRT::CrossValidation::Write(const std::string& path) const
+    {
+      ResultWriter writer(path);
+      for (uint32_t fold = 0; fold < this->matrices.size(); ++fold)
+        {
+          writer.Append("fold " + std::to_string(fold + 1),this->matrices[fold]);
+        }
+      writer.Write("pooled",this->pooled);
+    }
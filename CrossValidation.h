@@ -0,0 +1,146 @@
+/**
+ *  @file  CrossValidation.h
+ *
+ *  @brief  Definition of the CrossValidation class.
+ *
+ *  Definition of the CrossValidation class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_CROSS_VALIDATION_H_INCLUDED
+    #define APRT_CROSS_VALIDATION_H_INCLUDED
+
+    #include <functional>
+    #include <string>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ConfusionMatrix.h"
+    #include "FeatureEvaluator.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  Trains a classifier on the particles of some runfiles of a corpus (between
+ *          FirstPatch(runfile) and FirstPatch(runfile + 1) of each).  Called from
+ *          several threads at once, once per fold.
+ */
+
+        typedef std::function<Classifier (const FeatureEvaluator&      corpus,
+                                          const std::vector<uint32_t>& runfiles)> Trainer;
+
+/**
+ *  K-fold cross-validation of a classifier, grouped by runfile.  The runfiles of a
+ *  corpus (the list order kept by the feature store) are dealt into folds whole, so the
+ *  particles of a runfile, which share a sample, an instrument and a day, never sit on
+ *  both sides of a split.  Each runfile goes to the fold with the fewest particles so
+ *  far, largest runfiles first, so the folds are about the same size and the split
+ *  depends only on the corpus.  The folds are run concurrently over the shared corpus:
+ *  each trains on the other folds and counts its own runfiles into its matrix, and the
+ *  fold matrices are summed into the pooled matrix.
+ */
+
+        class CrossValidation
+          {
+            public:
+              CrossValidation(const FeatureEvaluator& corpus,
+                              uint32_t                folds);
+
+            public:
+              void                          Run(const Trainer& trainer,
+                                                uint32_t       jobs);
+              uint32_t                      Folds() const;
+              const std::vector<uint32_t>&  Runfiles(uint32_t fold) const;
+              const ConfusionMatrix<>&      Matrix(uint32_t fold) const;
+              const ConfusionMatrix<>&      Pooled() const;
+              void                          Write(const std::string& path) const;
+            private:
+              const FeatureEvaluator&             corpus;
+                /**< @brief  the feature vectors and user classes */
+              std::vector<std::vector<uint32_t>>  runfiles;
+                /**< @brief  the runfiles of each fold, in list order */
+              std::vector<ConfusionMatrix<>>      matrices;
+                /**< @brief  the matrix of each fold run */
+              ConfusionMatrix<>                   pooled;
+                /**< @brief  the sum of the fold matrices */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of folds.
+ *
+ *  @return  the number of folds
+ */
+
+    inline uint32_t APRT::CrossValidation::Folds() const
+      {
+        return (uint32_t(this->runfiles.size()));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the runfiles held out by a fold.
+ *
+ *  @param [in]  fold  the fold
+ *
+ *  @return  the runfiles (corpus runfile numbers, in list order)
+ */
+
+    inline const std::vector<uint32_t>& APRT::CrossValidation::Runfiles(const uint32_t fold) const
+      {
+        assert(fold < this->runfiles.size());
+        return (this->runfiles[fold]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the confusion matrix of a fold, its held-out runfiles classified by the
+ *  classifier trained on the other folds.
+ *
+ *  @param [in]  fold  the fold
+ *
+ *  @return  the matrix (empty before Run())
+ */
+
+    inline const APRT::ConfusionMatrix<>& APRT::CrossValidation::Matrix(const uint32_t fold) const
+      {
+        assert(fold < this->matrices.size());
+        return (this->matrices[fold]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the pooled confusion matrix, every particle counted once by the fold that
+ *  held it out.
+ *
+ *  @return  the matrix (empty before Run())
+ */
+
+    inline const APRT::ConfusionMatrix<>& APRT::CrossValidation::Pooled() const
+      {
+        return (this->pooled);
+      }
+
+  #endif
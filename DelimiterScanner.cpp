@@ -0,0 +1,570 @@
+/**
+ *  @file  DelimiterScanner.cpp
+ *
+ *  @brief  Implementation of the DelimiterScanner class.
+ *
+ *  Implementation of the DelimiterScanner class.  The SIMD implementations compare a
+ *  block of text with the delimiters, reduce the comparison to a bit mask (one bit per
+ *  byte) and take the lowest set bit, or count the set bits.  Each is compiled for its
+ *  own instruction set, so the program runs on any x86 processor; other processors use
+ *  the scalar implementation.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "DelimiterScanner.h"
+
+  #include <algorithm>
+  #include <atomic>
+
+  #include <stdint.h>
+
+  #if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define APRT_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+      #include <intrin.h>
+    #endif
+  #endif
+
+  #if defined(__GNUC__)
+    #define APRT_TARGET(isa) __attribute__((target(isa)))
+  #else
+    #define APRT_TARGET(isa)
+  #endif
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The searches of one implementation.
+ */
+
+        struct Kernels
+          {
+            const char* (*find1)(const char*, const char*, char);
+            const char* (*find2)(const char*, const char*, char, char);
+            size_t      (*count)(const char*, const char*, char);
+            uint64_t    (*mask)(const char*, const char*, char, char);
+          };
+
+/**
+ *  The scalar implementation, which is also the tail of the 16 and 32 byte ones.
+ */
+
+        const char* ScalarFind1(const char* first, const char* const last, const char d)
+          {
+            while ((first != last) && (*first != d))
+              {
+                ++first;
+              }
+            return (first);
+          }
+
+        const char* ScalarFind2(const char* first, const char* const last, const char d1, const char d2)
+          {
+            while ((first != last) && (*first != d1) && (*first != d2))
+              {
+                ++first;
+              }
+            return (first);
+          }
+
+        size_t ScalarCount(const char* const first, const char* const last, const char d)
+          {
+            return (size_t(std::count(first,last,d)));
+          }
+
+        uint64_t ScalarMask(const char* const first, const char* const last, const char d1, const char d2)
+          {
+            const size_t size = std::min<size_t>(size_t(last - first),64);
+            uint64_t mask = 0;
+            for (size_t i = 0; i < size; ++i)
+              {
+                mask |= uint64_t((first[i] == d1) || (first[i] == d2)) << i;
+              }
+            return (mask);
+          }
+
+        const Kernels ScalarKernels = {ScalarFind1,ScalarFind2,ScalarCount,ScalarMask};
+
+  #ifdef APRT_X86
+
+/**
+ *  Returns the number of set bits of a mask.
+ */
+
+        inline size_t CountBits(uint64_t mask)
+          {
+            #ifdef _MSC_VER
+              size_t count = 0;
+              for (; mask != 0; mask &= mask - 1)
+                {
+                  ++count;
+                }
+              return (count);
+            #else
+              return (size_t(__builtin_popcountll(mask)));
+            #endif
+          }
+
+/**
+ *  The SSE2 implementation: 16 bytes at a time.
+ */
+
+        APRT_TARGET("sse2")
+        const char* Sse2Find1(const char* first, const char* const last, const char d)
+          {
+            const __m128i delimiter = _mm_set1_epi8(d);
+            for (; last - first >= 16; first += 16)
+              {
+                const __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const unsigned mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(text,delimiter)));
+                if (mask != 0)
+                  {
+                    return (first + APRT::DelimiterScanner::LowestBit(mask));
+                  }
+              }
+            return (ScalarFind1(first,last,d));
+          }
+
+        APRT_TARGET("sse2")
+        const char* Sse2Find2(const char* first, const char* const last, const char d1, const char d2)
+          {
+            const __m128i delimiter1 = _mm_set1_epi8(d1);
+            const __m128i delimiter2 = _mm_set1_epi8(d2);
+            for (; last - first >= 16; first += 16)
+              {
+                const __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const unsigned mask = unsigned(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(text,delimiter1),
+                                                                              _mm_cmpeq_epi8(text,delimiter2))));
+                if (mask != 0)
+                  {
+                    return (first + APRT::DelimiterScanner::LowestBit(mask));
+                  }
+              }
+            return (ScalarFind2(first,last,d1,d2));
+          }
+
+        APRT_TARGET("sse2")
+        size_t Sse2Count(const char* first, const char* const last, const char d)
+          {
+            const __m128i delimiter = _mm_set1_epi8(d);
+            size_t count = 0;
+            for (; last - first >= 16; first += 16)
+              {
+                const __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                count += CountBits(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(text,delimiter))));
+              }
+            return (count + ScalarCount(first,last,d));
+          }
+
+        APRT_TARGET("sse2")
+        uint64_t Sse2Mask(const char* const first, const char* const last, const char d1, const char d2)
+          {
+            if (last - first < 64)
+              {
+                return (ScalarMask(first,last,d1,d2));
+              }
+            const __m128i delimiter1 = _mm_set1_epi8(d1);
+            const __m128i delimiter2 = _mm_set1_epi8(d2);
+            uint64_t mask = 0;
+            for (int block = 0; block < 4; ++block)
+              {
+                const __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 16*block));
+                mask |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(text,delimiter1),
+                                                                         _mm_cmpeq_epi8(text,delimiter2))))) << (16*block);
+              }
+            return (mask);
+          }
+
+        const Kernels Sse2Kernels = {Sse2Find1,Sse2Find2,Sse2Count,Sse2Mask};
+
+/**
+ *  The AVX2 implementation: 32 bytes at a time.
+ */
+
+        APRT_TARGET("avx2")
+        const char* Avx2Find1(const char* first, const char* const last, const char d)
+          {
+            const __m256i delimiter = _mm256_set1_epi8(d);
+            for (; last - first >= 32; first += 32)
+              {
+                const __m256i text = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                const unsigned mask = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(text,delimiter)));
+                if (mask != 0)
+                  {
+                    return (first + APRT::DelimiterScanner::LowestBit(mask));
+                  }
+              }
+            return (Sse2Find1(first,last,d));
+          }
+
+        APRT_TARGET("avx2")
+        const char* Avx2Find2(const char* first, const char* const last, const char d1, const char d2)
+          {
+            const __m256i delimiter1 = _mm256_set1_epi8(d1);
+            const __m256i delimiter2 = _mm256_set1_epi8(d2);
+            for (; last - first >= 32; first += 32)
+              {
+                const __m256i text = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                const unsigned mask = unsigned(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(text,delimiter1),
+                                                                                    _mm256_cmpeq_epi8(text,delimiter2))));
+                if (mask != 0)
+                  {
+                    return (first + APRT::DelimiterScanner::LowestBit(mask));
+                  }
+              }
+            return (Sse2Find2(first,last,d1,d2));
+          }
+
+        APRT_TARGET("avx2")
+        size_t Avx2Count(const char* first, const char* const last, const char d)
+          {
+            const __m256i delimiter = _mm256_set1_epi8(d);
+            size_t count = 0;
+            for (; last - first >= 32; first += 32)
+              {
+                const __m256i text = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                count += CountBits(unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(text,delimiter))));
+              }
+            return (count + Sse2Count(first,last,d));
+          }
+
+        APRT_TARGET("avx2")
+        uint64_t Avx2Mask(const char* const first, const char* const last, const char d1, const char d2)
+          {
+            if (last - first < 64)
+              {
+                return (Sse2Mask(first,last,d1,d2));
+              }
+            const __m256i delimiter1 = _mm256_set1_epi8(d1);
+            const __m256i delimiter2 = _mm256_set1_epi8(d2);
+            const __m256i low  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + 32));
+            const uint32_t lowmask  = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(low,delimiter1),
+                                                                                    _mm256_cmpeq_epi8(low,delimiter2))));
+            const uint32_t highmask = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(high,delimiter1),
+                                                                                    _mm256_cmpeq_epi8(high,delimiter2))));
+            return ((uint64_t(highmask) << 32) | lowmask);
+          }
+
+        const Kernels Avx2Kernels = {Avx2Find1,Avx2Find2,Avx2Count,Avx2Mask};
+
+/**
+ *  The AVX-512BW implementation: 64 bytes at a time, with the tail read by a masked load
+ *  (which cannot fault on the bytes past the end).
+ */
+
+        APRT_TARGET("avx512f,avx512bw")
+        const char* Avx512Find1(const char* first, const char* const last, const char d)
+          {
+            const __m512i delimiter = _mm512_set1_epi8(d);
+            for (; first != last; )
+              {
+                const size_t    remaining = size_t(last - first);
+                const __mmask64 valid     = (remaining >= 64) ? ~__mmask64(0) : ((__mmask64(1) << remaining) - 1);
+                const __m512i   text      = _mm512_maskz_loadu_epi8(valid,first);
+                const uint64_t  mask      = _mm512_mask_cmpeq_epi8_mask(valid,text,delimiter);
+                if (mask != 0)
+                  {
+                    return (first + APRT::DelimiterScanner::LowestBit(mask));
+                  }
+                first += std::min<size_t>(remaining,64);
+              }
+            return (last);
+          }
+
+        APRT_TARGET("avx512f,avx512bw")
+        const char* Avx512Find2(const char* first, const char* const last, const char d1, const char d2)
+          {
+            const __m512i delimiter1 = _mm512_set1_epi8(d1);
+            const __m512i delimiter2 = _mm512_set1_epi8(d2);
+            for (; first != last; )
+              {
+                const size_t    remaining = size_t(last - first);
+                const __mmask64 valid     = (remaining >= 64) ? ~__mmask64(0) : ((__mmask64(1) << remaining) - 1);
+                const __m512i   text      = _mm512_maskz_loadu_epi8(valid,first);
+                const uint64_t  mask      = _mm512_mask_cmpeq_epi8_mask(valid,text,delimiter1) |
+                                            _mm512_mask_cmpeq_epi8_mask(valid,text,delimiter2);
+                if (mask != 0)
+                  {
+                    return (first + APRT::DelimiterScanner::LowestBit(mask));
+                  }
+                first += std::min<size_t>(remaining,64);
+              }
+            return (last);
+          }
+
+        APRT_TARGET("avx512f,avx512bw")
+        size_t Avx512Count(const char* first, const char* const last, const char d)
+          {
+            const __m512i delimiter = _mm512_set1_epi8(d);
+            size_t count = 0;
+            for (; first != last; )
+              {
+                const size_t    remaining = size_t(last - first);
+                const __mmask64 valid     = (remaining >= 64) ? ~__mmask64(0) : ((__mmask64(1) << remaining) - 1);
+                const __m512i   text      = _mm512_maskz_loadu_epi8(valid,first);
+                count += CountBits(_mm512_mask_cmpeq_epi8_mask(valid,text,delimiter));
+                first += std::min<size_t>(remaining,64);
+              }
+            return (count);
+          }
+
+        APRT_TARGET("avx512f,avx512bw")
+        uint64_t Avx512Mask(const char* const first, const char* const last, const char d1, const char d2)
+          {
+            const size_t    remaining = size_t(last - first);
+            const __mmask64 valid     = (remaining >= 64) ? ~__mmask64(0) : ((__mmask64(1) << remaining) - 1);
+            const __m512i   text      = _mm512_maskz_loadu_epi8(valid,first);
+            return (_mm512_mask_cmpeq_epi8_mask(valid,text,_mm512_set1_epi8(d1)) |
+                    _mm512_mask_cmpeq_epi8_mask(valid,text,_mm512_set1_epi8(d2)));
+          }
+
+        const Kernels Avx512Kernels = {Avx512Find1,Avx512Find2,Avx512Count,Avx512Mask};
+
+/**
+ *  Returns the widest instruction set supported by the processor and operating system.
+ */
+
+        APRT::DelimiterScanner::Isa DetectIsa()
+          {
+            #if defined(__GNUC__)
+              __builtin_cpu_init();
+              if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+                {
+                  return (APRT::DelimiterScanner::Avx512);
+                }
+              if (__builtin_cpu_supports("avx2"))
+                {
+                  return (APRT::DelimiterScanner::Avx2);
+                }
+              if (__builtin_cpu_supports("sse2"))
+                {
+                  return (APRT::DelimiterScanner::Sse2);
+                }
+            #elif defined(_MSC_VER)
+              int info[4];
+              __cpuid(info,0);
+              const int levels = info[0];
+              __cpuid(info,1);
+              const bool sse2    = (info[3] & (1 << 26)) != 0;
+              const bool osxsave = (info[2] & (1 << 27)) != 0;
+              const uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+              if (levels >= 7)
+                {
+                  __cpuidex(info,7,0);
+                  if (((info[1] & (1 << 16)) != 0) && ((info[1] & (1 << 30)) != 0) && ((xcr0 & 0xE6) == 0xE6))
+                    {
+                      return (APRT::DelimiterScanner::Avx512);
+                    }
+                  if (((info[1] & (1 << 5)) != 0) && ((xcr0 & 0x6) == 0x6))
+                    {
+                      return (APRT::DelimiterScanner::Avx2);
+                    }
+                }
+              if (sse2)
+                {
+                  return (APRT::DelimiterScanner::Sse2);
+                }
+            #endif
+            return (APRT::DelimiterScanner::Scalar);
+          }
+
+        const Kernels* const Implementations[] = {&ScalarKernels,&Sse2Kernels,&Avx2Kernels,&Avx512Kernels};
+
+  #else
+
+        APRT::DelimiterScanner::Isa DetectIsa()
+          {
+            return (APRT::DelimiterScanner::Scalar);
+          }
+
+        const Kernels* const Implementations[] = {&ScalarKernels,&ScalarKernels,&ScalarKernels,&ScalarKernels};
+
+  #endif
+
+/**
+ *  Returns the selected instruction set (the best supported one until Select() is
+ *  called).
+ */
+
+        std::atomic<int>& Active()
+          {
+            static std::atomic<int> active(int(APRT::DelimiterScanner::Best()));
+            return (active);
+          }
+
+/**
+ *  Returns the searches of the selected instruction set.
+ */
+
+        inline const Kernels& Dispatch()
+          {
+            return (*Implementations[Active().load(std::memory_order_relaxed)]);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Finds the first occurrence of a delimiter.
+ *
+ *  @param [in]  first      the start of the text
+ *  @param [in]  last       the end of the text
+ *  @param [in]  delimiter  the delimiter
+ *
+ *  @return  the position of the delimiter, or last if there is none
+ */
+
+  const char* APRT::DelimiterScanner::Find(const char* const first,
+                                           const char* const last,
+                                           const char        delimiter)
+    {
+      return (Dispatch().find1(first,last,delimiter));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Finds the first occurrence of either of two delimiters.
+ *
+ *  @param [in]  first       the start of the text
+ *  @param [in]  last        the end of the text
+ *  @param [in]  delimiter1  a delimiter
+ *  @param [in]  delimiter2  another delimiter
+ *
+ *  @return  the position of the first delimiter, or last if there is none
+ */
+
+  const char* APRT::DelimiterScanner::Find(const char* const first,
+                                           const char* const last,
+                                           const char        delimiter1,
+                                           const char        delimiter2)
+    {
+      return (Dispatch().find2(first,last,delimiter1,delimiter2));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Counts the occurrences of a delimiter.
+ *
+ *  @param [in]  first      the start of the text
+ *  @param [in]  last       the end of the text
+ *  @param [in]  delimiter  the delimiter
+ *
+ *  @return  the number of occurrences
+ */
+
+  size_t APRT::DelimiterScanner::Count(const char* const first,
+                                       const char* const last,
+                                       const char        delimiter)
+    {
+      return (Dispatch().count(first,last,delimiter));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Marks the occurrences of either of two delimiters in (at most) 64 bytes.
+ *
+ *  @param [in]  first       the start of the text
+ *  @param [in]  last        the end of the text
+ *  @param [in]  delimiter1  a delimiter
+ *  @param [in]  delimiter2  another delimiter
+ *
+ *  @return  a mask with bit i set if first[i] is a delimiter, for the first
+ *           min(last - first,64) bytes
+ */
+
+  uint64_t APRT::DelimiterScanner::Mask(const char* const first,
+                                        const char* const last,
+                                        const char        delimiter1,
+                                        const char        delimiter2)
+    {
+      return (Dispatch().mask(first,last,delimiter1,delimiter2));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the widest instruction set supported by the processor.
+ *
+ *  @return  the best implementation
+ */
+
+  APRT::DelimiterScanner::Isa APRT::DelimiterScanner::Best()
+    {
+      static const Isa best = DetectIsa();
+      return (best);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the instruction set in use.
+ *
+ *  @return  the selected implementation
+ */
+
+  APRT::DelimiterScanner::Isa APRT::DelimiterScanner::Selected()
+    {
+      return (Isa(Active().load(std::memory_order_relaxed)));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Selects the implementation to use (for comparing implementations).  A set the
+ *  processor does not support is replaced by the best one it does.
+ *
+ *  @param [in]  isa  the implementation wanted
+ *
+ *  @return  the implementation selected
+ */
+
+  APRT::DelimiterScanner::Isa APRT::DelimiterScanner::Select(const Isa isa)
+    {
+      const Isa selected = std::min(isa,Best());
+      Active().store(int(selected),std::memory_order_relaxed);
+
+      return (selected);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the name of an instruction set.
+ *
+ *  @param [in]  isa  the implementation
+ *
+ *  @return  "scalar", "sse2", "avx2" or "avx512"
+ */
+
+  const char* APRT::DelimiterScanner::Name(const Isa isa)
+    {
+      static const char* const names[] = {"scalar","sse2","avx2","avx512"};
+      return (names[isa]);
+    }
@@ -0,0 +1,184 @@
+/**
+ *  @file  DelimiterScanner.h
+ *
+ *  @brief  Definition of the DelimiterScanner and DelimiterCursor classes.
+ *
+ *  Definition of the DelimiterScanner and DelimiterCursor classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_DELIMITER_SCANNER_H_INCLUDED
+    #define APRT_DELIMITER_SCANNER_H_INCLUDED
+
+    #include <algorithm>
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    #ifdef _MSC_VER
+      #include <intrin.h>
+    #endif
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The delimiter searches of the acl/pcl tokenizer (the ',' and '<' that end a field,
+ *  the '>' that ends a tag, the end of a line), done 16, 32 or 64 bytes at a time.  The
+ *  widest instruction set the processor supports (SSE2, AVX2 or AVX-512BW) is chosen
+ *  the first time a search is made; every implementation, including the portable
+ *  scalar one, returns exactly the same positions.
+ */
+
+        class DelimiterScanner
+          {
+            public:
+              enum Isa { Scalar, Sse2, Avx2, Avx512 };
+                /**< @brief  the available implementations, narrowest first */
+
+            public:
+              static const char*
+                Find(const char* first, const char* last, char delimiter);
+              static const char*
+                Find(const char* first, const char* last, char delimiter1, char delimiter2);
+              static size_t
+                Count(const char* first, const char* last, char delimiter);
+              static uint64_t
+                Mask(const char* first, const char* last, char delimiter1, char delimiter2);
+              static unsigned
+                LowestBit(uint64_t mask);
+              static Isa
+                Best();
+              static Isa
+                Selected();
+              static Isa
+                Select(Isa isa);
+              static const char*
+                Name(Isa isa);
+          };
+
+/**
+ *  A search for either of two delimiters in text read mostly forwards, as the fields of
+ *  a subsample are.  The delimiters of 64 bytes are found at once and kept as a bit
+ *  mask, so the searches that follow within those bytes are a bit scan.
+ */
+
+        class DelimiterCursor
+          {
+            public:
+              DelimiterCursor(const char* last,
+                              char        delimiter1,
+                              char        delimiter2);
+
+            public:
+              const char*  Find(const char* first);
+            private:
+              const char*  blockfirst;
+                /**< @brief  the start of the block described by the mask */
+              const char*  blocklast;
+                /**< @brief  the end of the block */
+              const char*  last;
+                /**< @brief  the end of the text */
+              uint64_t     blockmask;
+                /**< @brief  the delimiters in the block, one bit per byte */
+              char         delimiter1;
+                /**< @brief  a delimiter */
+              char         delimiter2;
+                /**< @brief  another delimiter */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the position of the lowest set bit of a non-zero mask.
+ *
+ *  @param [in]  mask  the mask
+ *
+ *  @return  the bit position
+ */
+
+    inline unsigned APRT::DelimiterScanner::LowestBit(const uint64_t mask)
+      {
+        #if defined(_MSC_VER) && defined(_M_X64)
+          unsigned long index;
+          _BitScanForward64(&index,mask);
+          return (unsigned(index));
+        #elif defined(_MSC_VER)
+          unsigned long index;
+          if (!_BitScanForward(&index,static_cast<unsigned long>(mask)))
+            {
+              _BitScanForward(&index,static_cast<unsigned long>(mask >> 32));
+              index += 32;
+            }
+          return (unsigned(index));
+        #else
+          return (unsigned(__builtin_ctzll(mask)));
+        #endif
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a DelimiterCursor over text ending at the given position.
+ *
+ *  @param [in]  last        the end of the text
+ *  @param [in]  delimiter1  a delimiter
+ *  @param [in]  delimiter2  another delimiter
+ */
+
+    inline APRT::DelimiterCursor::DelimiterCursor(const char* const last,
+                                                  const char        delimiter1,
+                                                  const char        delimiter2)
+      : blockfirst(last),
+        blocklast(last),
+        last(last),
+        blockmask(0),
+        delimiter1(delimiter1),
+        delimiter2(delimiter2)
+          {
+            ;
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Finds the first delimiter at or after a position.
+ *
+ *  @param [in]  first  the position to search from
+ *
+ *  @return  the position of the delimiter, or the end of the text if there is none
+ */
+
+    inline const char* APRT::DelimiterCursor::Find(const char* first)
+      {
+        while (first != this->last)
+          {
+            if ((first < this->blockfirst) || (first >= this->blocklast))
+              {
+                this->blockfirst = first;
+                this->blocklast  = first + std::min<ptrdiff_t>(this->last - first,64);
+                this->blockmask  = DelimiterScanner::Mask(first,this->last,this->delimiter1,this->delimiter2);
+              }
+            const uint64_t mask = this->blockmask & (~uint64_t(0) << (first - this->blockfirst));
+            if (mask != 0)
+              {
+                return (this->blockfirst + DelimiterScanner::LowestBit(mask));
+              }
+            first = this->blocklast;
+          }
+        return (this->last);
+      }
+
+  #endif
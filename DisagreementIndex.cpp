@@ -0,0 +1,281 @@
+/**
+ *  @file  DisagreementIndex.cpp
+ *
+ *  @brief  Implementation of the DisagreementIndex and DisagreementRecorder classes.
+ *
+ *  Implementation of the DisagreementIndex and DisagreementRecorder classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "DisagreementIndex.h"
+
+  #include <algorithm>
+  #include <fstream>
+  #include <stdexcept>
+  #include <tuple>
+
+  #include <cstring>
+
+  #include "BinaryLayout.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The fixed-size start of a disagreement index.  It is followed by classes*classes + 1
+ *  record offsets, classes + 1 code offsets, runfiles + 1 name offsets, the codes and
+ *  the names (each padded to a multiple of eight bytes) and then the records, all in
+ *  native byte order.
+ */
+
+        struct IndexHeader
+          {
+            char      magic[8];   /**< @brief  "APRTDIX" and the format version  */
+            uint64_t  classes;    /**< @brief  the number of classes             */
+            uint64_t  runfiles;   /**< @brief  the number of runfile names       */
+            uint64_t  records;    /**< @brief  the number of disagreements       */
+            uint64_t  codebytes;  /**< @brief  the length of the class codes     */
+            uint64_t  namebytes;  /**< @brief  the length of the runfile names   */
+          };
+
+        const char Magic[8] = {'A','P','R','T','D','I','X','\x01'};
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a DisagreementRecorder for the runfiles of a list.
+ *
+ *  @param [in]  runfilenames  the runfiles to be compared, in list order
+ */
+
+  APRT::DisagreementRecorder::DisagreementRecorder(const std::vector<std::string>& runfilenames)
+    {
+      for (const std::string& runfilename : runfilenames)
+        {
+          if (this->ids.emplace(runfilename,uint32_t(this->runfilenames.size())).second)
+            {
+              this->runfilenames.push_back(runfilename);
+            }
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Records the disagreements of a runfile.  May be called from any thread.
+ *
+ *  @param [in]      runfilename    the runfile name (one of the list)
+ *  @param [in,out]  disagreements  the disagreements of the runfile (their runfile ids
+ *                                  are set)
+ */
+
+  void APRT::DisagreementRecorder::Add(const std::string&         runfilename,
+                                       std::vector<Disagreement>& disagreements)
+    {
+      assert(this->ids.count(runfilename) != 0);
+      const uint32_t runfile = this->ids.find(runfilename)->second;
+      for (Disagreement& disagreement : disagreements)
+        {
+          disagreement.runfile = runfile;
+        }
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->disagreements.insert(this->disagreements.end(),disagreements.begin(),disagreements.end());
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Sorts the recorded disagreements by cell and writes them as a disagreement index.
+ *
+ *  @param [in]  path  the index path
+ */
+
+  void APRT::DisagreementRecorder::Write(const std::string& path)
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      const uint32_t classes = ClassVocabulary::Size;
+//
+//  Sort the records by cell, then by where the patch is ...
+//
+      std::sort(this->disagreements.begin(),this->disagreements.end(),
+                [](const Disagreement& a, const Disagreement& b)
+                  {
+                    return (std::tie(a.pcl,a.acl,a.runfile,a.subsample,a.patch) <
+                            std::tie(b.pcl,b.acl,b.runfile,b.subsample,b.patch));
+                  });
+      std::vector<uint64_t> cells(size_t(classes) * classes + 1,0);
+      for (const Disagreement& disagreement : this->disagreements)
+        {
+          ++cells[size_t(disagreement.pcl) * classes + disagreement.acl + 1];
+        }
+      for (size_t cell = 1; cell < cells.size(); ++cell)
+        {
+          cells[cell] += cells[cell - 1];
+        }
+//
+//  Gather the codes and names ...
+//
+      std::vector<std::string_view> codes;
+      for (uint32_t id = 0; id < classes; ++id)
+        {
+          codes.push_back(ClassVocabulary::Code(ClassId(id)));
+        }
+      std::vector<uint64_t> codeoffsets;
+      std::vector<uint64_t> nameoffsets;
+      const std::string codetext = Concatenate(codes,codeoffsets);
+      const std::string nametext = Concatenate(this->runfilenames,nameoffsets);
+
+      IndexHeader header;
+      std::memcpy(header.magic,Magic,sizeof(Magic));
+      header.classes   = classes;
+      header.runfiles  = this->runfilenames.size();
+      header.records   = this->disagreements.size();
+      header.codebytes = codeoffsets.back();
+      header.namebytes = nameoffsets.back();
+//
+//  Write the index ...
+//
+      std::ofstream stream(path.c_str(),std::ios_base::binary | std::ios_base::trunc);
+      stream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+      stream.write(reinterpret_cast<const char*>(cells.data()),
+                   std::streamsize(cells.size() * sizeof(uint64_t)));
+      stream.write(reinterpret_cast<const char*>(codeoffsets.data()),
+                   std::streamsize(codeoffsets.size() * sizeof(uint64_t)));
+      stream.write(reinterpret_cast<const char*>(nameoffsets.data()),
+                   std::streamsize(nameoffsets.size() * sizeof(uint64_t)));
+      stream.write(codetext.data(),std::streamsize(codetext.size()));
+      stream.write(nametext.data(),std::streamsize(nametext.size()));
+      stream.write(reinterpret_cast<const char*>(this->disagreements.data()),
+                   std::streamsize(this->disagreements.size() * sizeof(Disagreement)));
+      stream.close();
+      if (!stream)
+        {
+          throw std::runtime_error("Unable to write the disagreement index " + path + ".");
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps a disagreement index.
+ *
+ *  @param [in]  path  the index path
+ */
+
+  APRT::DisagreementIndex::DisagreementIndex(const std::string& path)
+    : path(path),
+      file(path)
+      {
+        const std::runtime_error invalid(path + " is not a disagreement index.");
+        IndexHeader header;
+        if (!ReadHeader(this->file,Magic,header) ||
+            (header.classes   > UINT16_MAX)        ||
+            (header.runfiles  > UINT32_MAX)        ||
+            (header.records   > this->file.Size()) ||
+            (header.codebytes > this->file.Size()) ||
+            (header.namebytes > this->file.Size()))
+          {
+            throw invalid;
+          }
+        const uint64_t cellsstart   = sizeof(header);
+        const uint64_t codesstart   = cellsstart + (header.classes * header.classes + 1) * sizeof(uint64_t);
+        const uint64_t namesstart   = codesstart + (header.classes + 1) * sizeof(uint64_t);
+        const uint64_t textstart    = namesstart + (header.runfiles + 1) * sizeof(uint64_t);
+        const uint64_t recordsstart = textstart + Padded(header.codebytes) + Padded(header.namebytes);
+        if (this->file.Size() != recordsstart + header.records * sizeof(Disagreement))
+          {
+            throw invalid;
+          }
+        this->classes     = uint32_t(header.classes);
+        this->runfiles    = uint32_t(header.runfiles);
+        this->cells       = reinterpret_cast<const uint64_t*>(this->file.Begin() + cellsstart);
+        this->codeoffsets = reinterpret_cast<const uint64_t*>(this->file.Begin() + codesstart);
+        this->nameoffsets = reinterpret_cast<const uint64_t*>(this->file.Begin() + namesstart);
+        this->codes       = this->file.Begin() + textstart;
+        this->names       = this->codes + Padded(header.codebytes);
+        this->records     = reinterpret_cast<const Disagreement*>(this->file.Begin() + recordsstart);
+        if (!Ascending(this->cells,uint64_t(this->classes) * this->classes,header.records) ||
+            !Ascending(this->codeoffsets,this->classes,header.codebytes)                   ||
+            !Ascending(this->nameoffsets,this->runfiles,header.namebytes))
+          {
+            throw invalid;
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the disagreements of a (pcl,acl) cell, in runfile, subsample and patch index
+ *  order.  A class the index does not have has none.
+ *
+ *  @param [in]  pcl  the apr class
+ *  @param [in]  acl  the user class
+ *
+ *  @return  the disagreements of the cell
+ */
+
+  APRT::DisagreementSpan APRT::DisagreementIndex::Find(const uint32_t pcl,
+                                                       const uint32_t acl) const
+    {
+      if ((pcl >= this->classes) || (acl >= this->classes))
+        {
+          return (DisagreementSpan{this->records,this->records});
+        }
+      const size_t cell = size_t(pcl) * this->classes + acl;
+      return (DisagreementSpan{this->records + this->cells[cell],this->records + this->cells[cell + 1]});
+    }
+
+  APRT::DisagreementSpan APRT::DisagreementIndex::Find(const std::string_view pcl,
+                                                       const std::string_view acl) const
+    {
+      uint32_t pclid = this->classes;
+      uint32_t aclid = this->classes;
+      for (uint32_t id = 0; id < this->classes; ++id)
+        {
+          pclid = (this->Code(id) == pcl) ? id : pclid;
+          aclid = (this->Code(id) == acl) ? id : aclid;
+        }
+      return (this->Find(pclid,aclid));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the name of a runfile of the index.  The runfile ids of the records are
+ *  checked here rather than when the index is opened, so opening it does not read every
+ *  record.
+ *
+ *  @param [in]  id  the runfile id of a disagreement
+ *
+ *  @return  the runfile name
+ *
+ *  @throw  std::runtime_error  if the index lists no such runfile (a damaged index)
+ */
+
+  std::string_view APRT::DisagreementIndex::Runfile(const uint32_t id) const
+    {
+      if (id >= this->runfiles)
+        {
+          throw std::runtime_error(this->path + " is not a disagreement index.");
+        }
+      return (std::string_view(this->names + this->nameoffsets[id],
+                               this->nameoffsets[id + 1] - this->nameoffsets[id]));
+    }
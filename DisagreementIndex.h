@@ -0,0 +1,207 @@
+/**
+ *  @file  DisagreementIndex.h
+ *
+ *  @brief  Definition of the DisagreementIndex and DisagreementRecorder classes.
+ *
+ *  Definition of the DisagreementIndex and DisagreementRecorder classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_DISAGREEMENT_INDEX_H_INCLUDED
+    #define APRT_DISAGREEMENT_INDEX_H_INCLUDED
+
+    #include <mutex>
+    #include <string>
+    #include <string_view>
+    #include <unordered_map>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+    #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  A patch whose apr and user classes differ, as stored in a disagreement index.
+ */
+
+        struct Disagreement
+          {
+            uint32_t  runfile;    /**< @brief  the runfile id (its name in the index)     */
+            uint16_t  subsample;  /**< @brief  the one-based subsample number            */
+            ClassId   pcl;        /**< @brief  the apr class                             */
+            ClassId   acl;        /**< @brief  the user class                            */
+            uint32_t  patch;      /**< @brief  the patch index within the subsample      */
+          };
+
+        static_assert(sizeof(Disagreement) == 12,"a Disagreement is stored as 12 bytes");
+
+/**
+ *  A view of the disagreements of one (pcl,acl) cell.
+ */
+
+        struct DisagreementSpan
+          {
+            const Disagreement*  begin() const  { return (this->first);              }
+            const Disagreement*  end() const    { return (this->last);               }
+            size_t               size() const   { return (this->last - this->first); }
+            const Disagreement*  first;  /**< @brief  the first disagreement of the cell */
+            const Disagreement*  last;   /**< @brief  one past the last                  */
+          };
+
+/**
+ *  Collects the disagreements of the compared runfiles, from any number of threads, and
+ *  writes them as a disagreement index.  Runfile ids are the positions of the runfiles
+ *  on the list (a runfile listed twice keeps its first id), so the index does not
+ *  depend on the order in which the runfiles were compared.
+ */
+
+        class DisagreementRecorder
+          {
+            public:
+              explicit DisagreementRecorder(const std::vector<std::string>& runfilenames);
+              DisagreementRecorder(const DisagreementRecorder&) = delete;
+              DisagreementRecorder& operator = (const DisagreementRecorder&) = delete;
+
+            public:
+              void  Add(const std::string&         runfilename,
+                        std::vector<Disagreement>& disagreements);
+              void  Write(const std::string& path);
+            private:
+              std::vector<std::string>  runfilenames;
+                /**< @brief  the name of each runfile id */
+              std::unordered_map<std::string,uint32_t>
+                                        ids;
+                /**< @brief  the id of each runfile name */
+              std::vector<Disagreement> disagreements;
+                /**< @brief  the disagreements recorded so far, in no order */
+              std::mutex                mutex;
+                /**< @brief  guards the disagreements */
+          };
+
+/**
+ *  A disagreement index: every patch whose apr and user classes differ, sorted by
+ *  (pcl,acl) cell and then by runfile, subsample and patch index, with a table of the
+ *  start of each cell, so the disagreements of a cell are found without a search.  The
+ *  file also holds the class codes it was written with and the runfile names.  It is
+ *  mapped, not read; a query costs only the pages of the records it returns, so the
+ *  records are not checked when the index is opened (a record naming a runfile the
+ *  index does not list is reported when its runfile name is asked for).
+ *
+ *  The file is, in native byte order: a header; cells + 1 record offsets; the offsets of
+ *  the class codes and of the runfile names (each with a final end offset); the codes
+ *  and the names, each padded to eight bytes; and the records.
+ */
+
+        class DisagreementIndex
+          {
+            public:
+              explicit DisagreementIndex(const std::string& path);
+
+            public:
+              DisagreementSpan  Find(uint32_t pcl, uint32_t acl) const;
+              DisagreementSpan  Find(std::string_view pcl, std::string_view acl) const;
+              uint32_t          Classes() const;
+              std::string_view  Code(uint32_t id) const;
+              uint32_t          Runfiles() const;
+              std::string_view  Runfile(uint32_t id) const;
+              uint64_t          Size() const;
+            private:
+              std::string           path;
+                /**< @brief  the index path (for errors) */
+              MappedFile            file;
+                /**< @brief  the mapped index */
+              uint32_t              classes;
+                /**< @brief  the number of classes */
+              uint32_t              runfiles;
+                /**< @brief  the number of runfile names */
+              const uint64_t*       cells;
+                /**< @brief  the first record of each cell, plus the end */
+              const uint64_t*       codeoffsets;
+                /**< @brief  the start of each class code, plus the end */
+              const uint64_t*       nameoffsets;
+                /**< @brief  the start of each runfile name, plus the end */
+              const char*           codes;
+                /**< @brief  the class codes */
+              const char*           names;
+                /**< @brief  the runfile names */
+              const Disagreement*   records;
+                /**< @brief  the disagreements */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of classes of the index (the rows and columns of its cells).
+ *
+ *  @return  the number of classes
+ */
+
+    inline uint32_t APRT::DisagreementIndex::Classes() const
+      {
+        return (this->classes);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of a class of the index.
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  the class code
+ */
+
+    inline std::string_view APRT::DisagreementIndex::Code(const uint32_t id) const
+      {
+        assert(id < this->classes);
+        return (std::string_view(this->codes + this->codeoffsets[id],
+                                 this->codeoffsets[id + 1] - this->codeoffsets[id]));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of runfile names in the index.
+ *
+ *  @return  the number of runfiles
+ */
+
+    inline uint32_t APRT::DisagreementIndex::Runfiles() const
+      {
+        return (this->runfiles);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of disagreements in the index.
+ *
+ *  @return  the number of records
+ */
+
+    inline uint64_t APRT::DisagreementIndex::Size() const
+      {
+        return (this->cells[size_t(this->classes) * this->classes]);
+      }
+
+  #endif
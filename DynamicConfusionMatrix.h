@@ -0,0 +1,185 @@
+/**
+ *  @file  DynamicConfusionMatrix.h
+ *
+ *  @brief  Definition of the DynamicConfusionMatrix class.
+ *
+ *  Definition of the DynamicConfusionMatrix class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_DYNAMIC_CONFUSION_MATRIX_H_INCLUDED
+    #define APRT_DYNAMIC_CONFUSION_MATRIX_H_INCLUDED
+
+    #include <algorithm>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  A count of patches by apr (row) and user (column) class over a vocabulary whose size
+ *  is only known at run time, as that of a LabelTable is.  The matrix is square and
+ *  grows, keeping its counts, as classes are discovered.
+ */
+
+        class DynamicConfusionMatrix
+          {
+            public:
+              explicit DynamicConfusionMatrix(uint32_t dim = ClassVocabulary::Size);
+
+            public:
+              int32_t&  operator () (uint32_t pcl, uint32_t acl);
+              int32_t   operator () (uint32_t pcl, uint32_t acl) const;
+              DynamicConfusionMatrix&
+                        operator += (const DynamicConfusionMatrix& other);
+              void      Resize(uint32_t dim);
+              uint32_t  Dim1() const;
+              uint32_t  Dim2() const;
+            private:
+              uint32_t              dim;
+                /**< @brief  the number of rows and of columns */
+              std::vector<int32_t>  cells;
+                /**< @brief  the counts, row by row */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a DynamicConfusionMatrix with all counts zero.
+ *
+ *  @param [in]  dim  the number of classes
+ */
+
+    inline APRT::DynamicConfusionMatrix::DynamicConfusionMatrix(const uint32_t dim)
+      : dim(dim),
+        cells(size_t(dim)*dim,0)
+          {
+            ;
+          }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the count of patches with the given classifications.
+ *
+ *  @param [in]  pcl  the apr classification
+ *  @param [in]  acl  the user classification
+ *
+ *  @return  the count
+ */
+
+    inline int32_t& APRT::DynamicConfusionMatrix::operator () (const uint32_t pcl,
+                                                               const uint32_t acl)
+      {
+        assert((pcl < this->dim) && (acl < this->dim));
+        return (this->cells[size_t(pcl)*this->dim + acl]);
+      }
+
+    inline int32_t APRT::DynamicConfusionMatrix::operator () (const uint32_t pcl,
+                                                              const uint32_t acl) const
+      {
+        assert((pcl < this->dim) && (acl < this->dim));
+        return (this->cells[size_t(pcl)*this->dim + acl]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the counts of another matrix to this one, first growing this one to the size
+ *  of the other if it is smaller.
+ *
+ *  @param [in]  other  the matrix to add
+ *
+ *  @return  this matrix
+ */
+
+    inline APRT::DynamicConfusionMatrix&
+      APRT::DynamicConfusionMatrix::operator += (const DynamicConfusionMatrix& other)
+        {
+          this->Resize(other.dim);
+          for (uint32_t i = 0; i < other.dim; ++i)
+            {
+              for (uint32_t j = 0; j < other.dim; ++j)
+                {
+                  (*this)(i,j) += other(i,j);
+                }
+            }
+          return (*this);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Grows the matrix to at least the given number of classes, keeping its counts.
+ *
+ *  @param [in]  dim  the number of classes
+ */
+
+    inline void APRT::DynamicConfusionMatrix::Resize(const uint32_t dim)
+      {
+        if (dim <= this->dim)
+          {
+            return;
+          }
+        std::vector<int32_t> grown(size_t(dim)*dim,0);
+        for (uint32_t i = 0; i < this->dim; ++i)
+          {
+            std::copy(&this->cells[size_t(i)*this->dim],
+                      &this->cells[size_t(i)*this->dim] + this->dim,
+                      &grown[size_t(i)*dim]);
+          }
+        this->cells.swap(grown);
+        this->dim = dim;
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of rows (apr classes).
+ *
+ *  @return  the number of rows
+ */
+
+    inline uint32_t APRT::DynamicConfusionMatrix::Dim1() const
+      {
+        return (this->dim);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of columns (user classes).
+ *
+ *  @return  the number of columns
+ */
+
+    inline uint32_t APRT::DynamicConfusionMatrix::Dim2() const
+      {
+        return (this->dim);
+      }
+
+  #endif
@@ -0,0 +1,611 @@
+/**
+ *  @file  EvaluatorCheck.cpp
+ *
+ *  @brief  The evaluatorcheck command-line program.
+ *
+ *  The evaluatorcheck command-line program.  It writes a small feature store, with
+ *  FeatureStoreWriter, whose matrices under a threshold classifier are worked out by
+ *  hand, and evaluates the classifier against it through a FeatureEvaluator and sweeps
+ *  its threshold through a ParameterSweep.  It also writes a random store of more
+ *  runfiles and cross-validates on it a classifier whose threshold is the mean size of
+ *  the particles it is trained on.  It checks that:
+ *
+ *    - the rows whose features are all NaN (never filled, or filled with NaN) are left
+ *      out, and the rows with some features are kept;
+ *    - the matrix of every runfile, of some runfiles and of the whole store are the
+ *      hand-computed ones, with 1 and with several jobs;
+ *    - a classifier returning a class outside the vocabulary is rejected;
+ *    - the table written by a sweep of the threshold, with 1 and with several jobs, has
+ *      a row per threshold with its hand-computed patches, accuracy and kappa;
+ *    - the folds of the cross-validation are disjoint and cover every runfile, each is
+ *      trained on the others and its matrix is that of its runfiles under the classifier
+ *      so trained, the pooled matrix is the sum of the fold matrices, the results are
+ *      the same with 1 and with several jobs and the written results file holds them.
+ *
+ *    evaluatorcheck [--seed N] [--dir D]
+ *
+ *  The first mismatch is reported and the program fails; otherwise it reports the
+ *  evaluations checked and succeeds.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include <boost/filesystem.hpp>
+  #include <boost/lexical_cast.hpp>
+
+  #include <algorithm>
+  #include <fstream>
+  #include <iostream>
+  #include <limits>
+  #include <mutex>
+  #include <random>
+  #include <sstream>
+  #include <stdexcept>
+  #include <string>
+  #include <vector>
+
+  #include <cmath>
+  #include <cstdlib>
+
+  #include "ClassVocabulary.h"
+  #include "ConfusionMatrix.h"
+  #include "CrossValidation.h"
+  #include "FeatureEvaluator.h"
+  #include "FeatureStore.h"
+  #include "ParameterSweep.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+        const APRT::ClassId A = 0;  /**< @brief  the class of the small particles */
+        const APRT::ClassId B = 1;  /**< @brief  the class of the large particles */
+
+        const float Missing = std::numeric_limits<float>::quiet_NaN();
+
+/**
+ *  @brief  A row of the hand-computed store: its size and shade features and its user
+ *          class, or no row filled at all.
+ */
+
+        struct Row
+          {
+            bool           filled;  /**< @brief  whether the row is filled   */
+            float          size;    /**< @brief  the first feature          */
+            float          shade;   /**< @brief  the second feature         */
+            APRT::ClassId  acl;     /**< @brief  the user class             */
+          };
+
+/**
+ *  The rows of the three runfiles of the store: the classifier calls a particle B if its
+ *  size is over 4.5, so run0 agrees everywhere, run1 has one particle of each class
+ *  miscalled and run2 one A called B.  The rows without features are left out.
+ */
+
+        typedef std::vector<std::vector<Row>> RunfileRows;
+
+        const RunfileRows Rows =
+          {
+            {{true,1,0,A},        {true,5,1,B},     {true,9,2,B},       {false,0,0,A}},
+            {{true,2,3,A},        {true,7,4,A},     {true,4,5,B},       {true,Missing,Missing,B}},
+            {{false,0,0,A},       {true,6,6,B},     {true,3,Missing,A}, {true,8,Missing,A}}
+          };
+
+/**
+ *  Throws a mismatch report.
+ */
+
+        void Fail(const std::string& what)
+          {
+            throw std::runtime_error(what);
+          }
+
+/**
+ *  Classifies a particle by its size.
+ */
+
+        APRT::ClassId Threshold(const float* const features)
+          {
+            return ((features[0] > 4.5f) ? B : A);
+          }
+
+/**
+ *  Returns the hand-computed matrix of a runfile (counts by apr and user class).
+ */
+
+        APRT::ConfusionMatrix<> Expected(const uint32_t runfile)
+          {
+            APRT::ConfusionMatrix<> matrix;
+            switch (runfile)
+              {
+                case 0:
+                  matrix(A,A) = 1;
+                  matrix(B,B) = 2;
+                  break;
+                case 1:
+                  matrix(A,A) = 1;
+                  matrix(B,A) = 1;
+                  matrix(A,B) = 1;
+                  break;
+                default:
+                  matrix(B,B) = 1;
+                  matrix(A,A) = 1;
+                  matrix(B,A) = 1;
+                  break;
+              }
+            return (matrix);
+          }
+
+/**
+ *  Checks that two matrices have the same counts.
+ */
+
+        void CheckMatrix(const APRT::ConfusionMatrix<>& matrix,
+                         const APRT::ConfusionMatrix<>& expected,
+                         const std::string&             what)
+          {
+            for (uint32_t pcl = 0; pcl < expected.Dim1(); ++pcl)
+              {
+                for (uint32_t acl = 0; acl < expected.Dim2(); ++acl)
+                  {
+                    if (matrix(pcl,acl) != expected(pcl,acl))
+                      {
+                        Fail(what + ": count (" + std::to_string(pcl) + "," + std::to_string(acl) + ") is " +
+                             std::to_string(matrix(pcl,acl)) + ", not " + std::to_string(expected(pcl,acl)));
+                      }
+                  }
+              }
+          }
+
+/**
+ *  Writes a store of the rows of each runfile.
+ */
+
+        void WriteStore(const std::string& path,
+                        const RunfileRows& rows)
+          {
+            std::vector<std::string> runfilenames;
+            std::vector<uint64_t>    firstrows(1,0);
+            for (uint32_t runfile = 0; runfile < rows.size(); ++runfile)
+              {
+                runfilenames.push_back("run" + std::to_string(runfile));
+                firstrows.push_back(firstrows.back() + rows[runfile].size());
+              }
+            APRT::FeatureStoreWriter writer(path,{"size","shade"},runfilenames,firstrows,1);
+            for (uint32_t runfile = 0; runfile < rows.size(); ++runfile)
+              {
+                for (uint32_t row = 0; row < rows[runfile].size(); ++row)
+                  {
+                    const Row& values = rows[runfile][row];
+                    if (values.filled)
+                      {
+                        const float features[] = {values.size,values.shade};
+                        writer.Fill(firstrows[runfile] + row,features,values.acl);
+                      }
+                  }
+              }
+            writer.Close();
+          }
+
+/**
+ *  Checks the evaluation of the threshold classifier, returning the evaluations checked.
+ */
+
+        uint32_t CheckEvaluate(const APRT::FeatureEvaluator& corpus)
+          {
+            const uint64_t firstpatches[] = {0,3,6,9};
+            if ((corpus.Features() != 2) || (corpus.Runfiles().size() != Rows.size()) || (corpus.Patches() != 9))
+              {
+                Fail("the store loaded " + std::to_string(corpus.Patches()) + " particles, not 9");
+              }
+            for (uint32_t runfile = 0; runfile <= Rows.size(); ++runfile)
+              {
+                if (corpus.FirstPatch(runfile) != firstpatches[runfile])
+                  {
+                    Fail("the particles of run" + std::to_string(runfile) + " start at " +
+                         std::to_string(corpus.FirstPatch(runfile)));
+                  }
+              }
+            if ((corpus.Label(4) != A) || (corpus.Label(5) != B) || (corpus.Values(8)[0] != 8))
+              {
+                Fail("the particles of run1 and run2 are not those of the store");
+              }
+
+            uint32_t evaluations = 0;
+            APRT::ConfusionMatrix<> total;
+            for (uint32_t runfile = 0; runfile < Rows.size(); ++runfile)
+              {
+                total += Expected(runfile);
+              }
+            for (const uint32_t jobs : {1U,3U})
+              {
+                const std::string                    what = "--jobs " + std::to_string(jobs);
+                std::vector<APRT::ConfusionMatrix<>> runfiles;
+                CheckMatrix(corpus.Evaluate(Threshold,jobs,&runfiles),total,what + " total");
+                if (runfiles.size() != Rows.size())
+                  {
+                    Fail(what + ": " + std::to_string(runfiles.size()) + " runfile matrices");
+                  }
+                for (uint32_t runfile = 0; runfile < Rows.size(); ++runfile)
+                  {
+                    CheckMatrix(runfiles[runfile],Expected(runfile),what + " run" + std::to_string(runfile));
+                  }
+                APRT::ConfusionMatrix<> some = Expected(0);
+                some += Expected(2);
+                CheckMatrix(corpus.Evaluate(Threshold,{0,2},jobs),some,what + " run0 and run2");
+                evaluations += 2;
+              }
+            return (evaluations);
+          }
+
+/**
+ *  Checks that a classifier returning a class outside the vocabulary is rejected.
+ */
+
+        void CheckVocabulary(const APRT::FeatureEvaluator& corpus)
+          {
+            const APRT::Classifier outside = [](const float* const features)
+              {
+                return ((features[0] > 8.5f) ? APRT::ClassId(APRT::ClassVocabulary::Size) : A);
+              };
+            try
+              {
+                corpus.Evaluate(outside,2);
+              }
+            catch (const std::runtime_error& e)
+              {
+                if (std::string(e.what()).find("run0, which is not in the vocabulary") == std::string::npos)
+                  {
+                    Fail(std::string("the class outside the vocabulary was reported as: ") + e.what());
+                  }
+                return;
+              }
+            Fail("a class outside the vocabulary was counted");
+          }
+
+/**
+ *  Checks the table of a sweep of the threshold, returning the sweeps checked.  Of the
+ *  9 particles (5 A, 4 B), the thresholds call all B, 4 A and 5 B (3 and 3 right), 6 A
+ *  and 3 B (3 and 1 right) and all A, so the accuracies are 4/9, 6/9, 4/9 and 5/9 and
+ *  the kappas 0, 14/41, -6/39 and 0.
+ */
+
+        uint32_t CheckSweep(const APRT::FeatureEvaluator& corpus,
+                            const std::string&            directory)
+          {
+            const std::vector<std::vector<float>> thresholds = {{0.5f},{4.5f},{6.5f},{10}};
+            const double accuracies[] = {4.0 / 9,6.0 / 9,4.0 / 9,5.0 / 9};
+            const double kappas[]     = {0,14.0 / 41,-6.0 / 39,0};
+
+            uint32_t sweeps = 0;
+            APRT::ParameterSweep sweep(corpus,[](const float* const features, const std::vector<float>& parameters)
+              {
+                return ((features[0] > parameters[0]) ? B : A);
+              });
+            for (const uint32_t jobs : {1U,3U})
+              {
+                const std::string what = "the sweep with --jobs " + std::to_string(jobs);
+                const std::string path = directory + "/Sweep" + std::to_string(jobs) + ".txt";
+                sweep.Run(thresholds,jobs);
+                sweep.Write(path,{"threshold"});
+
+                std::ifstream stream(path.c_str());
+                std::string   line;
+                if (!std::getline(stream,line) ||
+                    (line != "configuration\tthreshold\tpatches\taccuracy\tprecision\trecall\tf1\tkappa"))
+                  {
+                    Fail(what + ": the header is " + line);
+                  }
+                for (uint32_t configuration = 0; configuration < thresholds.size(); ++configuration)
+                  {
+                    std::getline(stream,line);
+                    std::istringstream       row(line);
+                    std::vector<std::string> fields;
+                    std::string              field;
+                    while (std::getline(row,field,'\t'))
+                      {
+                        fields.push_back(field);
+                      }
+                    if ((fields.size() != 8) || (fields[0] != std::to_string(configuration)) ||
+                        (std::stod(fields[1]) != thresholds[configuration][0]) || (fields[2] != "9") ||
+                        (std::fabs(std::stod(fields[3]) - accuracies[configuration]) > 1e-6) ||
+                        (std::fabs(std::stod(fields[7]) - kappas[configuration]) > 1e-6))
+                      {
+                        Fail(what + ": row " + std::to_string(configuration) + " is " + line);
+                      }
+                  }
+                if (std::getline(stream,line))
+                  {
+                    Fail(what + ": an extra row " + line);
+                  }
+                ++sweeps;
+              }
+            return (sweeps);
+          }
+
+/**
+ *  Returns the rows of twelve random runfiles of up to 40 particles, their sizes from 0
+ *  to 10, classed B (or C) mostly over 5; one runfile has no particle measured.
+ */
+
+        RunfileRows RandomRows(const uint64_t seed)
+          {
+            std::mt19937_64                       engine(seed);
+            std::uniform_real_distribution<float> size(0,10);
+            std::normal_distribution<float>       noise(0,1.5f);
+            RunfileRows                           rows(12);
+            for (uint32_t runfile = 0; runfile < rows.size(); ++runfile)
+              {
+                const uint32_t count = 1 + uint32_t(engine() % 40);
+                for (uint32_t row = 0; row < count; ++row)
+                  {
+                    const float         value = size(engine);
+                    const APRT::ClassId acl   = (value + noise(engine) <= 5) ? A : ((engine() % 4 == 0) ? 2 : B);
+                    rows[runfile].push_back(Row{runfile != 5,value,float(row),acl});
+                  }
+              }
+            return (rows);
+          }
+
+/**
+ *  Returns a classifier calling B the particles larger than the mean size of those of
+ *  some runfiles.
+ */
+
+        APRT::Classifier Train(const APRT::FeatureEvaluator& corpus,
+                               const std::vector<uint32_t>&  runfiles)
+          {
+            double   sum   = 0;
+            uint64_t count = 0;
+            for (const uint32_t runfile : runfiles)
+              {
+                for (uint64_t patch = corpus.FirstPatch(runfile); patch < corpus.FirstPatch(runfile + 1); ++patch)
+                  {
+                    sum += corpus.Values(patch)[0];
+                    ++count;
+                  }
+              }
+            const float threshold = (count != 0) ? float(sum / count) : 5;
+            return ([threshold](const float* const features)
+              {
+                return ((features[0] > threshold) ? B : A);
+              });
+          }
+
+/**
+ *  Checks the results file written by a cross-validation: a matrix labeled "fold N" per
+ *  fold, then one labeled "pooled", each a line per row of counts followed by tabs.
+ */
+
+        void CheckResults(const APRT::CrossValidation& validation,
+                          const std::string&           path)
+          {
+            std::ifstream stream(path.c_str());
+            std::string   line;
+            for (uint32_t fold = 0; fold <= validation.Folds(); ++fold)
+              {
+                const bool                     pooled = (fold == validation.Folds());
+                const std::string              label  = pooled ? "pooled" : "fold " + std::to_string(fold + 1);
+                const APRT::ConfusionMatrix<>& matrix = pooled ? validation.Pooled() : validation.Matrix(fold);
+                if (!std::getline(stream,line) || (line != label))
+                  {
+                    Fail("the results file has " + line + " for " + label);
+                  }
+                for (uint32_t pcl = 0; pcl < matrix.Dim1(); ++pcl)
+                  {
+                    std::string expected;
+                    for (uint32_t acl = 0; acl < matrix.Dim2(); ++acl)
+                      {
+                        expected += std::to_string(matrix(pcl,acl)) + "\t";
+                      }
+                    if (!std::getline(stream,line) || (line != expected))
+                      {
+                        Fail("the results file has row " + std::to_string(pcl) + " of " + label + " as " + line);
+                      }
+                  }
+              }
+            if (std::getline(stream,line))
+              {
+                Fail("the results file has an extra line " + line);
+              }
+          }
+
+/**
+ *  Checks a cross-validation over a random store, returning the runs checked.
+ */
+
+        uint32_t CheckCrossValidation(const uint64_t     seed,
+                                      const std::string& directory)
+          {
+            const RunfileRows rows = RandomRows(seed);
+            WriteStore(directory + "/Random.store",rows);
+            const APRT::FeatureEvaluator corpus(directory + "/Random.store");
+            const uint32_t               folds = 4;
+//
+//  Check the folds: disjoint, in list order and together every runfile ...
+//
+            const APRT::CrossValidation serial(corpus,folds);
+            std::vector<uint32_t>       fold(rows.size(),folds);
+            for (uint32_t index = 0; index < folds; ++index)
+              {
+                const std::vector<uint32_t>& runfiles = serial.Runfiles(index);
+                if (runfiles.empty() || !std::is_sorted(runfiles.begin(),runfiles.end()))
+                  {
+                    Fail("fold " + std::to_string(index) + " is empty or out of list order");
+                  }
+                for (const uint32_t runfile : runfiles)
+                  {
+                    if ((runfile >= rows.size()) || (fold[runfile] != folds))
+                      {
+                        Fail("run" + std::to_string(runfile) + " is in more than one fold");
+                      }
+                    fold[runfile] = index;
+                  }
+              }
+            if (std::count(fold.begin(),fold.end(),folds) != 0)
+              {
+                Fail("a runfile is in no fold");
+              }
+//
+//  ... then run them, serially and concurrently, checking that each fold is trained on
+//  the others and counts its runfiles under the classifier so trained ...
+//
+            uint32_t                             runs = 0;
+            std::vector<APRT::ConfusionMatrix<>> first;
+            for (const uint32_t jobs : {1U,4U})
+              {
+                const std::string     what = "the cross-validation with --jobs " + std::to_string(jobs);
+                APRT::CrossValidation validation(corpus,folds);
+                std::mutex            mutex;
+                uint32_t              trained = 0;
+                validation.Run([&](const APRT::FeatureEvaluator& trainer, const std::vector<uint32_t>& runfiles)
+                  {
+                    std::vector<uint32_t> expected;
+                    for (uint32_t runfile = 0; runfile < rows.size(); ++runfile)
+                      {
+                        expected.push_back(runfile);
+                      }
+                    expected.erase(std::remove_if(expected.begin(),expected.end(),[&](const uint32_t runfile)
+                      {
+                        return (std::find(runfiles.begin(),runfiles.end(),runfile) != runfiles.end());
+                      }),expected.end());
+                    bool held = false;
+                    for (uint32_t index = 0; index < folds; ++index)
+                      {
+                        held = held || (serial.Runfiles(index) == expected);
+                      }
+                    if ((&trainer != &corpus) || !held)
+                      {
+                        Fail(what + ": a fold is not trained on the other folds");
+                      }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++trained;
+                    return (Train(trainer,runfiles));
+                  },jobs);
+                if (trained != folds)
+                  {
+                    Fail(what + ": " + std::to_string(trained) + " folds trained");
+                  }
+
+                APRT::ConfusionMatrix<> sum;
+                for (uint32_t index = 0; index < folds; ++index)
+                  {
+                    if (validation.Runfiles(index) != serial.Runfiles(index))
+                      {
+                        Fail(what + ": the runfiles of fold " + std::to_string(index) + " differ");
+                      }
+                    std::vector<uint32_t> training;
+                    for (uint32_t runfile = 0; runfile < rows.size(); ++runfile)
+                      {
+                        if (fold[runfile] != index)
+                          {
+                            training.push_back(runfile);
+                          }
+                      }
+                    const APRT::ConfusionMatrix<> expected = corpus.Evaluate(Train(corpus,training),
+                                                                             serial.Runfiles(index),1);
+                    CheckMatrix(validation.Matrix(index),expected,what + " fold " + std::to_string(index));
+                    if (!first.empty())
+                      {
+                        CheckMatrix(validation.Matrix(index),first[index],what + " fold " + std::to_string(index));
+                      }
+                    sum += validation.Matrix(index);
+                  }
+                CheckMatrix(validation.Pooled(),sum,what + " pooled");
+                if (first.empty())
+                  {
+                    for (uint32_t index = 0; index < folds; ++index)
+                      {
+                        first.push_back(validation.Matrix(index));
+                      }
+                  }
+//
+//  ... and that the results file holds the results.
+//
+                const std::string path = directory + "/Validation" + std::to_string(jobs) + ".txt";
+                validation.Write(path);
+                CheckResults(validation,path);
+                ++runs;
+              }
+            return (runs);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The main entry point to the program.
+ *
+ *  @param [in]  argc  the number of input arguments
+ *  @param [in]  argv  the strings of input arguments
+ *
+ *  @return  EXIT_SUCCESS if every evaluation checks out, otherwise EXIT_FAILURE
+ */
+
+  int main(int argc, char* argv[])
+    {
+      uint64_t    seed = 1;
+      std::string directory = (boost::filesystem::temp_directory_path() /
+                               boost::filesystem::unique_path("evaluatorcheck-%%%%%%%%")).string();
+      try
+        {
+          for (int i = 1; i < argc; ++i)
+            {
+              const std::string argument(argv[i]);
+              if ((argument == "--seed") && (i + 1 < argc))
+                {
+                  seed = boost::lexical_cast<uint64_t>(argv[++i]);
+                }
+              else if ((argument == "--dir") && (i + 1 < argc))
+                {
+                  directory = argv[++i];
+                }
+              else
+                {
+                  std::cout << "Usage: evaluatorcheck [--seed N] [--dir D]" << std::endl;
+                  return (EXIT_FAILURE);
+                }
+            }
+          boost::filesystem::remove_all(directory);
+          boost::filesystem::create_directories(directory);
+          WriteStore(directory + "/Features.store",Rows);
+          const APRT::FeatureEvaluator corpus(directory + "/Features.store");
+          const uint32_t evaluations = CheckEvaluate(corpus);
+          CheckVocabulary(corpus);
+          const uint32_t sweeps = CheckSweep(corpus,directory);
+          const uint32_t runs   = CheckCrossValidation(seed,directory);
+          boost::filesystem::remove_all(directory);
+
+          std::cout << "Checked "
+                    << evaluations
+                    << " evaluations, "
+                    << sweeps
+                    << " sweeps and "
+                    << runs
+                    << " cross-validations (seed "
+                    << seed
+                    << ")."
+                    << std::endl;
+          return (EXIT_SUCCESS);
+        }
+
+      catch (const boost::bad_lexical_cast&)
+        {
+          std::cout << "Invalid argument list. Try again." << std::endl;
+        }
+
+      catch (const std::exception& e)
+        {
+          std::cout << "Seed "
+                    << seed
+                    << ": "
+                    << e.what()
+                    << std::endl;
+        }
+
+      return (EXIT_FAILURE);
+    }
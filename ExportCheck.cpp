@@ -0,0 +1,777 @@
+/**
+ *  @file  ExportCheck.cpp
+ *
+ *  @brief  The exportcheck command-line program.
+ *
+ *  The exportcheck command-line program.  It writes a small random runfile list (acl and
+ *  pcl text of a few runfiles, one of them listed twice) and extracts a subsample of it
+ *  through PatchExtractor::Sort() in every layout, decoding the particles with a synthetic
+ *  ParticleSource whose patches and features are functions of the runfile and patch
+ *  index.  Some runfiles have more particles than user classifications, some fewer and
+ *  one has no particles at all.  It checks that:
+ *
+ *    - ByClass and ByRunfile write every particle, as the expected PPM, into the
+ *      directory of its user class (NONE past the end of the user classifications) or of
+ *      its runfile, and write nothing else;
+ *    - Packed writes every particle of each distinct runfile once into the container of
+ *      its user class, which reads back (and finds it) through PatchContainer;
+ *    - Tensor and Features write a row per user classification of each distinct runfile,
+ *      with its key, labels and patch or features, as read back through PatchTensor and
+ *      FeatureStore (a row without a particle black, or NaN, and labelled NONE);
+ *    - the mismatched runfiles, and only those, are reported;
+ *    - the output is the same with 1 and with several --jobs and --particle-jobs, and
+ *      through the acl cache.
+ *
+ *    exportcheck [--seed N] [--dir D]
+ *
+ *  The first mismatch is reported and the program fails; otherwise it reports the
+ *  extractions checked and succeeds.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include <boost/filesystem.hpp>
+  #include <boost/lexical_cast.hpp>
+
+  #include <algorithm>
+  #include <fstream>
+  #include <iostream>
+  #include <map>
+  #include <memory>
+  #include <random>
+  #include <sstream>
+  #include <stdexcept>
+  #include <string>
+  #include <vector>
+
+  #include <cmath>
+  #include <cstdlib>
+  #include <cstring>
+
+  #include "ClassVocabulary.h"
+  #include "FeatureStore.h"
+  #include "ParticleSource.h"
+  #include "PatchContainer.h"
+  #include "PatchExtractor.h"
+  #include "PatchTensor.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+        const uint32_t Subsample = 2;  /**< @brief  the subsample extracted (of three)     */
+        const uint32_t Size      = 6;  /**< @brief  the height and width of a tensor row */
+
+/**
+ *  @brief  The classifications and particles of a synthetic runfile.
+ */
+
+        struct SyntheticRunfile
+          {
+            std::string           name;       /**< @brief  the runfile name                   */
+            std::vector<uint8_t>  acl;        /**< @brief  the user classes of the subsample  */
+            std::vector<uint8_t>  pcl;        /**< @brief  the apr classes of the subsample   */
+            uint32_t              particles;  /**< @brief  the particles of the subsample     */
+          };
+
+/**
+ *  @brief  A synthetic runfile list: the runfiles (each once) and the list order.
+ */
+
+        struct SyntheticList
+          {
+            std::string                    directory;  /**< @brief  the runfile directory      */
+            std::string                    path;       /**< @brief  the runfile list path      */
+            std::vector<SyntheticRunfile>  runfiles;   /**< @brief  the distinct runfiles      */
+            std::vector<uint32_t>          listed;     /**< @brief  the runfile of each line   */
+          };
+
+/**
+ *  Throws a mismatch report.
+ */
+
+        void Fail(const std::string& what)
+          {
+            throw std::runtime_error(what);
+          }
+
+/**
+ *  Returns a well-mixed hash of a runfile and patch index (splitmix64).
+ */
+
+        uint64_t Mix(const uint32_t runfile,
+                     const uint32_t patch)
+          {
+            uint64_t hash = (uint64_t(runfile) << 32 | patch) + 0x9E3779B97F4A7C15ULL;
+            hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+            return (hash ^ (hash >> 31));
+          }
+
+/**
+ *  Returns the patch of a particle: up to 9 x 9 pixels, none of them black, and of one
+ *  colour if it does not fit a tensor row (so its scaled copy is easily recognized).
+ */
+
+        APRT::PatchImage Patch(const uint32_t runfile,
+                               const uint32_t patch)
+          {
+            const uint64_t   hash = Mix(runfile,patch);
+            APRT::PatchImage image;
+            image.width  = 1 + uint32_t(hash % 9);
+            image.height = 1 + uint32_t((hash >> 8) % 9);
+            const bool uniform = (image.width > Size) || (image.height > Size);
+            for (uint32_t byte = 0; byte < image.width * image.height * 3; ++byte)
+              {
+                image.pixels.push_back(uint8_t(1 + ((hash >> 16) + (uniform ? 0 : 37 * byte)) % 255));
+              }
+            return (image);
+          }
+
+/**
+ *  Returns the features of a particle: its patch index, its runfile and its patch area.
+ */
+
+        std::vector<float> Features(const uint32_t runfile,
+                                    const uint32_t patch)
+          {
+            const APRT::PatchImage image = Patch(runfile,patch);
+            return (std::vector<float>{float(patch),float(runfile),float(image.width * image.height)});
+          }
+
+/**
+ *  The particles of a synthetic runfile, decoded and measured from their runfile and
+ *  patch index alone (so any number of threads may call it).
+ */
+
+        class SyntheticSource : public APRT::ParticleSource
+          {
+            public:
+              SyntheticSource(const uint32_t runfile, const uint32_t particles)
+                : runfile(runfile), particles(particles) {}
+
+            public:
+              uint32_t  Particles() const override
+                {
+                  return (this->particles);
+                }
+              void      Decode(const uint32_t index, APRT::PatchImage& image) const override
+                {
+                  if (index >= this->particles)
+                    {
+                      Fail("a particle past the end of the runfile was decoded");
+                    }
+                  image = Patch(this->runfile,index);
+                }
+              void      Measure(const uint32_t index, float* const features) const override
+                {
+                  if (index >= this->particles)
+                    {
+                      Fail("a particle past the end of the runfile was measured");
+                    }
+                  const std::vector<float> values = Features(this->runfile,index);
+                  std::memcpy(features,values.data(),values.size() * sizeof(float));
+                }
+            private:
+              const uint32_t  runfile;
+                /**< @brief  the runfile id */
+              const uint32_t  particles;
+                /**< @brief  the number of particles */
+          };
+
+/**
+ *  Writes some text to a file.
+ */
+
+        void WriteText(const std::string& path,
+                       const std::string& text)
+          {
+            std::ofstream stream(path.c_str(),std::ios_base::binary | std::ios_base::trunc);
+            stream.write(text.data(),std::streamsize(text.size()));
+            stream.close();
+            if (!stream)
+              {
+                Fail("unable to write " + path);
+              }
+          }
+
+/**
+ *  Returns the whole of a file, or "missing" if there is no such file.
+ */
+
+        std::string ReadText(const std::string& path)
+          {
+            std::ifstream stream(path.c_str(),std::ios_base::binary);
+            if (!stream)
+              {
+                return ("missing");
+              }
+            std::ostringstream text;
+            text << stream.rdbuf();
+            return (text.str());
+          }
+
+/**
+ *  Returns three <CLASS> blocks of random classes, the given ones as the extracted
+ *  subsample.
+ */
+
+        std::string ClassText(std::mt19937_64&            engine,
+                              const std::vector<uint8_t>& labels)
+          {
+            std::string text;
+            for (uint32_t ssn = 1; ssn <= 3; ++ssn)
+              {
+                text += "<CLASS>";
+                const uint32_t patches = (ssn == Subsample) ? uint32_t(labels.size()) : uint32_t(engine() % 10);
+                for (uint32_t patch = 0; patch < patches; ++patch)
+                  {
+                    const uint8_t label = (ssn == Subsample) ? labels[patch] :
+                                                               uint8_t(engine() % APRT::ClassVocabulary::Size);
+                    text += (patch != 0) ? "," : "";
+                    text += std::string(APRT::ClassVocabulary::Code(APRT::ClassId(label)));
+                  }
+                text += "</CLASS>\n";
+              }
+            return (text);
+          }
+
+/**
+ *  Writes a random runfile list: five runfiles, with as many particles as user
+ *  classifications, three more, two fewer, none and again as many (and fewer apr than
+ *  user classifications), the second listed twice.
+ */
+
+        SyntheticList MakeList(const std::string& directory,
+                               const uint64_t     seed)
+          {
+            std::mt19937_64 engine(seed);
+            SyntheticList   list;
+            list.directory = directory + "/runfiles/";
+            list.path      = directory + "/list.txt";
+            boost::filesystem::create_directories(list.directory);
+            const int extra[] = {0,3,-2,-2,0};
+            for (uint32_t runfile = 0; runfile < 5; ++runfile)
+              {
+                SyntheticRunfile synthetic;
+                synthetic.name = "run" + std::to_string(runfile);
+                const uint32_t patches = (runfile == 3) ? 2 : 8 + uint32_t(engine() % 30);
+                for (uint32_t patch = 0; patch < patches; ++patch)
+                  {
+                    synthetic.acl.push_back(uint8_t(engine() % APRT::ClassVocabulary::Size));
+                  }
+                for (uint32_t patch = 0; patch < patches - ((runfile == 4) ? 3 : 0); ++patch)
+                  {
+                    synthetic.pcl.push_back(uint8_t(engine() % APRT::ClassVocabulary::Size));
+                  }
+                synthetic.particles = uint32_t(int(patches) + extra[runfile]);
+                WriteText(list.directory + synthetic.name + ".acl",ClassText(engine,synthetic.acl));
+                WriteText(list.directory + synthetic.name + ".pcl",ClassText(engine,synthetic.pcl));
+                list.runfiles.push_back(synthetic);
+              }
+            list.listed = {0,1,2,1,3,4};
+            std::string text = list.directory + "\n";
+            for (const uint32_t runfile : list.listed)
+              {
+                text += list.runfiles[runfile].name + "\n";
+              }
+            WriteText(list.path,text);
+            return (list);
+          }
+
+/**
+ *  Returns the user class of a patch of a runfile (NONE past the end of the user
+ *  classifications).
+ */
+
+        APRT::ClassId Acl(const SyntheticRunfile& runfile,
+                          const uint32_t          patch)
+          {
+            return ((patch < runfile.acl.size()) ? APRT::ClassId(runfile.acl[patch]) : APRT::ClassVocabulary::None);
+          }
+
+/**
+ *  Returns a patch as a binary PPM file.
+ */
+
+        std::string Ppm(const APRT::PatchImage& image)
+          {
+            return ("P6\n" + std::to_string(image.width) + " " + std::to_string(image.height) + "\n255\n" +
+                    std::string(image.pixels.begin(),image.pixels.end()));
+          }
+
+/**
+ *  Extracts the subsample of the list in a layout, the progress lines going to the log.
+ */
+
+        void Extract(const SyntheticList&    list,
+                     const std::string&      destination,
+                     const APRT::PatchLayout layout,
+                     const uint32_t          jobs,
+                     const uint32_t          particlejobs,
+                     const std::string&      cache,
+                     std::ostringstream&     log)
+          {
+            APRT::SortOptions options;
+            options.jobs         = jobs;
+            options.particlejobs = particlejobs;
+            options.cache        = cache;
+            options.extract      = layout;
+            options.patchsize    = Size;
+            options.features     = {"patch","runfile","area"};
+            options.particles    = [&list](const std::string& path, const uint32_t ssn)
+              {
+                for (uint32_t runfile = 0; runfile < list.runfiles.size(); ++runfile)
+                  {
+                    if ((path == list.directory + list.runfiles[runfile].name) && (ssn == Subsample))
+                      {
+                        return (std::unique_ptr<APRT::ParticleSource>(
+                                    new SyntheticSource(runfile,list.runfiles[runfile].particles)));
+                      }
+                  }
+                Fail("particles of " + path + " subsample " + std::to_string(ssn) + " were opened");
+                return (std::unique_ptr<APRT::ParticleSource>());
+              };
+            std::streambuf* const console = std::cout.rdbuf(log.rdbuf());
+            try
+              {
+                APRT::PatchExtractor(destination,uint8_t(Subsample),options).Sort(list.path);
+              }
+            catch (...)
+              {
+                std::cout.rdbuf(console);
+                throw;
+              }
+            std::cout.rdbuf(console);
+          }
+
+/**
+ *  Checks that the runfiles whose particles and user classifications differ in number,
+ *  and only those, were reported.
+ */
+
+        void CheckWarnings(const SyntheticList& list,
+                           const std::string&   log,
+                           const std::string&   what)
+          {
+            for (const SyntheticRunfile& runfile : list.runfiles)
+              {
+                const std::string warning = "Warning: " + runfile.name + " subsample " + std::to_string(Subsample) +
+                                            " has " + std::to_string(runfile.particles) + " particles and " +
+                                            std::to_string(runfile.acl.size()) + " user classifications.";
+                if ((log.find(warning) != std::string::npos) != (runfile.particles != runfile.acl.size()))
+                  {
+                    Fail(what + ": mismatch warning of " + runfile.name);
+                  }
+              }
+          }
+
+/**
+ *  Checks the patch files of a ByClass or ByRunfile extraction, returning them (by path
+ *  under the destination) for comparison with another extraction.
+ */
+
+        std::map<std::string,std::string> CheckFiles(const SyntheticList& list,
+                                                     const std::string&   destination,
+                                                     const bool           byclass,
+                                                     const std::string&   what)
+          {
+            std::map<std::string,std::string> expected;
+            for (uint32_t runfile = 0; runfile < list.runfiles.size(); ++runfile)
+              {
+                const SyntheticRunfile& synthetic = list.runfiles[runfile];
+                for (uint32_t patch = 0; patch < synthetic.particles; ++patch)
+                  {
+                    const std::string directory = byclass ? std::string(APRT::ClassVocabulary::Code(Acl(synthetic,patch))) :
+                                                            synthetic.name;
+                    expected[directory + "/" + synthetic.name + "_" + std::to_string(Subsample) + "_" +
+                             std::to_string(patch) + ".ppm"] = Ppm(Patch(runfile,patch));
+                  }
+              }
+            std::map<std::string,std::string> actual;
+            for (boost::filesystem::recursive_directory_iterator entry(destination), end; entry != end; ++entry)
+              {
+                if (boost::filesystem::is_regular_file(entry->path()))
+                  {
+                    const std::string path = entry->path().parent_path().filename().string() + "/" +
+                                             entry->path().filename().string();
+                    actual[path] = ReadText(entry->path().string());
+                  }
+              }
+            for (const auto& file : expected)
+              {
+                const auto found = actual.find(file.first);
+                if ((found == actual.end()) || (found->second != file.second))
+                  {
+                    Fail(what + ": " + file.first + " is missing or wrong");
+                  }
+              }
+            if (actual.size() != expected.size())
+              {
+                Fail(what + ": " + std::to_string(actual.size()) + " files written, " +
+                     std::to_string(expected.size()) + " expected");
+              }
+            if (byclass)
+              {
+                for (uint32_t id = 0; id < APRT::ClassVocabulary::Size; ++id)
+                  {
+                    if (!boost::filesystem::is_directory(destination + "/" +
+                                                         std::string(APRT::ClassVocabulary::Code(APRT::ClassId(id)))))
+                      {
+                        Fail(what + ": a class directory is missing");
+                      }
+                  }
+              }
+            return (actual);
+          }
+
+/**
+ *  Checks the containers of a Packed extraction, returning a description of their
+ *  entries (whose pixel offsets depend on the order of the appends) for comparison with
+ *  another extraction.
+ */
+
+        std::map<std::string,std::string> CheckContainers(const SyntheticList& list,
+                                                          const std::string&   destination,
+                                                          const std::string&   what)
+          {
+            std::map<std::string,std::string> described;
+            uint64_t                          entries = 0;
+            for (uint32_t id = 0; id < APRT::ClassVocabulary::Size; ++id)
+              {
+                const std::string           code(APRT::ClassVocabulary::Code(APRT::ClassId(id)));
+                const APRT::PatchContainer  container(destination + "/" + code + ".patches");
+                if ((container.Code() != code) || (container.Runfiles() != list.runfiles.size()))
+                  {
+                    Fail(what + ": the header of the " + code + " container");
+                  }
+                std::string description;
+                for (uint64_t entry = 0; entry < container.Size(); ++entry)
+                  {
+                    const APRT::PatchEntry& patch = container.Entry(entry);
+                    const uint32_t          runfile = patch.runfile;
+                    if ((runfile >= list.runfiles.size()) ||
+                        (container.Runfile(runfile) != list.runfiles[runfile].name) ||
+                        (patch.subsample != Subsample) ||
+                        (patch.patch >= list.runfiles[runfile].particles) ||
+                        (patch.label != id) || (Acl(list.runfiles[runfile],patch.patch) != id) ||
+                        (container.Find(runfile,Subsample,patch.patch) != &patch))
+                      {
+                        Fail(what + ": entry " + std::to_string(entry) + " of the " + code + " container");
+                      }
+                    const APRT::PatchImage image = Patch(runfile,patch.patch);
+                    if ((patch.width != image.width) || (patch.height != image.height) ||
+                        (std::memcmp(container.Pixels(entry),image.pixels.data(),image.pixels.size()) != 0))
+                      {
+                        Fail(what + ": the pixels of entry " + std::to_string(entry) + " of the " + code + " container");
+                      }
+                    description += std::to_string(runfile) + "_" + std::to_string(patch.patch) + " ";
+                  }
+                entries += container.Size();
+                described[code] = description;
+              }
+            uint64_t particles = 0;
+            for (const SyntheticRunfile& runfile : list.runfiles)
+              {
+                particles += runfile.particles;
+              }
+            if (entries != particles)
+              {
+                Fail(what + ": " + std::to_string(entries) + " patches packed, " + std::to_string(particles) + " expected");
+              }
+            return (described);
+          }
+
+/**
+ *  Checks a tensor row against the patch fitted into it: copied and centred if it fits,
+ *  otherwise scaled (its single colour) to fill the row in one direction, centred.
+ */
+
+        bool CheckRow(const uint8_t* const    row,
+                      const APRT::PatchImage& image)
+          {
+            uint32_t left = Size, right = 0, top = Size, bottom = 0;
+            for (uint32_t y = 0; y < Size; ++y)
+              {
+                for (uint32_t x = 0; x < Size; ++x)
+                  {
+                    if ((row[(y * Size + x) * 3] | row[(y * Size + x) * 3 + 1] | row[(y * Size + x) * 3 + 2]) != 0)
+                      {
+                        left   = std::min(left,x);
+                        right  = std::max(right,x + 1);
+                        top    = std::min(top,y);
+                        bottom = std::max(bottom,y + 1);
+                      }
+                  }
+              }
+            const uint32_t width  = right - left;
+            const uint32_t height = bottom - top;
+            if ((right <= left) || (left != (Size - width) / 2) || (top != (Size - height) / 2))
+              {
+                return (false);
+              }
+            if ((image.width <= Size) && (image.height <= Size))
+              {
+                if ((width != image.width) || (height != image.height))
+                  {
+                    return (false);
+                  }
+                for (uint32_t y = 0; y < height; ++y)
+                  {
+                    if (std::memcmp(row + ((top + y) * Size + left) * 3,&image.pixels[y * image.width * 3],width * 3) != 0)
+                      {
+                        return (false);
+                      }
+                  }
+                return (true);
+              }
+            if ((width != Size) && (height != Size))
+              {
+                return (false);
+              }
+            for (uint32_t y = top; y < bottom; ++y)
+              {
+                for (uint32_t x = left; x < right; ++x)
+                  {
+                    if (std::memcmp(row + (y * Size + x) * 3,image.pixels.data(),3) != 0)
+                      {
+                        return (false);
+                      }
+                  }
+              }
+            return (true);
+          }
+
+/**
+ *  Checks the tensor of a Tensor extraction.
+ */
+
+        void CheckTensor(const SyntheticList& list,
+                         const std::string&   path,
+                         const std::string&   what)
+          {
+            const APRT::PatchTensor tensor(path);
+            if ((tensor.Height() != Size) || (tensor.Width() != Size) || (tensor.Runfiles() != list.runfiles.size()) ||
+                (tensor.Classes() != APRT::ClassVocabulary::Size))
+              {
+                Fail(what + ": the tensor header");
+              }
+            uint64_t row = 0;
+            for (uint32_t runfile = 0; runfile < list.runfiles.size(); ++runfile)
+              {
+                const SyntheticRunfile& synthetic = list.runfiles[runfile];
+                if ((tensor.Runfile(runfile) != synthetic.name) || (tensor.FirstRow(runfile) != row))
+                  {
+                    Fail(what + ": the rows of " + synthetic.name);
+                  }
+                for (uint32_t patch = 0; patch < synthetic.acl.size(); ++patch, ++row)
+                  {
+                    const bool          filled = (patch < synthetic.particles);
+                    const APRT::ClassId acl    = filled ? APRT::ClassId(synthetic.acl[patch]) : APRT::ClassVocabulary::None;
+                    const APRT::ClassId pcl    = (filled && (patch < synthetic.pcl.size())) ?
+                                                     APRT::ClassId(synthetic.pcl[patch]) : APRT::ClassVocabulary::None;
+                    if ((tensor.Acl(row) != acl) || (tensor.Pcl(row) != pcl))
+                      {
+                        Fail(what + ": the labels of row " + std::to_string(row));
+                      }
+                    const uint8_t* const pixels = tensor.Pixels(row);
+                    const bool           fitted = filled ?
+                                                      CheckRow(pixels,Patch(runfile,patch)) :
+                                                      std::all_of(pixels,pixels + Size * Size * 3,
+                                                                  [](const uint8_t byte) { return (byte == 0); });
+                    if (!fitted)
+                      {
+                        Fail(what + ": the pixels of row " + std::to_string(row));
+                      }
+                  }
+              }
+            if (tensor.Rows() != row)
+              {
+                Fail(what + ": " + std::to_string(tensor.Rows()) + " tensor rows, " + std::to_string(row) + " expected");
+              }
+          }
+
+/**
+ *  Checks the feature store of a Features extraction.
+ */
+
+        void CheckStore(const SyntheticList& list,
+                        const std::string&   path,
+                        const std::string&   what)
+          {
+            const APRT::FeatureStore store(path);
+            if ((store.Features() != 3) || (store.Feature(0) != "patch") || (store.Feature(2) != "area") ||
+                (store.Runfiles() != list.runfiles.size()))
+              {
+                Fail(what + ": the store header");
+              }
+            uint64_t row = 0;
+            for (uint32_t runfile = 0; runfile < list.runfiles.size(); ++runfile)
+              {
+                const SyntheticRunfile& synthetic = list.runfiles[runfile];
+                if ((store.Runfile(runfile) != synthetic.name) || (store.FirstRow(runfile) != row))
+                  {
+                    Fail(what + ": the rows of " + synthetic.name);
+                  }
+                for (uint32_t patch = 0; patch < synthetic.acl.size(); ++patch, ++row)
+                  {
+                    const bool          filled = (patch < synthetic.particles);
+                    const APRT::ClassId label  = filled ? APRT::ClassId(synthetic.acl[patch]) : APRT::ClassVocabulary::None;
+                    if ((store.RunfileIds()[row] != runfile) || (store.Subsamples()[row] != Subsample) ||
+                        (store.Patches()[row] != patch) || (store.Labels()[row] != label) ||
+                        (store.Find(runfile,Subsample,patch) != row))
+                      {
+                        Fail(what + ": the key or label of row " + std::to_string(row));
+                      }
+                    const std::vector<float> values = Features(runfile,patch);
+                    for (uint32_t feature = 0; feature < 3; ++feature)
+                      {
+                        const float value = store.Column(feature)[row];
+                        if (filled ? (value != values[feature]) : !std::isnan(value))
+                          {
+                            Fail(what + ": feature " + std::to_string(feature) + " of row " + std::to_string(row));
+                          }
+                      }
+                  }
+              }
+            if (store.Rows() != row)
+              {
+                Fail(what + ": " + std::to_string(store.Rows()) + " store rows, " + std::to_string(row) + " expected");
+              }
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The main entry point to the program.
+ *
+ *  @param [in]  argc  the number of input arguments
+ *  @param [in]  argv  the strings of input arguments
+ *
+ *  @return  EXIT_SUCCESS if every extraction checks out, otherwise EXIT_FAILURE
+ */
+
+  int main(int argc, char* argv[])
+    {
+      uint64_t    seed = 1;
+      std::string directory = (boost::filesystem::temp_directory_path() /
+                               boost::filesystem::unique_path("exportcheck-%%%%%%%%")).string();
+      try
+        {
+          for (int i = 1; i < argc; ++i)
+            {
+              const std::string argument(argv[i]);
+              if ((argument == "--seed") && (i + 1 < argc))
+                {
+                  seed = boost::lexical_cast<uint64_t>(argv[++i]);
+                }
+              else if ((argument == "--dir") && (i + 1 < argc))
+                {
+                  directory = argv[++i];
+                }
+              else
+                {
+                  std::cout << "Usage: exportcheck [--seed N] [--dir D]" << std::endl;
+                  return (EXIT_FAILURE);
+                }
+            }
+          boost::filesystem::remove_all(directory);
+          const SyntheticList list = MakeList(directory,seed);
+//
+//  Extract in every layout, serially, concurrently and through the cache, and check
+//  each extraction and that they all agree ...
+//
+          const struct { APRT::PatchLayout layout; const char* name; } layouts[] =
+            {
+              {APRT::PatchLayout::ByClass,   "class"},
+              {APRT::PatchLayout::ByRunfile, "runfile"},
+              {APRT::PatchLayout::Packed,    "packed"},
+              {APRT::PatchLayout::Tensor,    "tensor"},
+              {APRT::PatchLayout::Features,  "features"}
+            };
+          const struct { uint32_t jobs; uint32_t particlejobs; bool cached; } runs[] =
+            {
+              {1,1,false}, {3,4,false}, {8,2,true}
+            };
+          uint32_t extractions = 0;
+          for (const auto& layout : layouts)
+            {
+              std::map<std::string,std::string> first;
+              for (const auto& run : runs)
+                {
+                  const std::string what = std::string("--extract ") + layout.name +
+                                           " --jobs " + std::to_string(run.jobs) +
+                                           " --particle-jobs " + std::to_string(run.particlejobs) +
+                                           (run.cached ? " --cache" : "");
+                  const std::string destination = directory + "/" + layout.name + "_" + std::to_string(run.jobs);
+                  std::ostringstream log;
+                  Extract(list,destination,layout.layout,run.jobs,run.particlejobs,
+                          run.cached ? directory + "/cache" : std::string(),log);
+                  std::map<std::string,std::string> output;
+                  switch (layout.layout)
+                    {
+                      case APRT::PatchLayout::ByClass:
+                        output = CheckFiles(list,destination,true,what);
+                        break;
+                      case APRT::PatchLayout::ByRunfile:
+                        output = CheckFiles(list,destination,false,what);
+                        break;
+                      case APRT::PatchLayout::Packed:
+                        output = CheckContainers(list,destination,what);
+                        break;
+                      case APRT::PatchLayout::Tensor:
+                        CheckTensor(list,destination + "/Patches.tensor",what);
+                        output["Patches.tensor"] = ReadText(destination + "/Patches.tensor");
+                        break;
+                      default:
+                        CheckStore(list,destination + "/Features.store",what);
+                        output["Features.store"] = ReadText(destination + "/Features.store");
+                        break;
+                    }
+                  if (layout.layout != APRT::PatchLayout::ByRunfile)
+                    {
+                      CheckWarnings(list,log.str(),what);
+                    }
+                  if (first.empty())
+                    {
+                      first = output;
+                    }
+                  else if (output != first)
+                    {
+                      Fail(what + ": the output differs from that of --jobs 1 --particle-jobs 1");
+                    }
+                  ++extractions;
+                }
+            }
+          boost::filesystem::remove_all(directory);
+
+          std::cout << "Checked "
+                    << extractions
+                    << " extractions (seed "
+                    << seed
+                    << ")."
+                    << std::endl;
+          return (EXIT_SUCCESS);
+        }
+
+      catch (const boost::bad_lexical_cast&)
+        {
+          std::cout << "Invalid argument list. Try again." << std::endl;
+        }
+
+      catch (const std::exception& e)
+        {
+          std::cout << "Seed "
+                    << seed
+                    << ": "
+                    << e.what()
+                    << std::endl;
+        }
+
+      return (EXIT_FAILURE);
+    }
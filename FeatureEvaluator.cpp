@@ -0,0 +1,184 @@
+/**
+ *  @file  FeatureEvaluator.cpp
+ *
+ *  @brief  Implementation of the FeatureEvaluator class.
+ *
+ *  Implementation of the FeatureEvaluator class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "FeatureEvaluator.h"
+
+  #include <algorithm>
+  #include <stdexcept>
+  #include <string>
+
+  #include <cmath>
+
+  #include "FeatureStore.h"
+  #include "ParallelFor.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Loads the measured particles of a feature store.
+ *
+ *  @param [in]  path  the store path
+ */
+
+  APRT::FeatureEvaluator::FeatureEvaluator(const std::string& path)
+    {
+      const FeatureStore store(path);
+      this->features = store.Features();
+//
+//  Intern the store's class codes ...
+//
+      std::vector<ClassId> classes;
+      for (uint32_t id = 0; id < store.Classes(); ++id)
+        {
+          classes.push_back(ClassVocabulary::Intern(store.Code(id)));
+        }
+//
+//  ... then turn the measured rows of each runfile from columns into feature vectors ...
+//
+      std::vector<const float*> columns;
+      for (uint32_t feature = 0; feature < this->features; ++feature)
+        {
+          columns.push_back(store.Column(feature));
+        }
+      this->values.reserve(store.Rows() * this->features);
+      this->labels.reserve(store.Rows());
+      this->firstpatches.assign(1,0);
+      for (uint32_t runfile = 0; runfile < store.Runfiles(); ++runfile)
+        {
+          this->runfilenames.emplace_back(store.Runfile(runfile));
+          for (uint64_t row = store.FirstRow(runfile); row < store.FirstRow(runfile + 1); ++row)
+            {
+              bool measured = (this->features == 0);
+              for (uint32_t feature = 0; feature < this->features; ++feature)
+                {
+                  measured = measured || !std::isnan(columns[feature][row]);
+                }
+              if (measured)
+                {
+                  for (uint32_t feature = 0; feature < this->features; ++feature)
+                    {
+                      this->values.push_back(columns[feature][row]);
+                    }
+                  const ClassId label = store.Labels()[row];
+                  this->labels.push_back((label < classes.size()) ? classes[label] : ClassVocabulary::None);
+                }
+            }
+          this->firstpatches.push_back(this->labels.size());
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Classifies every particle and counts the result against its user class.  The
+ *  runfiles are spread over the jobs, each counted into its own matrix.
+ *
+ *  @param [in]   classifier  classifies a feature vector (may be called concurrently)
+ *  @param [in]   jobs        the number of runfiles classified concurrently
+ *  @param [out]  runfiles    the matrix of each runfile (or nullptr)
+ *
+ *  @return  the matrix of all the runfiles
+ *
+ *  @throw  std::runtime_error  if the classifier returns a class outside the vocabulary
+ */
+
+  APRT::ConfusionMatrix<> APRT::FeatureEvaluator::Evaluate(const Classifier&               classifier,
+                                                           const uint32_t                  jobs,
+                                                           std::vector<ConfusionMatrix<>>* runfiles) const
+    {
+      std::vector<ConfusionMatrix<>> matrices(this->runfilenames.size());
+      ParallelFor(0,uint32_t(this->runfilenames.size()),std::max(jobs,1U),[&](const uint32_t runfile)
+        {
+          this->Classify(classifier,runfile,matrices[runfile]);
+        });
+
+      ConfusionMatrix<> total;
+      for (const ConfusionMatrix<>& matrix : matrices)
+        {
+          total += matrix;
+        }
+      if (runfiles != nullptr)
+        {
+          runfiles->swap(matrices);
+        }
+      return (total);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Classifies the particles of some runfiles only (a held-out fold, ...) and counts the
+ *  results against their user classes.
+ *
+ *  @param [in]  classifier  classifies a feature vector (may be called concurrently)
+ *  @param [in]  runfiles    the runfiles to classify
+ *  @param [in]  jobs        the number of runfiles classified concurrently
+ *
+ *  @return  the matrix of those runfiles
+ *
+ *  @throw  std::runtime_error  if the classifier returns a class outside the vocabulary
+ */
+
+  APRT::ConfusionMatrix<> APRT::FeatureEvaluator::Evaluate(const Classifier&            classifier,
+                                                           const std::vector<uint32_t>& runfiles,
+                                                           const uint32_t               jobs) const
+    {
+      std::vector<ConfusionMatrix<>> matrices(runfiles.size());
+      ParallelFor(0,uint32_t(runfiles.size()),std::max(jobs,1U),[&](const uint32_t index)
+        {
+          assert(runfiles[index] < this->runfilenames.size());
+          this->Classify(classifier,runfiles[index],matrices[index]);
+        });
+
+      ConfusionMatrix<> total;
+      for (const ConfusionMatrix<>& matrix : matrices)
+        {
+          total += matrix;
+        }
+      return (total);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Classifies the particles of a runfile, counting them against their user classes.  A
+ *  class outside the vocabulary (a classifier built for another vocabulary, ...) would
+ *  count outside the matrix, so it stops the evaluation instead.
+ *
+ *  @param [in]      classifier  classifies a feature vector
+ *  @param [in]      runfile     the runfile
+ *  @param [in,out]  matrix      the matrix counted into
+ *
+ *  @throw  std::runtime_error  if the classifier returns a class outside the vocabulary
+ */
+
+  void APRT::FeatureEvaluator::Classify(const Classifier&  classifier,
+                                        const uint32_t     runfile,
+                                        ConfusionMatrix<>& matrix) const
+    {
+      for (uint64_t patch = this->firstpatches[runfile]; patch < this->firstpatches[runfile + 1]; ++patch)
+        {
+          const ClassId pcl = classifier(this->Values(patch));
+          if (pcl >= ClassVocabulary::Size)
+            {
+              throw std::runtime_error("The classifier returned class " + std::to_string(pcl) + " for a particle of " +
+                                       this->runfilenames[runfile] + ", which is not in the vocabulary.");
+            }
+          ++matrix(pcl,this->labels[patch]);
+        }
+    }
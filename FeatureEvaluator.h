@@ -0,0 +1,186 @@
+/**
+ *  @file  FeatureEvaluator.h
+ *
+ *  @brief  Definition of the FeatureEvaluator class.
+ *
+ *  Definition of the FeatureEvaluator class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_FEATURE_EVALUATOR_H_INCLUDED
+    #define APRT_FEATURE_EVALUATOR_H_INCLUDED
+
+    #include <functional>
+    #include <string>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+    #include "ConfusionMatrix.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  Classifies a particle from its feature vector (the features of the store, in
+ *          order), returning its apr class (an id of the built ClassVocabulary).  Called
+ *          from several threads at once.
+ */
+
+        typedef std::function<ClassId (const float* features)> Classifier;
+
+/**
+ *  Re-evaluates a classifier against the user classifications without the runfiles or
+ *  any .pcl text.  The feature vectors and user (acl) classes of a feature store are
+ *  loaded once, row by row, into memory; each Evaluate() then classifies every particle
+ *  with the given classifier, the runfiles spread over the jobs, and counts the results
+ *  straight into confusion matrices.  Rows without a particle (all features NaN) are
+ *  left out, and the store's class codes are interned, so a store written by another
+ *  build labels the built vocabulary.
+ */
+
+        class FeatureEvaluator
+          {
+            public:
+              explicit FeatureEvaluator(const std::string& path);
+
+            public:
+              ConfusionMatrix<>   Evaluate(const Classifier&               classifier,
+                                           uint32_t                        jobs,
+                                           std::vector<ConfusionMatrix<>>* runfiles = nullptr) const;
+              ConfusionMatrix<>   Evaluate(const Classifier&            classifier,
+                                           const std::vector<uint32_t>& runfiles,
+                                           uint32_t                     jobs) const;
+              uint64_t            Patches() const;
+              uint32_t            Features() const;
+              const std::vector<std::string>&
+                                  Runfiles() const;
+              const float*        Values(uint64_t patch) const;
+              ClassId             Label(uint64_t patch) const;
+              uint64_t            FirstPatch(uint32_t runfile) const;
+            private:
+              void                Classify(const Classifier&  classifier,
+                                           uint32_t           runfile,
+                                           ConfusionMatrix<>& matrix) const;
+            private:
+              uint32_t                  features;
+                /**< @brief  the number of features of a particle */
+              std::vector<float>        values;
+                /**< @brief  the feature vector of each particle, one after another */
+              std::vector<ClassId>      labels;
+                /**< @brief  the user class of each particle */
+              std::vector<uint64_t>     firstpatches;
+                /**< @brief  the first particle of each runfile, plus the particle count */
+              std::vector<std::string>  runfilenames;
+                /**< @brief  the name of each runfile */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of particles loaded.
+ *
+ *  @return  the number of particles
+ */
+
+    inline uint64_t APRT::FeatureEvaluator::Patches() const
+      {
+        return (this->labels.size());
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of features of a particle.
+ *
+ *  @return  the number of features
+ */
+
+    inline uint32_t APRT::FeatureEvaluator::Features() const
+      {
+        return (this->features);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the runfiles of the store, in store (list) order.
+ *
+ *  @return  the runfile names
+ */
+
+    inline const std::vector<std::string>& APRT::FeatureEvaluator::Runfiles() const
+      {
+        return (this->runfilenames);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the feature vector of a particle.
+ *
+ *  @param [in]  patch  the particle (among those loaded)
+ *
+ *  @return  the first feature
+ */
+
+    inline const float* APRT::FeatureEvaluator::Values(const uint64_t patch) const
+      {
+        assert(patch < this->labels.size());
+        return (this->values.data() + patch * this->features);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the user class of a particle.
+ *
+ *  @param [in]  patch  the particle (among those loaded)
+ *
+ *  @return  the acl class
+ */
+
+    inline APRT::ClassId APRT::FeatureEvaluator::Label(const uint64_t patch) const
+      {
+        assert(patch < this->labels.size());
+        return (this->labels[patch]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the first particle of a runfile; its particles run to FirstPatch(runfile + 1).
+ *
+ *  @param [in]  runfile  the runfile (or the number of runfiles, for the particle count)
+ *
+ *  @return  the first particle
+ */
+
+    inline uint64_t APRT::FeatureEvaluator::FirstPatch(const uint32_t runfile) const
+      {
+        assert(runfile < this->firstpatches.size());
+        return (this->firstpatches[runfile]);
+      }
+
+  #endif
@@ -0,0 +1,322 @@
+/**
+ *  @file  FeatureStore.cpp
+ *
+ *  @brief  Implementation of the FeatureStore and FeatureStoreWriter classes.
+ *
+ *  Implementation of the FeatureStore and FeatureStoreWriter classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "FeatureStore.h"
+
+  #include <algorithm>
+  #include <limits>
+  #include <stdexcept>
+  #include <tuple>
+
+  #include <cstring>
+
+  #include "BinaryLayout.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The fixed-size start of a feature store (see FeatureStore for what follows it).
+ */
+
+        struct StoreHeader
+          {
+            char      magic[8];      /**< @brief  "APRTFEA" and the format version  */
+            uint64_t  rows;          /**< @brief  the number of rows                */
+            uint64_t  features;      /**< @brief  the number of features            */
+            uint64_t  classes;       /**< @brief  the number of class codes         */
+            uint64_t  runfiles;      /**< @brief  the number of runfile names       */
+            uint64_t  featurebytes;  /**< @brief  the length of the feature names   */
+            uint64_t  codebytes;     /**< @brief  the length of the class codes     */
+            uint64_t  namebytes;     /**< @brief  the length of the runfile names   */
+          };
+
+        const char Magic[8] = {'A','P','R','T','F','E','A','\x01'};
+
+/**
+ *  Where each part of a feature store starts, given its header.
+ */
+
+        struct StoreLayout
+          {
+            uint64_t  columns;
+            uint64_t  runfileids;
+            uint64_t  subsamples;
+            uint64_t  patches;
+            uint64_t  labels;
+            uint64_t  firstrows;
+            uint64_t  featureoffsets;
+            uint64_t  codeoffsets;
+            uint64_t  nameoffsets;
+            uint64_t  featurenames;
+            uint64_t  codes;
+            uint64_t  names;
+            uint64_t  size;
+
+            explicit StoreLayout(const StoreHeader& header)
+              : columns(sizeof(header)),
+                runfileids(columns + header.features * APRT::Padded(header.rows * sizeof(float))),
+                subsamples(runfileids + APRT::Padded(header.rows * sizeof(uint32_t))),
+                patches(subsamples + APRT::Padded(header.rows * sizeof(uint16_t))),
+                labels(patches + APRT::Padded(header.rows * sizeof(uint32_t))),
+                firstrows(labels + APRT::Padded(header.rows * sizeof(APRT::ClassId))),
+                featureoffsets(firstrows + (header.runfiles + 1) * sizeof(uint64_t)),
+                codeoffsets(featureoffsets + (header.features + 1) * sizeof(uint64_t)),
+                nameoffsets(codeoffsets + (header.classes + 1) * sizeof(uint64_t)),
+                featurenames(nameoffsets + (header.runfiles + 1) * sizeof(uint64_t)),
+                codes(featurenames + APRT::Padded(header.featurebytes)),
+                names(codes + APRT::Padded(header.codebytes)),
+                size(names + APRT::Padded(header.namebytes)) {}
+          };
+
+/**
+ *  Returns the distance between two feature columns, in floats.
+ */
+
+        uint64_t Stride(const uint64_t rows)
+          {
+            return (APRT::Padded(rows * sizeof(float)) / sizeof(float));
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a feature store, with the keys of every row, NaN features and NONE labels, and
+ *  maps it for writing.
+ *
+ *  @param [in]  path          the store path
+ *  @param [in]  features      the name of each feature
+ *  @param [in]  runfilenames  the name of each runfile id
+ *  @param [in]  firstrows     the first row of each runfile, plus the row count
+ *  @param [in]  ssn           the one-based subsample number of the rows
+ */
+
+  APRT::FeatureStoreWriter::FeatureStoreWriter(const std::string&              path,
+                                               const std::vector<std::string>& features,
+                                               const std::vector<std::string>& runfilenames,
+                                               const std::vector<uint64_t>&    firstrows,
+                                               const uint32_t                  ssn)
+    : path(path),
+      rows(firstrows.back()),
+      features(uint32_t(features.size())),
+      stride(Stride(firstrows.back()))
+      {
+        assert(firstrows.size() == runfilenames.size() + 1);
+        std::vector<std::string_view> codes;
+        for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+          {
+            codes.push_back(ClassVocabulary::Code(ClassId(id)));
+          }
+        std::vector<uint64_t> featureoffsets;
+        std::vector<uint64_t> codeoffsets;
+        std::vector<uint64_t> nameoffsets;
+        const std::string featuretext = Concatenate(features,featureoffsets);
+        const std::string codetext    = Concatenate(codes,codeoffsets);
+        const std::string nametext    = Concatenate(runfilenames,nameoffsets);
+
+        StoreHeader header;
+        std::memcpy(header.magic,Magic,sizeof(Magic));
+        header.rows         = this->rows;
+        header.features     = this->features;
+        header.classes      = ClassVocabulary::Size;
+        header.runfiles     = runfilenames.size();
+        header.featurebytes = featureoffsets.back();
+        header.codebytes    = codeoffsets.back();
+        header.namebytes    = nameoffsets.back();
+        const StoreLayout layout(header);
+//
+//  Create the file at its full size and map it ...
+//
+        boost::iostreams::mapped_file_params params(path);
+        params.new_file_size = int64_t(layout.size);
+        try
+          {
+            this->file.open(params);
+          }
+        catch (const std::exception&)
+          {
+            throw std::runtime_error("Unable to write the feature store " + path + ".");
+          }
+        char* const begin = this->file.data();
+        this->columns = reinterpret_cast<float*>(begin + layout.columns);
+        this->labels  = reinterpret_cast<ClassId*>(begin + layout.labels);
+//
+//  ... and write everything but the features and labels of the particles ...
+//
+        std::memcpy(begin,&header,sizeof(header));
+        std::fill(this->columns,this->columns + this->features * this->stride,std::numeric_limits<float>::quiet_NaN());
+        std::fill(this->labels,this->labels + this->rows,ClassVocabulary::None);
+        uint32_t* const runfileids = reinterpret_cast<uint32_t*>(begin + layout.runfileids);
+        uint16_t* const subsamples = reinterpret_cast<uint16_t*>(begin + layout.subsamples);
+        uint32_t* const patches    = reinterpret_cast<uint32_t*>(begin + layout.patches);
+        for (uint32_t runfile = 0; runfile < runfilenames.size(); ++runfile)
+          {
+            for (uint64_t row = firstrows[runfile]; row < firstrows[runfile + 1]; ++row)
+              {
+                runfileids[row] = runfile;
+                subsamples[row] = uint16_t(ssn);
+                patches[row]    = uint32_t(row - firstrows[runfile]);
+              }
+          }
+        std::memcpy(begin + layout.firstrows,firstrows.data(),firstrows.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.featureoffsets,featureoffsets.data(),featureoffsets.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.codeoffsets,codeoffsets.data(),codeoffsets.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.nameoffsets,nameoffsets.data(),nameoffsets.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.featurenames,featuretext.data(),featuretext.size());
+        std::memcpy(begin + layout.codes,codetext.data(),codetext.size());
+        std::memcpy(begin + layout.names,nametext.data(),nametext.size());
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Fills a row with the features and label of its particle.  May be called from any
+ *  thread, for distinct rows.
+ *
+ *  @param [in]  row     the row
+ *  @param [in]  values  the value of each feature
+ *  @param [in]  acl     the user class of the particle
+ */
+
+  void APRT::FeatureStoreWriter::Fill(const uint64_t     row,
+                                      const float* const values,
+                                      const ClassId      acl)
+    {
+      assert(row < this->rows);
+      for (uint32_t feature = 0; feature < this->features; ++feature)
+        {
+          this->columns[feature * this->stride + row] = values[feature];
+        }
+      this->labels[row] = acl;
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Unmaps the store, flushing it to the file.
+ */
+
+  void APRT::FeatureStoreWriter::Close()
+    {
+      try
+        {
+          this->file.close();
+        }
+      catch (const std::exception&)
+        {
+          throw std::runtime_error("Unable to write the feature store " + this->path + ".");
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps a feature store.
+ *
+ *  @param [in]  path  the store path
+ */
+
+  APRT::FeatureStore::FeatureStore(const std::string& path)
+    : file(path)
+      {
+        const std::runtime_error invalid(path + " is not a feature store.");
+        StoreHeader header;
+        if (!ReadHeader(this->file,Magic,header) ||
+            (header.rows     > this->file.Size()) ||
+            (header.features > this->file.Size()) ||
+            (header.classes  > UINT32_MAX) ||
+            (header.runfiles > UINT32_MAX) ||
+            ((header.features != 0) && (Stride(header.rows) > this->file.Size() / sizeof(float) / header.features)))
+          {
+            throw invalid;
+          }
+        const StoreLayout layout(header);
+        if (this->file.Size() != layout.size)
+          {
+            throw invalid;
+          }
+        const char* const begin = this->file.Begin();
+        this->rows           = header.rows;
+        this->features       = uint32_t(header.features);
+        this->classes        = uint32_t(header.classes);
+        this->runfiles       = uint32_t(header.runfiles);
+        this->stride         = Stride(header.rows);
+        this->columns        = reinterpret_cast<const float*>(begin + layout.columns);
+        this->runfileids     = reinterpret_cast<const uint32_t*>(begin + layout.runfileids);
+        this->subsamples     = reinterpret_cast<const uint16_t*>(begin + layout.subsamples);
+        this->patches        = reinterpret_cast<const uint32_t*>(begin + layout.patches);
+        this->labels         = reinterpret_cast<const ClassId*>(begin + layout.labels);
+        this->firstrows      = reinterpret_cast<const uint64_t*>(begin + layout.firstrows);
+        this->featureoffsets = reinterpret_cast<const uint64_t*>(begin + layout.featureoffsets);
+        this->codeoffsets    = reinterpret_cast<const uint64_t*>(begin + layout.codeoffsets);
+        this->nameoffsets    = reinterpret_cast<const uint64_t*>(begin + layout.nameoffsets);
+        this->featurenames   = begin + layout.featurenames;
+        this->codes          = begin + layout.codes;
+        this->names          = begin + layout.names;
+        if (!Ascending(this->firstrows,this->runfiles,header.rows)                ||
+            !Ascending(this->featureoffsets,this->features,header.featurebytes) ||
+            !Ascending(this->codeoffsets,this->classes,header.codebytes)         ||
+            !Ascending(this->nameoffsets,this->runfiles,header.namebytes))
+          {
+            throw invalid;
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Finds the row of a particle by its key.
+ *
+ *  @param [in]  runfile  the runfile id
+ *  @param [in]  ssn      the one-based subsample number
+ *  @param [in]  patch    the patch index within the subsample
+ *
+ *  @return  the row, or Rows() if the store has no such particle
+ */
+
+  uint64_t APRT::FeatureStore::Find(const uint32_t runfile,
+                                    const uint32_t ssn,
+                                    const uint32_t patch) const
+    {
+      const auto key = std::make_tuple(runfile,ssn,patch);
+      uint64_t first = 0;
+      uint64_t last  = this->rows;
+      while (first < last)
+        {
+          const uint64_t middle = first + (last - first) / 2;
+          if (std::make_tuple(this->runfileids[middle],uint32_t(this->subsamples[middle]),this->patches[middle]) < key)
+            {
+              first = middle + 1;
+            }
+          else
+            {
+              last = middle;
+            }
+        }
+      return (((first < this->rows) &&
+               (std::make_tuple(this->runfileids[first],uint32_t(this->subsamples[first]),this->patches[first]) == key)) ?
+                  first :
+                  this->rows);
+    }
@@ -0,0 +1,364 @@
+/**
+ *  @file  FeatureStore.h
+ *
+ *  @brief  Definition of the FeatureStore and FeatureStoreWriter classes.
+ *
+ *  Definition of the FeatureStore and FeatureStoreWriter classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_FEATURE_STORE_H_INCLUDED
+    #define APRT_FEATURE_STORE_H_INCLUDED
+
+    #include <boost/iostreams/device/mapped_file.hpp>
+
+    #include <string>
+    #include <string_view>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+    #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  Creates a feature store of a known number of rows and maps it for writing.  The keys
+ *  of every row are written when the store is created; each row's features and label
+ *  are filled by whichever thread measures its particle, so distinct rows may be filled
+ *  at once.  A row never filled has NaN features and is labelled NONE.
+ */
+
+        class FeatureStoreWriter
+          {
+            public:
+              FeatureStoreWriter(const std::string&              path,
+                                 const std::vector<std::string>& features,
+                                 const std::vector<std::string>& runfilenames,
+                                 const std::vector<uint64_t>&    firstrows,
+                                 uint32_t                        ssn);
+              FeatureStoreWriter(const FeatureStoreWriter&) = delete;
+              FeatureStoreWriter& operator = (const FeatureStoreWriter&) = delete;
+
+            public:
+              void  Fill(uint64_t     row,
+                         const float* values,
+                         ClassId      acl);
+              void  Close();
+            private:
+              std::string                        path;
+                /**< @brief  the store path */
+              boost::iostreams::mapped_file_sink file;
+                /**< @brief  the mapping of the store */
+              uint64_t                           rows;
+                /**< @brief  the number of rows */
+              uint32_t                           features;
+                /**< @brief  the number of features (columns) */
+              uint64_t                           stride;
+                /**< @brief  the distance between two feature columns, in floats */
+              float*                             columns;
+                /**< @brief  the first feature column */
+              ClassId*                           labels;
+                /**< @brief  the user class of each row */
+          };
+
+/**
+ *  A feature store: the feature vector of each particle of a subsample of the runfiles
+ *  of a list, stored by column (all the values of a feature together) so an experiment
+ *  maps the file and reads the features it needs at memory speed, without the runfiles.
+ *  Each row is keyed by (runfile, subsample, patch index) and joined to the user (acl)
+ *  class of the patch.  Each runfile has a row per user classification, in patch index
+ *  order, so the rows are sorted by key.
+ *
+ *  The file is, in native byte order: a header, then (each padded to a multiple of eight
+ *  bytes) a float column per feature, the runfile id, subsample and patch index columns,
+ *  the acl class column, runfiles + 1 first rows, features + 1 feature name offsets,
+ *  classes + 1 code offsets, runfiles + 1 runfile name offsets, the feature names, the
+ *  class codes and the runfile names.
+ */
+
+        class FeatureStore
+          {
+            public:
+              explicit FeatureStore(const std::string& path);
+
+            public:
+              uint64_t          Rows() const;
+              uint32_t          Features() const;
+              std::string_view  Feature(uint32_t feature) const;
+              const float*      Column(uint32_t feature) const;
+              const uint32_t*   RunfileIds() const;
+              const uint16_t*   Subsamples() const;
+              const uint32_t*   Patches() const;
+              const ClassId*    Labels() const;
+              uint64_t          Find(uint32_t runfile,
+                                     uint32_t ssn,
+                                     uint32_t patch) const;
+              uint32_t          Classes() const;
+              std::string_view  Code(uint32_t id) const;
+              uint32_t          Runfiles() const;
+              std::string_view  Runfile(uint32_t id) const;
+              uint64_t          FirstRow(uint32_t id) const;
+            private:
+              MappedFile        file;
+                /**< @brief  the mapped store */
+              uint64_t          rows;
+                /**< @brief  the number of rows */
+              uint32_t          features;
+                /**< @brief  the number of features */
+              uint32_t          classes;
+                /**< @brief  the number of class codes */
+              uint32_t          runfiles;
+                /**< @brief  the number of runfile names */
+              uint64_t          stride;
+                /**< @brief  the distance between two feature columns, in floats */
+              const float*      columns;
+                /**< @brief  the first feature column */
+              const uint32_t*   runfileids;
+                /**< @brief  the runfile id of each row */
+              const uint16_t*   subsamples;
+                /**< @brief  the subsample of each row */
+              const uint32_t*   patches;
+                /**< @brief  the patch index of each row */
+              const ClassId*    labels;
+                /**< @brief  the user class of each row */
+              const uint64_t*   firstrows;
+                /**< @brief  the first row of each runfile, plus the row count */
+              const uint64_t*   featureoffsets;
+                /**< @brief  the start of each feature name, plus the end */
+              const uint64_t*   codeoffsets;
+                /**< @brief  the start of each class code, plus the end */
+              const uint64_t*   nameoffsets;
+                /**< @brief  the start of each runfile name, plus the end */
+              const char*       featurenames;
+                /**< @brief  the feature names */
+              const char*       codes;
+                /**< @brief  the class codes */
+              const char*       names;
+                /**< @brief  the runfile names */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of rows (patches) of the store.
+ *
+ *  @return  the number of rows
+ */
+
+    inline uint64_t APRT::FeatureStore::Rows() const
+      {
+        return (this->rows);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of features (columns) of the store.
+ *
+ *  @return  the number of features
+ */
+
+    inline uint32_t APRT::FeatureStore::Features() const
+      {
+        return (this->features);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the name of a feature.
+ *
+ *  @param [in]  feature  the feature (column)
+ *
+ *  @return  the feature name
+ */
+
+    inline std::string_view APRT::FeatureStore::Feature(const uint32_t feature) const
+      {
+        assert(feature < this->features);
+        return (std::string_view(this->featurenames + this->featureoffsets[feature],
+                                 this->featureoffsets[feature + 1] - this->featureoffsets[feature]));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the values of a feature, one per row.
+ *
+ *  @param [in]  feature  the feature (column)
+ *
+ *  @return  the first value
+ */
+
+    inline const float* APRT::FeatureStore::Column(const uint32_t feature) const
+      {
+        assert(feature < this->features);
+        return (this->columns + feature * this->stride);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the runfile id of each row.
+ *
+ *  @return  the runfile id column
+ */
+
+    inline const uint32_t* APRT::FeatureStore::RunfileIds() const
+      {
+        return (this->runfileids);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the one-based subsample number of each row.
+ *
+ *  @return  the subsample column
+ */
+
+    inline const uint16_t* APRT::FeatureStore::Subsamples() const
+      {
+        return (this->subsamples);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the patch index of each row.
+ *
+ *  @return  the patch index column
+ */
+
+    inline const uint32_t* APRT::FeatureStore::Patches() const
+      {
+        return (this->patches);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the user class of each row.
+ *
+ *  @return  the acl class id column (ids are positions in the store's codes)
+ */
+
+    inline const APRT::ClassId* APRT::FeatureStore::Labels() const
+      {
+        return (this->labels);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of classes the labels index.
+ *
+ *  @return  the number of class codes
+ */
+
+    inline uint32_t APRT::FeatureStore::Classes() const
+      {
+        return (this->classes);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of a class of the store.
+ *
+ *  @param [in]  id  the class id
+ *
+ *  @return  the class code
+ */
+
+    inline std::string_view APRT::FeatureStore::Code(const uint32_t id) const
+      {
+        assert(id < this->classes);
+        return (std::string_view(this->codes + this->codeoffsets[id],
+                                 this->codeoffsets[id + 1] - this->codeoffsets[id]));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of runfiles of the store.
+ *
+ *  @return  the number of runfiles
+ */
+
+    inline uint32_t APRT::FeatureStore::Runfiles() const
+      {
+        return (this->runfiles);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the name of a runfile of the store.
+ *
+ *  @param [in]  id  the runfile id
+ *
+ *  @return  the runfile name
+ */
+
+    inline std::string_view APRT::FeatureStore::Runfile(const uint32_t id) const
+      {
+        assert(id < this->runfiles);
+        return (std::string_view(this->names + this->nameoffsets[id],
+                                 this->nameoffsets[id + 1] - this->nameoffsets[id]));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the first row of a runfile.
+ *
+ *  @param [in]  id  the runfile id (or the number of runfiles, for the row count)
+ *
+ *  @return  the first row
+ */
+
+    inline uint64_t APRT::FeatureStore::FirstRow(const uint32_t id) const
+      {
+        assert(id <= this->runfiles);
+        return (this->firstrows[id]);
+      }
+
+  #endif
@@ -0,0 +1,137 @@
+/**
+ *  @file  LabelTable.cpp
+ *
+ *  @brief  Implementation of the LabelTable class.
+ *
+ *  Implementation of the LabelTable class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "LabelTable.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The number of slots of a new table.
+ */
+
+        const size_t InitialSlots = 64;
+
+/**
+ *  Returns the 64-bit FNV-1a hash of a code.
+ */
+
+        uint64_t Hash(const std::string_view code)
+          {
+            uint64_t hash = 14695981039346656037ULL;
+            for (const char byte : code)
+              {
+                hash = (hash ^ uint8_t(byte)) * 1099511628211ULL;
+              }
+            return (hash);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a LabelTable holding the classes of the ClassVocabulary.
+ */
+
+  APRT::LabelTable::LabelTable()
+   : slots(InitialSlots,Slot{0,0}),
+     size(ClassVocabulary::Size)
+      {
+        ;
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of a class.
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  the class code (valid for the life of the table)
+ */
+
+  std::string_view APRT::LabelTable::Code(const uint32_t id) const
+    {
+      if (Known(id))
+        {
+          return (ClassVocabulary::Code(ClassId(id)));
+        }
+      std::lock_guard<std::mutex> lock(this->mutex);
+      return (this->codes.at(id - ClassVocabulary::Size));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Interns a code the ClassVocabulary does not know, giving it the next id if it has not
+ *  been seen before.
+ *
+ *  @param [in]  code  the class code
+ *
+ *  @return  the id of the class
+ */
+
+  uint32_t APRT::LabelTable::Discover(const std::string_view code)
+    {
+      const uint64_t hash = Hash(code);
+      std::lock_guard<std::mutex> lock(this->mutex);
+      size_t mask = this->slots.size() - 1;
+      size_t slot = size_t(hash) & mask;
+      for (; this->slots[slot].id != 0; slot = (slot + 1) & mask)
+        {
+          if ((this->slots[slot].hash == hash) &&
+              (this->codes[this->slots[slot].id - ClassVocabulary::Size] == code))
+            {
+              return (this->slots[slot].id);
+            }
+        }
+//
+//  A new code: number it, and double the table first if it would be over half full ...
+//
+      const uint32_t id = ClassVocabulary::Size + uint32_t(this->codes.size());
+      this->codes.emplace_back(code);
+      if (2*this->codes.size() > this->slots.size())
+        {
+          std::vector<Slot> grown(2*this->slots.size(),Slot{0,0});
+          mask = grown.size() - 1;
+          for (const Slot& entry : this->slots)
+            {
+              if (entry.id != 0)
+                {
+                  size_t next = size_t(entry.hash) & mask;
+                  while (grown[next].id != 0)
+                    {
+                      next = (next + 1) & mask;
+                    }
+                  grown[next] = entry;
+                }
+            }
+          this->slots.swap(grown);
+          slot = size_t(hash) & mask;
+          while (this->slots[slot].id != 0)
+            {
+              slot = (slot + 1) & mask;
+            }
+        }
+      this->slots[slot] = Slot{hash,id};
+      this->size.store(id + 1,std::memory_order_release);
+
+      return (id);
+    }
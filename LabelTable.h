@@ -0,0 +1,126 @@
+/**
+ *  @file  LabelTable.h
+ *
+ *  @brief  Definition of the LabelTable class.
+ *
+ *  Definition of the LabelTable class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_LABEL_TABLE_H_INCLUDED
+    #define APRT_LABEL_TABLE_H_INCLUDED
+
+    #include <atomic>
+    #include <deque>
+    #include <mutex>
+    #include <string>
+    #include <string_view>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  An open class vocabulary: the classes of the ClassVocabulary, which keep their ids,
+ *  followed by the codes found in the data that it does not know, numbered in the order
+ *  they are first interned (an empty code is still NONE).  A known code is interned by
+ *  the perfect hash of the ClassVocabulary as in the fixed vocabulary; only an unknown
+ *  code goes to a growable open-addressing table (linear probing, doubled when half
+ *  full), under a lock, so the table may be shared by concurrent comparisons.
+ */
+
+        class LabelTable
+          {
+            public:
+              LabelTable();
+              LabelTable(const LabelTable&) = delete;
+              LabelTable& operator = (const LabelTable&) = delete;
+
+            public:
+              uint32_t          Intern(std::string_view code);
+              std::string_view  Code(uint32_t id) const;
+              uint32_t          Size() const;
+              static bool       Known(uint32_t id);
+            private:
+              uint32_t          Discover(std::string_view code);
+            private:
+              struct Slot
+                {
+                  uint64_t  hash;  /**< @brief  the hash of the code in the slot  */
+                  uint32_t  id;    /**< @brief  the id of the code (0 if empty)   */
+                };
+              mutable std::mutex       mutex;
+                /**< @brief  guards the discovered codes */
+              std::vector<Slot>        slots;
+                /**< @brief  the open-addressing table of the discovered codes */
+              std::deque<std::string>  codes;
+                /**< @brief  the discovered codes in id order (stable in memory) */
+              std::atomic<uint32_t>    size;
+                /**< @brief  the number of classes, known and discovered */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Interns a class code, adding it to the table if it is new.
+ *
+ *  @param [in]  code  the apr- or user-assigned class code
+ *
+ *  @return  the id of the class
+ */
+
+    inline uint32_t APRT::LabelTable::Intern(const std::string_view code)
+      {
+        const ClassId id = ClassVocabulary::Intern(code);
+        if ((id != ClassVocabulary::None) || code.empty() || (code == ClassVocabulary::Code(id)))
+          {
+            return (id);
+          }
+        return (this->Discover(code));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of classes, known and discovered so far.
+ *
+ *  @return  the number of classes
+ */
+
+    inline uint32_t APRT::LabelTable::Size() const
+      {
+        return (this->size.load(std::memory_order_acquire));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns true for a class of the ClassVocabulary (as opposed to a discovered one).
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  true if the class is known
+ */
+
+    inline bool APRT::LabelTable::Known(const uint32_t id)
+      {
+        return (id < ClassVocabulary::Size);
+      }
+
+  #endif
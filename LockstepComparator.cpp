@@ -0,0 +1,470 @@
+/**
+ *  @file  LockstepComparator.cpp
+ *
+ *  @brief  Implementation of the LockstepComparator class.
+ *
+ *  Implementation of the LockstepComparator class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "LockstepComparator.h"
+
+  #include <algorithm>
+  #include <string_view>
+  #include <vector>
+
+  #include <cassert>
+
+  #include "ClassificationScanner.h"
+  #include "ParallelFor.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  Advances a scanner to the given subsample, returning false if there is no such
+ *  subsample.
+ */
+
+        bool SeekSubsample(APRT::ClassificationScanner& scanner,
+                           const uint32_t               ssn)
+          {
+            while (scanner.Subsample() < ssn)
+              {
+                if (!scanner.NextSubsample())
+                  {
+                    return (false);
+                  }
+              }
+            return (scanner.Subsample() == ssn);
+          }
+
+/**
+ *  Pairs the patches of the current subsamples of two scanners, passing each (pcl,acl)
+ *  pair of class names to a function, and counts the patches of each.  A subsample that
+ *  was not found has no patches.
+ */
+
+        template <typename Function>
+          APRT::PatchCounts PairPatches(APRT::ClassificationScanner& pclscanner,
+                                        const bool                   pclfound,
+                                        APRT::ClassificationScanner& aclscanner,
+                                        const bool                   aclfound,
+                                        Function                     count)
+            {
+              APRT::PatchCounts counts = {0,0};
+//
+//  Count the pairs while both subsamples have patches ...
+//
+              std::string_view pclclass;
+              std::string_view aclclass;
+              bool pclmore = pclfound && pclscanner.NextPatch(pclclass);
+              bool aclmore = aclfound && aclscanner.NextPatch(aclclass);
+              while (pclmore && aclmore)
+                {
+                  count(pclclass,aclclass);
+                  ++counts.pcl;
+                  ++counts.acl;
+                  pclmore = pclscanner.NextPatch(pclclass);
+                  aclmore = aclscanner.NextPatch(aclclass);
+                }
+//
+//  Count the rest of the longer subsample ...
+//
+              for (; pclmore; pclmore = pclscanner.NextPatch(pclclass))
+                {
+                  ++counts.pcl;
+                }
+              for (; aclmore; aclmore = aclscanner.NextPatch(aclclass))
+                {
+                  ++counts.acl;
+                }
+
+              return (counts);
+            }
+
+/**
+ *  Pairs the patches of the current subsample of a scanner with the interned classes of
+ *  a subsample, passing each (pcl,acl) pair to a function, and counts the patches of
+ *  each.
+ */
+
+        template <typename Function>
+          APRT::PatchCounts PairPatches(APRT::ClassificationScanner& pclscanner,
+                                        const bool                   pclfound,
+                                        const APRT::LabelSpan&       aclpatches,
+                                        Function                     count)
+            {
+              APRT::PatchCounts counts = {0,aclpatches.size()};
+              std::string_view pclclass;
+              while (pclfound && pclscanner.NextPatch(pclclass))
+                {
+                  if (counts.pcl < counts.acl)
+                    {
+                      count(pclclass,aclpatches[counts.pcl]);
+                    }
+                  ++counts.pcl;
+                }
+
+              return (counts);
+            }
+
+/**
+ *  Pairs the patches of a subsample of two texts, passing each (pcl,acl) pair of class
+ *  names to a function, and counts the patches of each.
+ */
+
+        template <typename Function>
+          APRT::PatchCounts ComparePairs(const char* const pclfirst,
+                                         const char* const pcllast,
+                                         const char* const aclfirst,
+                                         const char* const acllast,
+                                         const uint32_t    ssn,
+                                         Function          count)
+            {
+              APRT::ClassificationScanner pclscanner(pclfirst,pcllast);
+              APRT::ClassificationScanner aclscanner(aclfirst,acllast);
+              const bool pclfound = SeekSubsample(pclscanner,ssn);
+              const bool aclfound = SeekSubsample(aclscanner,ssn);
+              return (PairPatches(pclscanner,pclfound,aclscanner,aclfound,count));
+            }
+
+/**
+ *  Counts a (pcl,acl) pair of interned classes, recording it if the classes differ.
+ */
+
+        inline void Record(const APRT::ClassId              pcl,
+                           const APRT::ClassId              acl,
+                           const uint32_t                   ssn,
+                           const uint32_t                   patch,
+                           APRT::ConfusionMatrix<>&         conmatrix,
+                           std::vector<APRT::Disagreement>& disagreements)
+          {
+            ++conmatrix(pcl,acl);
+            if (pcl != acl)
+              {
+                disagreements.push_back(APRT::Disagreement{0,uint16_t(ssn),pcl,acl,patch});
+              }
+          }
+
+/**
+ *  Returns a scanner positioned at the start of each subsample of a text.  Only the
+ *  subsample terminators are searched for; no patch is tokenized.
+ */
+
+        std::vector<APRT::ClassificationScanner> FindSubsamples(const char* const first,
+                                                                const char* const last)
+          {
+            std::vector<APRT::ClassificationScanner> subsamples;
+            APRT::ClassificationScanner scanner(first,last);
+            while (scanner.NextSubsample())
+              {
+                subsamples.push_back(scanner);
+              }
+            return (subsamples);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the (pcl,acl) pairs of a subsample to a confusion matrix.  Patches are paired by
+ *  patch index up to the length of the shorter subsample, as WriteSort always has; the
+ *  patches of the longer one are only counted.  A missing subsample has no patches.
+ *  Given a list, each paired patch whose classes differ is also appended to it (with a
+ *  runfile id of 0).
+ *
+ *  @param [in]      pclfirst       the start of the apr (pcl) text
+ *  @param [in]      pcllast        the end of the apr (pcl) text
+ *  @param [in]      aclfirst       the start of the user (acl) text
+ *  @param [in]      acllast        the end of the user (acl) text
+ *  @param [in]      ssn            the one-based subsample number
+ *  @param [in,out]  conmatrix      the confusion matrix to add to
+ *  @param [in,out]  disagreements  the disagreements to append to (or nullptr)
+ *
+ *  @return  the number of patches in each subsample
+ */
+
+  APRT::PatchCounts APRT::LockstepComparator::Compare(const char* const                pclfirst,
+                                                      const char* const                pcllast,
+                                                      const char* const                aclfirst,
+                                                      const char* const                acllast,
+                                                      const uint32_t                   ssn,
+                                                      ConfusionMatrix<>&               conmatrix,
+                                                      std::vector<Disagreement>* const disagreements)
+    {
+      if (disagreements != nullptr)
+        {
+          uint32_t patch = 0;
+          return (ComparePairs(pclfirst,pcllast,aclfirst,acllast,ssn,
+                               [&](const std::string_view pclclass, const std::string_view aclclass)
+                                 {
+                                   Record(ClassVocabulary::Intern(pclclass),ClassVocabulary::Intern(aclclass),
+                                          ssn,patch++,conmatrix,*disagreements);
+                                 }));
+        }
+      return (ComparePairs(pclfirst,pcllast,aclfirst,acllast,ssn,
+                           [&](const std::string_view pclclass, const std::string_view aclclass)
+                             {
+                               ++conmatrix(ClassVocabulary::Intern(pclclass),ClassVocabulary::Intern(aclclass));
+                             }));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the (pcl,acl) pairs of a subsample to a confusion matrix, taking the user
+ *  classes of the subsample from an interned table instead of from text.  The pairing
+ *  and counting (and recording) are those of the text form.
+ *
+ *  @param [in]      pclfirst       the start of the apr (pcl) text
+ *  @param [in]      pcllast        the end of the apr (pcl) text
+ *  @param [in]      aclpatches     the user (acl) classes of the subsample
+ *  @param [in]      ssn            the one-based subsample number
+ *  @param [in,out]  conmatrix      the confusion matrix to add to
+ *  @param [in,out]  disagreements  the disagreements to append to (or nullptr)
+ *
+ *  @return  the number of patches in each subsample
+ */
+
+  APRT::PatchCounts APRT::LockstepComparator::Compare(const char* const                pclfirst,
+                                                      const char* const                pcllast,
+                                                      const LabelSpan&                 aclpatches,
+                                                      const uint32_t                   ssn,
+                                                      ConfusionMatrix<>&               conmatrix,
+                                                      std::vector<Disagreement>* const disagreements)
+    {
+      ClassificationScanner pclscanner(pclfirst,pcllast);
+      const bool pclfound = SeekSubsample(pclscanner,ssn);
+      if (disagreements != nullptr)
+        {
+          uint32_t patch = 0;
+          return (PairPatches(pclscanner,pclfound,aclpatches,
+                              [&](const std::string_view pclclass, const ClassId aclclass)
+                                {
+                                  Record(ClassVocabulary::Intern(pclclass),aclclass,
+                                         ssn,patch++,conmatrix,*disagreements);
+                                }));
+        }
+      return (PairPatches(pclscanner,pclfound,aclpatches,
+                          [&](const std::string_view pclclass, const ClassId aclclass)
+                            {
+                              ++conmatrix(ClassVocabulary::Intern(pclclass),aclclass);
+                            }));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the (pcl,acl) pairs of a subsample to a confusion matrix over an open
+ *  vocabulary, interning the codes the ClassVocabulary does not know into a LabelTable
+ *  and growing the matrix to match.  The pairing and counting are those of the fixed
+ *  vocabulary form.
+ *
+ *  @param [in]      pclfirst   the start of the apr (pcl) text
+ *  @param [in]      pcllast    the end of the apr (pcl) text
+ *  @param [in]      aclfirst   the start of the user (acl) text
+ *  @param [in]      acllast    the end of the user (acl) text
+ *  @param [in]      ssn        the one-based subsample number
+ *  @param [in,out]  labels     the vocabulary to intern the codes into
+ *  @param [in,out]  conmatrix  the confusion matrix to add to
+ *
+ *  @return  the number of patches in each subsample
+ */
+
+  APRT::PatchCounts APRT::LockstepComparator::Compare(const char* const       pclfirst,
+                                                      const char* const       pcllast,
+                                                      const char* const       aclfirst,
+                                                      const char* const       acllast,
+                                                      const uint32_t          ssn,
+                                                      LabelTable&             labels,
+                                                      DynamicConfusionMatrix& conmatrix)
+    {
+      return (ComparePairs(pclfirst,pcllast,aclfirst,acllast,ssn,
+                           [&](const std::string_view pclclass, const std::string_view aclclass)
+                             {
+                               const uint32_t pcl = labels.Intern(pclclass);
+                               const uint32_t acl = labels.Intern(aclclass);
+                               if (std::max(pcl,acl) >= conmatrix.Dim1())
+                                 {
+                                   conmatrix.Resize(labels.Size());
+                                 }
+                               ++conmatrix(pcl,acl);
+                             }));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the (pcl,acl) pairs of every subsample to a confusion tensor, pairing the
+ *  subsamples by number; a subsample only one text has is only counted.  Each text is
+ *  tokenized once.  With one job both texts are read in lockstep from start to end;
+ *  with more, the subsample boundaries are found first (by searching for the subsample
+ *  terminators alone) and the subsamples are compared concurrently, each into its own
+ *  matrix.  The result does not depend on the number of jobs.
+ *
+ *  @param [in]      pclfirst  the start of the apr (pcl) text
+ *  @param [in]      pcllast   the end of the apr (pcl) text
+ *  @param [in]      aclfirst  the start of the user (acl) text
+ *  @param [in]      acllast   the end of the user (acl) text
+ *  @param [in,out]  tensor    the confusion tensor to add to
+ *  @param [in]      jobs      the number of subsamples compared concurrently
+ */
+
+  void APRT::LockstepComparator::CompareAll(const char* const pclfirst,
+                                            const char* const pcllast,
+                                            const char* const aclfirst,
+                                            const char* const acllast,
+                                            ConfusionTensor&  tensor,
+                                            const uint32_t    jobs)
+    {
+      if (jobs <= 1)
+        {
+          ClassificationScanner pclscanner(pclfirst,pcllast);
+          ClassificationScanner aclscanner(aclfirst,acllast);
+          for (uint32_t ssn = 1; ; ++ssn)
+            {
+              const bool pclfound = pclscanner.NextSubsample();
+              const bool aclfound = aclscanner.NextSubsample();
+              if (!pclfound && !aclfound)
+                {
+                  break;
+                }
+              tensor.Resize(ssn);
+              ConfusionMatrix<>& conmatrix = tensor(ssn);
+              const auto count = [&](const std::string_view pclclass, const std::string_view aclclass)
+                {
+                  ++conmatrix(ClassVocabulary::Intern(pclclass),ClassVocabulary::Intern(aclclass));
+                };
+              tensor.Counts(ssn) += PairPatches(pclscanner,pclfound,aclscanner,aclfound,count);
+            }
+          return;
+        }
+//
+//  Find the subsamples, then compare them concurrently ...
+//
+      const std::vector<ClassificationScanner> pclsubsamples = FindSubsamples(pclfirst,pcllast);
+      const std::vector<ClassificationScanner> aclsubsamples = FindSubsamples(aclfirst,acllast);
+      const uint32_t subsamples = uint32_t(std::max(pclsubsamples.size(),aclsubsamples.size()));
+      tensor.Resize(subsamples);
+      ParallelFor(1,subsamples + 1,jobs,[&](const uint32_t ssn)
+        {
+          const bool pclfound = (ssn <= pclsubsamples.size());
+          const bool aclfound = (ssn <= aclsubsamples.size());
+          ClassificationScanner pclscanner = pclfound ? pclsubsamples[ssn - 1] : ClassificationScanner(pcllast,pcllast);
+          ClassificationScanner aclscanner = aclfound ? aclsubsamples[ssn - 1] : ClassificationScanner(acllast,acllast);
+          ConfusionMatrix<>& conmatrix = tensor(ssn);
+          const auto count = [&](const std::string_view pclclass, const std::string_view aclclass)
+            {
+              ++conmatrix(ClassVocabulary::Intern(pclclass),ClassVocabulary::Intern(aclclass));
+            };
+          tensor.Counts(ssn) += PairPatches(pclscanner,pclfound,aclscanner,aclfound,count);
+        });
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the (pcl,acl) pairs of every subsample to a confusion tensor, taking the user
+ *  classes from an interned table instead of from text.  The pairing and counting are
+ *  those of the text form.
+ *
+ *  @param [in]      pclfirst  the start of the apr (pcl) text
+ *  @param [in]      pcllast   the end of the apr (pcl) text
+ *  @param [in]      acltable  the user (acl) classes of every subsample
+ *  @param [in,out]  tensor    the confusion tensor to add to
+ *  @param [in]      jobs      the number of subsamples compared concurrently
+ */
+
+  void APRT::LockstepComparator::CompareAll(const char* const          pclfirst,
+                                            const char* const          pcllast,
+                                            const ClassificationTable& acltable,
+                                            ConfusionTensor&           tensor,
+                                            const uint32_t             jobs)
+    {
+      if (jobs <= 1)
+        {
+          ClassificationScanner pclscanner(pclfirst,pcllast);
+          for (uint32_t ssn = 1; ; ++ssn)
+            {
+              const bool pclfound = pclscanner.NextSubsample();
+              if (!pclfound && (ssn > acltable.Subsamples()))
+                {
+                  break;
+                }
+              tensor.Resize(ssn);
+              ConfusionMatrix<>& conmatrix = tensor(ssn);
+              const auto count = [&](const std::string_view pclclass, const ClassId aclclass)
+                {
+                  ++conmatrix(ClassVocabulary::Intern(pclclass),aclclass);
+                };
+              tensor.Counts(ssn) += PairPatches(pclscanner,pclfound,acltable.Subsample(ssn),count);
+            }
+          return;
+        }
+//
+//  Find the subsamples, then compare them concurrently ...
+//
+      const std::vector<ClassificationScanner> pclsubsamples = FindSubsamples(pclfirst,pcllast);
+      const uint32_t subsamples = std::max(uint32_t(pclsubsamples.size()),acltable.Subsamples());
+      tensor.Resize(subsamples);
+      ParallelFor(1,subsamples + 1,jobs,[&](const uint32_t ssn)
+        {
+          const bool pclfound = (ssn <= pclsubsamples.size());
+          ClassificationScanner pclscanner = pclfound ? pclsubsamples[ssn - 1] : ClassificationScanner(pcllast,pcllast);
+          ConfusionMatrix<>& conmatrix = tensor(ssn);
+          const auto count = [&](const std::string_view pclclass, const ClassId aclclass)
+            {
+              ++conmatrix(ClassVocabulary::Intern(pclclass),aclclass);
+            };
+          tensor.Counts(ssn) += PairPatches(pclscanner,pclfound,acltable.Subsample(ssn),count);
+        });
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the (pcl,acl) pairs of a subsample of several candidate apr texts to one
+ *  confusion matrix per candidate, all against the same interned user classes, so the
+ *  user side is parsed only once however many candidates there are.  The candidates are
+ *  tokenized concurrently, each into its own matrix; the pairing and counting are those
+ *  of Compare().  The result does not depend on the number of jobs.
+ *
+ *  @param [in]      pcltexts    the apr (pcl) text of each candidate
+ *  @param [in]      aclpatches  the user (acl) classes of the subsample
+ *  @param [in]      ssn         the one-based subsample number
+ *  @param [in,out]  matrices    the confusion matrices to add to, one per candidate
+ *  @param [in]      jobs        the number of candidates compared concurrently
+ */
+
+  void APRT::LockstepComparator::CompareCandidates(const std::vector<std::string_view>& pcltexts,
+                                                   const LabelSpan&                     aclpatches,
+                                                   const uint32_t                       ssn,
+                                                   CandidateMatrices&                   matrices,
+                                                   const uint32_t                       jobs)
+    {
+      assert(matrices.Candidates() == pcltexts.size());
+      ParallelFor(0,uint32_t(pcltexts.size()),jobs,[&](const uint32_t candidate)
+        {
+          const std::string_view pcltext = pcltexts[candidate];
+          matrices.Counts(candidate) += Compare(pcltext.data(),pcltext.data() + pcltext.size(),
+                                                aclpatches,ssn,matrices(candidate));
+        });
+    }
@@ -0,0 +1,96 @@
+/**
+ *  @file  LockstepComparator.h
+ *
+ *  @brief  Definition of the LockstepComparator class.
+ *
+ *  Definition of the LockstepComparator class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_LOCKSTEP_COMPARATOR_H_INCLUDED
+    #define APRT_LOCKSTEP_COMPARATOR_H_INCLUDED
+
+    #include <string_view>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "CandidateMatrices.h"
+    #include "ClassificationTable.h"
+    #include "ConfusionMatrix.h"
+    #include "ConfusionTensor.h"
+    #include "DisagreementIndex.h"
+    #include "DynamicConfusionMatrix.h"
+    #include "LabelTable.h"
+    #include "PatchCounts.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  Compares a subsample of acl/pcl text held in memory by tokenizing both inputs in
+ *  lockstep and counting each (pcl,acl) pair as it is produced.  No classification list
+ *  is built and nothing is allocated per patch, so memory use is constant.  The user
+ *  side may instead be a subsample already interned (e.g. by a ClassificationCache),
+ *  and the codes may instead be interned into an open LabelTable.  The fixed vocabulary
+ *  forms can also record each disagreeing patch, for a DisagreementIndex.  CompareAll() compares
+ *  every subsample in one pass, into a ConfusionTensor; CompareCandidates() compares
+ *  several apr texts against one interned user subsample.
+ */
+
+        class LockstepComparator
+          {
+            public:
+              static PatchCounts
+                Compare(const char*        pclfirst,
+                        const char*        pcllast,
+                        const char*        aclfirst,
+                        const char*        acllast,
+                        uint32_t           ssn,
+                        ConfusionMatrix<>& conmatrix,
+                        std::vector<Disagreement>*
+                                           disagreements = nullptr);
+              static PatchCounts
+                Compare(const char*        pclfirst,
+                        const char*        pcllast,
+                        const LabelSpan&   aclpatches,
+                        uint32_t           ssn,
+                        ConfusionMatrix<>& conmatrix,
+                        std::vector<Disagreement>*
+                                           disagreements = nullptr);
+              static PatchCounts
+                Compare(const char*             pclfirst,
+                        const char*             pcllast,
+                        const char*             aclfirst,
+                        const char*             acllast,
+                        uint32_t                ssn,
+                        LabelTable&             labels,
+                        DynamicConfusionMatrix& conmatrix);
+              static void
+                CompareAll(const char*      pclfirst,
+                           const char*      pcllast,
+                           const char*      aclfirst,
+                           const char*      acllast,
+                           ConfusionTensor& tensor,
+                           uint32_t         jobs = 1);
+              static void
+                CompareAll(const char*                pclfirst,
+                           const char*                pcllast,
+                           const ClassificationTable& acltable,
+                           ConfusionTensor&           tensor,
+                           uint32_t                   jobs = 1);
+              static void
+                CompareCandidates(const std::vector<std::string_view>& pcltexts,
+                                  const LabelSpan&                     aclpatches,
+                                  uint32_t                             ssn,
+                                  CandidateMatrices&                   matrices,
+                                  uint32_t                             jobs);
+          };
+      }
+
+  #endif
@@ -0,0 +1,31 @@
+/**
+ *  @file  MappedFile.cpp
+ *
+ *  @brief  Implementation of the MappedFile class.
+ *
+ *  Implementation of the MappedFile class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "MappedFile.h"
+
+  #include <boost/filesystem.hpp>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps the file at the given path.
+ *
+ *  @param [in]  path  the file path
+ */
+
+  APRT::MappedFile::MappedFile(const std::string& path)
+    {
+      if (boost::filesystem::file_size(path) != 0)
+        {
+          this->file.open(path);
+        }
+    }
@@ -0,0 +1,90 @@
+/**
+ *  @file  MappedFile.h
+ *
+ *  @brief  Definition of the MappedFile class.
+ *
+ *  Definition of the MappedFile class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_MAPPED_FILE_H_INCLUDED
+    #define APRT_MAPPED_FILE_H_INCLUDED
+
+    #include <boost/iostreams/device/mapped_file.hpp>
+
+    #include <string>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  A read-only memory mapping of a whole file.  An empty file (which cannot be mapped)
+ *  gives an empty range.
+ */
+
+        class MappedFile
+          {
+            public:
+              explicit MappedFile(const std::string& path);
+
+            public:
+              const char*  Begin() const;
+              const char*  End() const;
+              size_t       Size() const;
+            private:
+              boost::iostreams::mapped_file_source file;
+                /**< @brief  the mapping (closed for an empty file) */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the start of the mapped file.
+ *
+ *  @return  the first byte
+ */
+
+    inline const char* APRT::MappedFile::Begin() const
+      {
+        return (this->file.is_open() ? this->file.data() : nullptr);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the end of the mapped file.
+ *
+ *  @return  one past the last byte
+ */
+
+    inline const char* APRT::MappedFile::End() const
+      {
+        return (this->Begin() + this->Size());
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the size of the mapped file.
+ *
+ *  @return  the size in bytes
+ */
+
+    inline size_t APRT::MappedFile::Size() const
+      {
+        return (this->file.is_open() ? this->file.size() : 0);
+      }
+
+  #endif
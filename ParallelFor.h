@@ -0,0 +1,96 @@
+/**
+ *  @file  ParallelFor.h
+ *
+ *  @brief  Definition of the ParallelFor function.
+ *
+ *  Definition of the ParallelFor function.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PARALLEL_FOR_H_INCLUDED
+    #define APRT_PARALLEL_FOR_H_INCLUDED
+
+    #include <algorithm>
+    #include <atomic>
+    #include <exception>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+
+    #include <stdint.h>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+        template <typename Function>
+          void ParallelFor(uint32_t first,
+                           uint32_t last,
+                           uint32_t jobs,
+                           Function function);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Calls a function for each of the numbers first..last-1 (subsamples, candidates,
+ *  particles, ...), spread over up to jobs threads (the calling thread being one of
+ *  them).  Each thread claims the next unclaimed number.  The first failure is rethrown
+ *  once every thread has stopped.
+ *
+ *  @param [in]  first     the first number
+ *  @param [in]  last      one past the last number (not less than first)
+ *  @param [in]  jobs      the most threads to use
+ *  @param [in]  function  the function to call with each number
+ */
+
+    template <typename Function>
+      void APRT::ParallelFor(const uint32_t first,
+                             const uint32_t last,
+                             const uint32_t jobs,
+                             Function       function)
+        {
+          std::atomic<uint32_t> unclaimed(first);
+          std::exception_ptr    failure;
+          std::mutex            mutex;
+          const auto work = [&]()
+            {
+              try
+                {
+                  for (uint32_t number; (number = unclaimed++) < last; )
+                    {
+                      function(number);
+                    }
+                }
+              catch (...)
+                {
+                  unclaimed = last;
+                  std::lock_guard<std::mutex> lock(mutex);
+                  if (!failure)
+                    {
+                      failure = std::current_exception();
+                    }
+                }
+            };
+          std::vector<std::thread> pool;
+          for (uint32_t worker = 1; worker < std::min(jobs,last - first); ++worker)
+            {
+              pool.emplace_back(work);
+            }
+          work();
+          for (std::thread& thread : pool)
+            {
+              thread.join();
+            }
+          if (failure)
+            {
+              std::rethrow_exception(failure);
+            }
+        }
+
+  #endif
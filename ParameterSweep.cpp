@@ -0,0 +1,151 @@
+/**
+ *  @file  ParameterSweep.cpp
+ *
+ *  @brief  Implementation of the ParameterSweep class.
+ *
+ *  Implementation of the ParameterSweep class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "ParameterSweep.h"
+
+  #include <fstream>
+  #include <stdexcept>
+  #include <utility>
+
+  #include <cassert>
+
+  #include "ParallelFor.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a ParameterSweep.
+ *
+ *  @param [in]  corpus      the loaded feature vectors and user classes (kept by
+ *                           reference)
+ *  @param [in]  classifier  the classifier being tuned
+ */
+
+  APRT::ParameterSweep::ParameterSweep(const FeatureEvaluator& corpus,
+                                       TunableClassifier       classifier)
+    : corpus(corpus),
+      classifier(std::move(classifier))
+      {
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Evaluates every configuration, spread over the jobs.  A worker evaluates a whole
+ *  configuration over the corpus, then claims the next, so an expensive configuration
+ *  holds up only its own worker.  The results replace those of any previous run.
+ *
+ *  @param [in]  configurations  the parameters of each configuration
+ *  @param [in]  jobs            the number of configurations evaluated concurrently
+ *
+ *  @throw  std::runtime_error  if the classifier returns a class outside the vocabulary
+ */
+
+  void APRT::ParameterSweep::Run(const std::vector<std::vector<float>>& configurations,
+                                 const uint32_t                         jobs)
+    {
+      this->configurations = configurations;
+      this->matrices.assign(configurations.size(),ConfusionMatrix<>());
+      ParallelFor(0,uint32_t(configurations.size()),jobs,[&](const uint32_t configuration)
+        {
+          const std::vector<float>& parameters = this->configurations[configuration];
+          this->matrices[configuration] = this->corpus.Evaluate([&](const float* features)
+                                                                  {
+                                                                    return (this->classifier(features,parameters));
+                                                                  },
+                                                                1);
+        });
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the confusion matrix of a configuration.
+ *
+ *  @param [in]  configuration  the configuration (its position in the last run)
+ *
+ *  @return  the matrix
+ */
+
+  const APRT::ConfusionMatrix<>& APRT::ParameterSweep::Matrix(const uint32_t configuration) const
+    {
+      assert(configuration < this->matrices.size());
+      return (this->matrices[configuration]);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the metrics of a configuration.
+ *
+ *  @param [in]  configuration  the configuration (its position in the last run)
+ *
+ *  @return  the metrics
+ */
+
+  APRT::ClassificationMetrics APRT::ParameterSweep::Metrics(const uint32_t configuration) const
+    {
+      return (Summarize(this->Matrix(configuration)));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes the metrics of every configuration as a tab-separated table: a header line,
+ *  then per configuration its number, its parameters, the patches counted, accuracy,
+ *  macro precision, recall and F1 and Cohen's kappa.
+ *
+ *  @param [in]  path        the table path
+ *  @param [in]  parameters  the name of each parameter (for the header)
+ */
+
+  void APRT::ParameterSweep::Write(const std::string&              path,
+                                   const std::vector<std::string>& parameters) const
+    {
+      std::ofstream stream(path.c_str(),std::ios_base::trunc);
+      stream << "configuration";
+      for (const std::string& parameter : parameters)
+        {
+          stream << '\t' << parameter;
+        }
+      stream << "\tpatches\taccuracy\tprecision\trecall\tf1\tkappa\n";
+      stream.precision(6);
+      for (uint32_t configuration = 0; configuration < this->matrices.size(); ++configuration)
+        {
+          const ClassificationMetrics metrics = this->Metrics(configuration);
+          stream << configuration;
+          for (const float value : this->configurations[configuration])
+            {
+              stream << '\t' << value;
+            }
+          stream << '\t' << metrics.patches
+                 << '\t' << metrics.accuracy
+                 << '\t' << metrics.precision
+                 << '\t' << metrics.recall
+                 << '\t' << metrics.f1
+                 << '\t' << metrics.kappa
+                 << '\n';
+        }
+      stream.close();
+      if (!stream)
+        {
+          throw std::runtime_error("Unable to write the sweep table " + path + ".");
+        }
+    }
@@ -0,0 +1,76 @@
+/**
+ *  @file  ParameterSweep.h
+ *
+ *  @brief  Definition of the ParameterSweep class.
+ *
+ *  Definition of the ParameterSweep class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PARAMETER_SWEEP_H_INCLUDED
+    #define APRT_PARAMETER_SWEEP_H_INCLUDED
+
+    #include <functional>
+    #include <string>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "ClassificationMetrics.h"
+    #include "ClassVocabulary.h"
+    #include "ConfusionMatrix.h"
+    #include "FeatureEvaluator.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  Classifies a particle from its feature vector (or per-patch scores) under a
+ *          configuration of parameters (thresholds, ...), returning its apr class (an
+ *          id of the built ClassVocabulary).  Called from several threads at once.
+ */
+
+        typedef std::function<ClassId (const float*              features,
+                                       const std::vector<float>& parameters)> TunableClassifier;
+
+/**
+ *  Evaluates a classifier under many configurations of its parameters against one
+ *  corpus.  The corpus (the feature vectors or scores and the user classes, loaded once
+ *  by a FeatureEvaluator) is shared read-only by every worker; the workers claim the
+ *  configurations one at a time, as each finishes its last, and each fills the
+ *  confusion matrix of the configuration it claimed.  The results are summed up as one
+ *  table of metrics per configuration.
+ */
+
+        class ParameterSweep
+          {
+            public:
+              ParameterSweep(const FeatureEvaluator& corpus,
+                             TunableClassifier       classifier);
+
+            public:
+              void                  Run(const std::vector<std::vector<float>>& configurations,
+                                        uint32_t                               jobs);
+              const ConfusionMatrix<>&
+                                    Matrix(uint32_t configuration) const;
+              ClassificationMetrics Metrics(uint32_t configuration) const;
+              void                  Write(const std::string&              path,
+                                          const std::vector<std::string>& parameters) const;
+            private:
+              const FeatureEvaluator&          corpus;
+                /**< @brief  the feature vectors and user classes */
+              const TunableClassifier          classifier;
+                /**< @brief  the classifier being tuned */
+              std::vector<std::vector<float>>  configurations;
+                /**< @brief  the parameters of each configuration run */
+              std::vector<ConfusionMatrix<>>   matrices;
+                /**< @brief  the matrix of each configuration run */
+          };
+      }
+
+  #endif
@@ -0,0 +1,567 @@
+/**
+ *  @file  ParserCheck.cpp
+ *
+ *  @brief  The parsercheck command-line program.
+ *
+ *  The parsercheck command-line program.  It generates random acl/pcl text (well formed
+ *  <CLASS> blocks mixed with stray tags, whitespace, empty and unknown codes, embedded
+ *  spaces, unterminated fields and random bytes) and checks, for every delimiter search
+ *  instruction set the processor supports, that all the parsers and comparators agree
+ *  with the reference ones:
+ *
+ *    - DelimiterScanner::Find, Count and Mask against byte-by-byte searches, from every
+ *      start position;
+ *    - ClassificationList(path), with all and with one subsample, and ClassificationTable
+ *      against ClassificationList(istream), the stream parser;
+ *    - LockstepComparator::Compare (on text and on a table subsample, with and without
+ *      the disagreements) and CompareAll (on text and on a table, with 1 and 4 jobs) against
+ *      pairing the patches of the parsed lists.
+ *
+ *    parsercheck [--iterations N] [--seed N] [--dir D]
+ *
+ *  The first mismatch is reported with the seed and iteration that produced it, and the
+ *  program fails; otherwise it reports the inputs checked and succeeds.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include <boost/filesystem.hpp>
+  #include <boost/lexical_cast.hpp>
+
+  #include <fstream>
+  #include <iostream>
+  #include <random>
+  #include <sstream>
+  #include <stdexcept>
+  #include <string>
+  #include <string_view>
+  #include <vector>
+
+  #include <cstdlib>
+
+  #include "ClassificationList.h"
+  #include "ClassificationTable.h"
+  #include "ClassVocabulary.h"
+  #include "ConfusionMatrix.h"
+  #include "ConfusionTensor.h"
+  #include "DelimiterScanner.h"
+  #include "DisagreementIndex.h"
+  #include "LockstepComparator.h"
+  #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The random acl/pcl text generator.  The draws are mapped by hand rather than through
+ *  the (implementation-defined) standard distributions, so a seed gives the same text on
+ *  every platform.
+ */
+
+        class TextGenerator
+          {
+            public:
+              explicit TextGenerator(const uint64_t seed) : engine(seed) {}
+
+            public:
+              uint32_t     Below(uint32_t bound);
+              std::string  Field();
+              std::string  Text();
+            private:
+              std::mt19937_64  engine;
+                /**< @brief  the random source */
+          };
+
+/**
+ *  Returns a random number in [0,bound).
+ */
+
+        uint32_t TextGenerator::Below(const uint32_t bound)
+          {
+            return (uint32_t(this->engine() % bound));
+          }
+
+/**
+ *  Returns a random class field: usually a known code, sometimes an empty, unknown,
+ *  spaced or random one.
+ */
+
+        std::string TextGenerator::Field()
+          {
+            static const char        noise[]  = " \t\r\n,<>/CLASxyz";
+            static const char* const others[] = {"", "XYZ", "NONE", "R BC", " WBC ", "\tRBC", "rbc"};
+            const uint32_t kind = this->Below(20);
+            if (kind < 14)
+              {
+                return (std::string(APRT::ClassVocabulary::Code(APRT::ClassId(this->Below(APRT::ClassVocabulary::Size)))));
+              }
+            if (kind < 19)
+              {
+                return (others[this->Below(sizeof(others) / sizeof(others[0]))]);
+              }
+            std::string field;
+            for (uint32_t length = this->Below(4); length != 0; --length)
+              {
+                field.push_back(noise[this->Below(sizeof(noise) - 1)]);
+              }
+            return (field);
+          }
+
+/**
+ *  Returns a random acl/pcl text of a few lines.
+ */
+
+        std::string TextGenerator::Text()
+          {
+            static const char* const separators[] = {",", ",", ",", ", ", " ,", ",\n", ",\r\n", "\n,"};
+            static const char* const lines[]      = {"<HEADER>x</HEADER>", "<OTHER>a,b</OTHER>", "", "  ",
+                                                     "<CLASS", "CLASS>", "<CLASSES>RBC,</CLASSES>"};
+            std::string text;
+            for (uint32_t line = this->Below(6); line != 0; --line)
+              {
+                const uint32_t kind = this->Below(10);
+                if (kind < 7)
+                  {
+                    text += (this->Below(4) == 0) ? " \t<CLASS>" : "<CLASS>";
+                    const uint32_t fields = (this->Below(8) == 0) ? 60 + this->Below(200) : this->Below(12);
+                    for (uint32_t field = 0; field < fields; ++field)
+                      {
+                        if (field != 0)
+                          {
+                            text += separators[this->Below(sizeof(separators) / sizeof(separators[0]))];
+                          }
+                        text += this->Field();
+                      }
+                    const uint32_t end = this->Below(8);
+                    text += (end == 0) ? "" : (end == 1) ? "," : (end == 2) ? "<" : "</CLASS>";
+                  }
+                else if (kind < 9)
+                  {
+                    text += lines[this->Below(sizeof(lines) / sizeof(lines[0]))];
+                  }
+                else
+                  {
+                    for (uint32_t length = this->Below(80); length != 0; --length)
+                      {
+                        text.push_back(char(this->Below(256)));
+                      }
+                  }
+                text += (this->Below(4) == 0) ? "\r\n" : (this->Below(8) == 0) ? "" : "\n";
+              }
+            return (text);
+          }
+
+/**
+ *  Throws a mismatch report.
+ */
+
+        void Fail(const std::string& what)
+          {
+            throw std::runtime_error(what);
+          }
+
+/**
+ *  Checks the delimiter searches of the selected instruction set against byte-by-byte
+ *  searches, from every start position of the text.
+ */
+
+        void CheckScanner(const std::string& text)
+          {
+            const char* const begin = text.data();
+            const char* const end   = text.data() + text.size();
+            static const char pairs[][2] = {{',','<'}, {'>','>'}, {'\n','\n'}, {'<','<'}};
+            for (const char* first = begin; first <= end; ++first)
+              {
+                for (const char* const pair : pairs)
+                  {
+                    const char* one = first;
+                    while ((one != end) && (*one != pair[0]))
+                      {
+                        ++one;
+                      }
+                    const char* two = first;
+                    while ((two != end) && (*two != pair[0]) && (*two != pair[1]))
+                      {
+                        ++two;
+                      }
+                    size_t   count = 0;
+                    uint64_t mask  = 0;
+                    for (const char* next = first; next != end; ++next)
+                      {
+                        count += (*next == pair[0]);
+                        if ((next - first < 64) && ((*next == pair[0]) || (*next == pair[1])))
+                          {
+                            mask |= uint64_t(1) << (next - first);
+                          }
+                      }
+                    if ((APRT::DelimiterScanner::Find(first,end,pair[0])         != one)   ||
+                        (APRT::DelimiterScanner::Find(first,end,pair[0],pair[1]) != two)   ||
+                        (APRT::DelimiterScanner::Count(first,end,pair[0])        != count) ||
+                        ((first != end) && (APRT::DelimiterScanner::Mask(first,end,pair[0],pair[1]) != mask)))
+                      {
+                        Fail("delimiter search mismatch at offset " + std::to_string(first - begin));
+                      }
+                  }
+              }
+          }
+
+/**
+ *  Checks that two lists hold the same subsamples (the given ones only, if any).
+ */
+
+        void CheckList(const APRT::ClassificationList& list,
+                       const APRT::ClassificationList& reference,
+                       const uint32_t                  ssn,
+                       const std::string&              what)
+          {
+            const std::vector<std::vector<APRT::PatchClassification> >& actual   = list.Classifications();
+            const std::vector<std::vector<APRT::PatchClassification> >& expected = reference.Classifications();
+            const size_t subsamples = (ssn == 0) ? expected.size() : std::min<size_t>(ssn,expected.size());
+            if (actual.size() != subsamples)
+              {
+                Fail(what + " subsample count mismatch");
+              }
+            for (uint32_t index = 0; index < subsamples; ++index)
+              {
+                if ((ssn != 0) && (index + 1 != ssn))
+                  {
+                    if (!actual[index].empty())
+                      {
+                        Fail(what + " parsed an unrequested subsample");
+                      }
+                    continue;
+                  }
+                if (actual[index].size() != expected[index].size())
+                  {
+                    Fail(what + " patch count mismatch in subsample " + std::to_string(index + 1));
+                  }
+                for (size_t patch = 0; patch < actual[index].size(); ++patch)
+                  {
+                    const APRT::PatchClassification& a = actual[index][patch];
+                    const APRT::PatchClassification& e = expected[index][patch];
+                    if ((a.subsampleNumber != e.subsampleNumber) || (a.patchIndex != e.patchIndex) ||
+                        (a.classification  != e.classification)  || (a.classId    != e.classId))
+                      {
+                        Fail(what + " patch mismatch in subsample " + std::to_string(index + 1));
+                      }
+                  }
+              }
+          }
+
+/**
+ *  Checks that a table holds the classes of the subsamples of a list (the given ones
+ *  only, if any).
+ */
+
+        void CheckTable(const APRT::ClassificationTable& table,
+                        const APRT::ClassificationList&  reference,
+                        const uint32_t                   ssn,
+                        const std::string&               what)
+          {
+            const std::vector<std::vector<APRT::PatchClassification> >& expected = reference.Classifications();
+            const size_t subsamples = (ssn == 0) ? expected.size() : std::min<size_t>(ssn,expected.size());
+            if (table.Subsamples() != subsamples)
+              {
+                Fail(what + " subsample count mismatch");
+              }
+            for (uint32_t index = 0; index < subsamples; ++index)
+              {
+                const APRT::LabelSpan span = table.Subsample(index + 1);
+                if ((ssn != 0) && (index + 1 != ssn))
+                  {
+                    if (span.size() != 0)
+                      {
+                        Fail(what + " parsed an unrequested subsample");
+                      }
+                    continue;
+                  }
+                if (span.size() != expected[index].size())
+                  {
+                    Fail(what + " patch count mismatch in subsample " + std::to_string(index + 1));
+                  }
+                for (size_t patch = 0; patch < span.size(); ++patch)
+                  {
+                    if (span[patch] != expected[index][patch].classId)
+                      {
+                        Fail(what + " class mismatch in subsample " + std::to_string(index + 1));
+                      }
+                  }
+              }
+          }
+
+/**
+ *  Pairs the patches of a subsample of two lists: the matrix, the patch counts and the
+ *  disagreements (in patch order) of the reference comparison.
+ */
+
+        APRT::PatchCounts Pair(const APRT::ClassificationList&      pcllist,
+                               const APRT::ClassificationList&      acllist,
+                               const uint32_t                       ssn,
+                               APRT::ConfusionMatrix<>&             conmatrix,
+                               std::vector<APRT::Disagreement>&     disagreements)
+          {
+            static const std::vector<APRT::PatchClassification> none;
+            const std::vector<APRT::PatchClassification>& pcl =
+                (ssn <= pcllist.Classifications().size()) ? pcllist.Classifications()[ssn - 1] : none;
+            const std::vector<APRT::PatchClassification>& acl =
+                (ssn <= acllist.Classifications().size()) ? acllist.Classifications()[ssn - 1] : none;
+            for (size_t patch = 0; patch < std::min(pcl.size(),acl.size()); ++patch)
+              {
+                ++conmatrix(pcl[patch].classId,acl[patch].classId);
+                if (pcl[patch].classId != acl[patch].classId)
+                  {
+                    disagreements.push_back(APRT::Disagreement{0,uint16_t(ssn),pcl[patch].classId,
+                                                               acl[patch].classId,uint32_t(patch)});
+                  }
+              }
+            return (APRT::PatchCounts{pcl.size(),acl.size()});
+          }
+
+/**
+ *  Returns true if two matrices hold the same counts.
+ */
+
+        bool Equal(const APRT::ConfusionMatrix<>& a,
+                   const APRT::ConfusionMatrix<>& b)
+          {
+            for (uint32_t pcl = 0; pcl < a.Dim1(); ++pcl)
+              {
+                for (uint32_t acl = 0; acl < a.Dim2(); ++acl)
+                  {
+                    if (a(pcl,acl) != b(pcl,acl))
+                      {
+                        return (false);
+                      }
+                  }
+              }
+            return (true);
+          }
+
+/**
+ *  Checks the comparators on an acl/pcl pair against pairing the patches of their lists.
+ */
+
+        void CheckComparators(const APRT::MappedFile&         pclfile,
+                              const APRT::MappedFile&         aclfile,
+                              const APRT::ClassificationList& pcllist,
+                              const APRT::ClassificationList& acllist,
+                              const APRT::ClassificationTable& acltable)
+          {
+            const uint32_t subsamples = uint32_t(std::max(pcllist.Classifications().size(),
+                                                          acllist.Classifications().size()));
+            std::vector<APRT::ConfusionMatrix<> > expected(subsamples + 2);
+            std::vector<APRT::PatchCounts>        counts(subsamples + 2);
+            for (uint32_t ssn = 1; ssn <= subsamples + 1; ++ssn)
+              {
+                std::vector<APRT::Disagreement> disagreements;
+                counts[ssn] = Pair(pcllist,acllist,ssn,expected[ssn],disagreements);
+                for (int variant = 0; variant < 4; ++variant)
+                  {
+                    const bool                      table  = (variant & 1) != 0;
+                    const bool                      record = (variant & 2) != 0;
+                    APRT::ConfusionMatrix<>         conmatrix;
+                    std::vector<APRT::Disagreement> found;
+                    std::vector<APRT::Disagreement>* const recorded = record ? &found : nullptr;
+                    const APRT::PatchCounts actual = table ?
+                        APRT::LockstepComparator::Compare(pclfile.Begin(),pclfile.End(),
+                                                          acltable.Subsample(ssn),ssn,conmatrix,recorded) :
+                        APRT::LockstepComparator::Compare(pclfile.Begin(),pclfile.End(),
+                                                          aclfile.Begin(),aclfile.End(),ssn,conmatrix,recorded);
+                    const std::string what = std::string(table ? "Compare (table)" : "Compare") +
+                                             (record ? " with disagreements" : "");
+                    if ((actual.pcl != counts[ssn].pcl) || (actual.acl != counts[ssn].acl))
+                      {
+                        Fail(what + " patch count mismatch in subsample " + std::to_string(ssn));
+                      }
+                    if (!Equal(conmatrix,expected[ssn]))
+                      {
+                        Fail(what + " matrix mismatch in subsample " + std::to_string(ssn));
+                      }
+                    bool same = !record || (found.size() == disagreements.size());
+                    for (size_t index = 0; same && record && (index < found.size()); ++index)
+                      {
+                        same = (found[index].subsample == disagreements[index].subsample) &&
+                               (found[index].patch     == disagreements[index].patch)     &&
+                               (found[index].pcl       == disagreements[index].pcl)       &&
+                               (found[index].acl       == disagreements[index].acl);
+                      }
+                    if (!same)
+                      {
+                        Fail(what + " disagreement mismatch in subsample " + std::to_string(ssn));
+                      }
+                  }
+              }
+            for (const uint32_t jobs : {1U, 4U})
+              {
+                for (int table = 0; table < 2; ++table)
+                  {
+                    APRT::ConfusionTensor tensor;
+                    if (table == 0)
+                      {
+                        APRT::LockstepComparator::CompareAll(pclfile.Begin(),pclfile.End(),
+                                                             aclfile.Begin(),aclfile.End(),tensor,jobs);
+                      }
+                    else
+                      {
+                        APRT::LockstepComparator::CompareAll(pclfile.Begin(),pclfile.End(),acltable,tensor,jobs);
+                      }
+                    const std::string what = std::string((table == 0) ? "CompareAll" : "CompareAll (table)") +
+                                             " with " + std::to_string(jobs) + " jobs";
+                    if (tensor.Subsamples() > subsamples)
+                      {
+                        Fail(what + " subsample count mismatch");
+                      }
+                    for (uint32_t ssn = 1; ssn <= tensor.Subsamples(); ++ssn)
+                      {
+                        if ((tensor.Counts(ssn).pcl != counts[ssn].pcl) || (tensor.Counts(ssn).acl != counts[ssn].acl) ||
+                            !Equal(tensor(ssn),expected[ssn]))
+                          {
+                            Fail(what + " mismatch in subsample " + std::to_string(ssn));
+                          }
+                      }
+                    for (uint32_t ssn = tensor.Subsamples() + 1; ssn <= subsamples; ++ssn)
+                      {
+                        if ((counts[ssn].pcl != 0) || (counts[ssn].acl != 0))
+                          {
+                            Fail(what + " dropped subsample " + std::to_string(ssn));
+                          }
+                      }
+                  }
+              }
+          }
+
+/**
+ *  Writes a text file.
+ */
+
+        void WriteText(const std::string& path,
+                       const std::string& text)
+          {
+            std::ofstream stream(path.c_str(),std::ios_base::binary | std::ios_base::trunc);
+            stream << text;
+            stream.close();
+            if (!stream)
+              {
+                throw std::runtime_error("Unable to write " + path + ".");
+              }
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The main entry point to the program.
+ *
+ *  @param [in]  argc  the number of input arguments
+ *  @param [in]  argv  the strings of input arguments
+ *
+ *  @return  EXIT_SUCCESS, or EXIT_FAILURE upon a mismatch or an exception
+ */
+
+  int main(int argc, char* argv[])
+    {
+      uint64_t iterations = 2000;
+      uint64_t seed       = 1;
+      uint64_t iteration  = 0;
+      std::string directory = (boost::filesystem::temp_directory_path() /
+                               boost::filesystem::unique_path("parsercheck-%%%%%%%%")).string();
+      try
+        {
+          for (int i = 1; i < argc; ++i)
+            {
+              const std::string argument(argv[i]);
+              if ((argument == "--iterations") && (i + 1 < argc))
+                {
+                  iterations = boost::lexical_cast<uint64_t>(argv[++i]);
+                }
+              else if ((argument == "--seed") && (i + 1 < argc))
+                {
+                  seed = boost::lexical_cast<uint64_t>(argv[++i]);
+                }
+              else if ((argument == "--dir") && (i + 1 < argc))
+                {
+                  directory = argv[++i];
+                }
+              else
+                {
+                  std::cout << "Usage: parsercheck [--iterations N] [--seed N] [--dir D]" << std::endl;
+                  return (EXIT_FAILURE);
+                }
+            }
+          boost::filesystem::create_directories(directory);
+          const std::string pclpath = (boost::filesystem::path(directory) / "check.pcl").string();
+          const std::string aclpath = (boost::filesystem::path(directory) / "check.acl").string();
+//
+//  Check each random pair with every supported instruction set ...
+//
+          TextGenerator generator(seed);
+          const APRT::DelimiterScanner::Isa best = APRT::DelimiterScanner::Best();
+          for (iteration = 0; iteration < iterations; ++iteration)
+            {
+              const std::string pcltext = generator.Text();
+              const std::string acltext = generator.Text();
+              WriteText(pclpath,pcltext);
+              WriteText(aclpath,acltext);
+              std::istringstream pclstream(pcltext);
+              std::istringstream aclstream(acltext);
+              const APRT::ClassificationList pclreference(pclstream);
+              const APRT::ClassificationList aclreference(aclstream);
+              const uint32_t ssn = 1 + generator.Below(3);
+              for (int isa = APRT::DelimiterScanner::Scalar; isa <= best; ++isa)
+                {
+                  APRT::DelimiterScanner::Select(APRT::DelimiterScanner::Isa(isa));
+                  CheckScanner(pcltext);
+                  CheckList(APRT::ClassificationList(pclpath),pclreference,0,"ClassificationList(path)");
+                  CheckList(APRT::ClassificationList(pclpath,std::vector<uint32_t>(1,ssn)),pclreference,ssn,
+                            "ClassificationList(path,subsample)");
+                  CheckTable(APRT::ClassificationTable(pclpath),pclreference,0,"ClassificationTable(path)");
+                  CheckTable(APRT::ClassificationTable(pclpath,std::vector<uint32_t>(1,ssn)),pclreference,ssn,
+                             "ClassificationTable(path,subsample)");
+                  const APRT::MappedFile          pclfile(pclpath);
+                  const APRT::MappedFile          aclfile(aclpath);
+                  const APRT::ClassificationTable acltable(aclpath);
+                  CheckComparators(pclfile,aclfile,pclreference,aclreference,acltable);
+                }
+            }
+          APRT::DelimiterScanner::Select(best);
+          boost::filesystem::remove_all(directory);
+
+          std::cout << "Checked "
+                    << iterations
+                    << " input pairs (seed "
+                    << seed
+                    << ") with the scalar"
+                    << ((best >= APRT::DelimiterScanner::Sse2)   ? ", sse2"   : "")
+                    << ((best >= APRT::DelimiterScanner::Avx2)   ? ", avx2"   : "")
+                    << ((best >= APRT::DelimiterScanner::Avx512) ? ", avx512" : "")
+                    << " searches."
+                    << std::endl;
+          return (EXIT_SUCCESS);
+        }
+
+      catch (const boost::bad_lexical_cast&)
+        {
+          std::cout << "Invalid argument list. Try again." << std::endl;
+        }
+
+      catch (const std::exception& e)
+        {
+          std::cout << "Seed "
+                    << seed
+                    << ", iteration "
+                    << iteration
+                    << " ("
+                    << APRT::DelimiterScanner::Name(APRT::DelimiterScanner::Selected())
+                    << "): "
+                    << e.what()
+                    << std::endl;
+        }
+
+      return (EXIT_FAILURE);
+    }
@@ -0,0 +1,76 @@
+/**
+ *  @file  ParticleSource.h
+ *
+ *  @brief  Definition of the ParticleSource interface.
+ *
+ *  Definition of the ParticleSource interface.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PARTICLE_SOURCE_H_INCLUDED
+    #define APRT_PARTICLE_SOURCE_H_INCLUDED
+
+    #include <functional>
+    #include <memory>
+    #include <string>
+    #include <vector>
+
+    #include <stdint.h>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  A decoded (debayered) patch: 8-bit RGB pixels, row by row.
+ */
+
+        struct PatchImage
+          {
+            uint32_t              width;   /**< @brief  the width in pixels          */
+            uint32_t              height;  /**< @brief  the height in pixels         */
+            std::vector<uint8_t>  pixels;  /**< @brief  width*height RGB triplets     */
+          };
+
+/**
+ *  The particles of one subsample of a runfile, in patch index order.  The runfile is
+ *  read when the source is opened; Decode() only decodes and debayers a particle already
+ *  in memory, and may be called from several threads at once, so the particles of a
+ *  runfile can be decoded concurrently.  Measure() likewise computes the feature vector
+ *  of a particle: a value for each of the features named with the factory (see
+ *  SortOptions::features).  The implementation decoding real runfiles needs the ISL image
+ *  stack and is not part of this tree; a program that links one passes its factory as
+ *  SortOptions::particles.
+ */
+
+        class ParticleSource
+          {
+            public:
+              virtual ~ParticleSource() {}
+
+            public:
+              virtual uint32_t  Particles() const = 0;
+                /**< @brief  the number of particles in the subsample */
+              virtual void      Decode(uint32_t    index,
+                                       PatchImage& image) const = 0;
+                /**< @brief  decodes and debayers the particle of a patch index */
+              virtual void      Measure(uint32_t index,
+                                        float*   features) const = 0;
+                /**< @brief  computes the features of the particle of a patch index */
+          };
+
+/**
+ *  @brief  Opens the particles of a subsample (one-based) of a runfile, given its path
+ *          (the runfile list directory and name).
+ */
+
+        typedef std::function<std::unique_ptr<ParticleSource> (const std::string& runfile,
+                                                               uint32_t           ssn)>
+                ParticleSourceFactory;
+      }
+
+  #endif
@@ -0,0 +1,258 @@
+/**
+ *  @file  PatchContainer.cpp
+ *
+ *  @brief  Implementation of the PatchContainer and PatchContainerWriter classes.
+ *
+ *  Implementation of the PatchContainer and PatchContainerWriter classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "PatchContainer.h"
+
+  #include <algorithm>
+  #include <stdexcept>
+  #include <tuple>
+
+  #include <cstddef>
+  #include <cstring>
+
+  #include "BinaryLayout.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The fixed-size start of a patch container.  It is followed by the pixels, then (at
+ *  indexstart, a multiple of eight bytes) entries index entries, runfiles + 1 name
+ *  offsets and the names (padded to a multiple of eight bytes), all in native byte order.
+ */
+
+        struct ContainerHeader
+          {
+            char      magic[8];    /**< @brief  "APRTPCH" and the format version        */
+            char      code[8];     /**< @brief  the class code, padded with NULs        */
+            uint64_t  entries;     /**< @brief  the number of patches                   */
+            uint64_t  runfiles;    /**< @brief  the number of runfile names             */
+            uint64_t  indexstart;  /**< @brief  the offset of the index                 */
+            uint64_t  namebytes;   /**< @brief  the length of the runfile names         */
+          };
+
+        const char Magic[8] = {'A','P','R','T','P','C','H','\x01'};
+
+/**
+ *  Orders entries by where their patches came from.
+ */
+
+        bool Before(const APRT::PatchEntry& a,
+                    const APRT::PatchEntry& b)
+          {
+            return (std::tie(a.runfile,a.subsample,a.patch) < std::tie(b.runfile,b.subsample,b.patch));
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a patch container and opens it for appending.
+ *
+ *  @param [in]  path          the container path
+ *  @param [in]  label         the class of the patches
+ *  @param [in]  runfilenames  the name of each runfile id
+ */
+
+  APRT::PatchContainerWriter::PatchContainerWriter(const std::string&              path,
+                                                   const ClassId                   label,
+                                                   const std::vector<std::string>& runfilenames)
+    : path(path),
+      label(label),
+      runfilenames(runfilenames),
+      stream(path.c_str(),std::ios_base::binary | std::ios_base::trunc)
+      {
+//
+//  Reserve the header, written once the index is ...
+//
+        const ContainerHeader header = {};
+        this->stream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+        if (!this->stream)
+          {
+            throw std::runtime_error("Unable to write the patch container " + path + ".");
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Appends the patches of a subsample of a runfile.  May be called from any thread.
+ *
+ *  @param [in]  runfile  the runfile id
+ *  @param [in]  ssn      the one-based subsample number
+ *  @param [in]  patches  the patch index of each image
+ *  @param [in]  images   the patches
+ */
+
+  void APRT::PatchContainerWriter::Append(const uint32_t                 runfile,
+                                          const uint32_t                 ssn,
+                                          const std::vector<uint32_t>&   patches,
+                                          const std::vector<PatchImage>& images)
+    {
+      assert(patches.size() == images.size());
+      assert(runfile < this->runfilenames.size());
+      std::lock_guard<std::mutex> lock(this->mutex);
+      uint64_t offset = uint64_t(this->stream.tellp());
+      for (size_t image = 0; image < images.size(); ++image)
+        {
+          assert(images[image].pixels.size() == size_t(images[image].width) * images[image].height * 3);
+          this->entries.push_back(PatchEntry{offset,
+                                             images[image].width,
+                                             images[image].height,
+                                             runfile,
+                                             patches[image],
+                                             uint16_t(ssn),
+                                             this->label,
+                                             3,
+                                             0});
+          this->stream.write(reinterpret_cast<const char*>(images[image].pixels.data()),
+                             std::streamsize(images[image].pixels.size()));
+          offset += images[image].pixels.size();
+        }
+      if (!this->stream)
+        {
+          throw std::runtime_error("Unable to write the patch container " + this->path + ".");
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Sorts the entries, writes the index and runfile names after the pixels, then the
+ *  header, and closes the container.
+ */
+
+  void APRT::PatchContainerWriter::Close()
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      std::sort(this->entries.begin(),this->entries.end(),Before);
+      std::vector<uint64_t> nameoffsets;
+      const std::string     names = Concatenate(this->runfilenames,nameoffsets);
+
+      ContainerHeader header = {};
+      const std::string_view code = ClassVocabulary::Code(this->label);
+      std::memcpy(header.magic,Magic,sizeof(Magic));
+      std::memcpy(header.code,code.data(),std::min(code.size(),sizeof(header.code)));
+      header.entries    = this->entries.size();
+      header.runfiles   = this->runfilenames.size();
+      header.indexstart = Padded(uint64_t(this->stream.tellp()));
+      header.namebytes  = nameoffsets.back();
+//
+//  Write the index after the pixels, then fill in the header ...
+//
+      const std::string padding(header.indexstart - uint64_t(this->stream.tellp()),'\0');
+      this->stream.write(padding.data(),std::streamsize(padding.size()));
+      this->stream.write(reinterpret_cast<const char*>(this->entries.data()),
+                         std::streamsize(this->entries.size() * sizeof(PatchEntry)));
+      this->stream.write(reinterpret_cast<const char*>(nameoffsets.data()),
+                         std::streamsize(nameoffsets.size() * sizeof(uint64_t)));
+      this->stream.write(names.data(),std::streamsize(names.size()));
+      this->stream.seekp(0);
+      this->stream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+      this->stream.close();
+      if (!this->stream)
+        {
+          throw std::runtime_error("Unable to write the patch container " + this->path + ".");
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps a patch container.
+ *
+ *  @param [in]  path  the container path
+ */
+
+  APRT::PatchContainer::PatchContainer(const std::string& path)
+    : file(path)
+      {
+        const std::runtime_error invalid(path + " is not a patch container.");
+        ContainerHeader header;
+        if (!ReadHeader(this->file,Magic,header) ||
+            (header.runfiles > UINT32_MAX) ||
+            (header.indexstart % 8 != 0) ||
+            (header.indexstart < sizeof(header)) ||
+            (header.indexstart > this->file.Size()))
+          {
+            throw invalid;
+          }
+        const uint64_t namesstart = header.indexstart + header.entries * sizeof(PatchEntry);
+        const uint64_t textstart  = namesstart + (header.runfiles + 1) * sizeof(uint64_t);
+        if ((header.entries > (this->file.Size() - header.indexstart) / sizeof(PatchEntry)) ||
+            (this->file.Size() != textstart + Padded(header.namebytes)))
+          {
+            throw invalid;
+          }
+        this->entries     = header.entries;
+        this->runfiles    = uint32_t(header.runfiles);
+        this->code        = std::string_view(this->file.Begin() + offsetof(ContainerHeader,code),
+                                             strnlen(header.code,sizeof(header.code)));
+        this->index       = reinterpret_cast<const PatchEntry*>(this->file.Begin() + header.indexstart);
+        this->nameoffsets = reinterpret_cast<const uint64_t*>(this->file.Begin() + namesstart);
+        this->names       = this->file.Begin() + textstart;
+        if (!Ascending(this->nameoffsets,this->runfiles,header.namebytes))
+          {
+            throw invalid;
+          }
+//
+//  Check every patch lies among the pixels, so Pixels() need not ...
+//
+        for (uint64_t entry = 0; entry < this->entries; ++entry)
+          {
+            const PatchEntry& patch = this->index[entry];
+            if ((patch.runfile >= this->runfiles) ||
+                (patch.offset < sizeof(header)) ||
+                (patch.offset > header.indexstart) ||
+                (uint64_t(patch.width) * patch.height * patch.channels > header.indexstart - patch.offset))
+              {
+                throw invalid;
+              }
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Finds the entry of a patch by where it came from.
+ *
+ *  @param [in]  runfile  the runfile id
+ *  @param [in]  ssn      the one-based subsample number
+ *  @param [in]  patch    the patch index within the subsample
+ *
+ *  @return  the entry, or nullptr if the patch is not in the container
+ */
+
+  const APRT::PatchEntry* APRT::PatchContainer::Find(const uint32_t runfile,
+                                                     const uint32_t ssn,
+                                                     const uint32_t patch) const
+    {
+      PatchEntry key = {};
+      key.runfile   = runfile;
+      key.subsample = uint16_t(ssn);
+      key.patch     = patch;
+      const PatchEntry* const end   = this->index + this->entries;
+      const PatchEntry* const found = std::lower_bound(this->index,end,key,Before);
+      return (((found != end) && !Before(key,*found)) ? found : nullptr);
+    }
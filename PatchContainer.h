@@ -0,0 +1,234 @@
+/**
+ *  @file  PatchContainer.h
+ *
+ *  @brief  Definition of the PatchContainer and PatchContainerWriter classes.
+ *
+ *  Definition of the PatchContainer and PatchContainerWriter classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PATCH_CONTAINER_H_INCLUDED
+    #define APRT_PATCH_CONTAINER_H_INCLUDED
+
+    #include <fstream>
+    #include <mutex>
+    #include <string>
+    #include <string_view>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+    #include "MappedFile.h"
+    #include "ParticleSource.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  The index entry of a patch in a patch container.
+ */
+
+        struct PatchEntry
+          {
+            uint64_t  offset;     /**< @brief  the start of the pixels in the file      */
+            uint32_t  width;      /**< @brief  the width in pixels                      */
+            uint32_t  height;     /**< @brief  the height in pixels                     */
+            uint32_t  runfile;    /**< @brief  the runfile id (its name in the file)    */
+            uint32_t  patch;      /**< @brief  the patch index within the subsample     */
+            uint16_t  subsample;  /**< @brief  the one-based subsample number           */
+            ClassId   label;      /**< @brief  the user (acl) class                     */
+            uint8_t   channels;   /**< @brief  the bytes per pixel (3, RGB)             */
+            uint32_t  reserved;   /**< @brief  zero                                     */
+          };
+
+        static_assert(sizeof(PatchEntry) == 32,"a PatchEntry is stored as 32 bytes");
+
+/**
+ *  Appends patches to a patch container file.  Patches may be appended from several
+ *  threads; each Append() writes its batch contiguously.  The index is sorted and
+ *  written by Close(), so the entries are in runfile, subsample and patch index order
+ *  whatever the order of the appends; the pixels stay where they were appended.
+ */
+
+        class PatchContainerWriter
+          {
+            public:
+              PatchContainerWriter(const std::string&              path,
+                                   ClassId                         label,
+                                   const std::vector<std::string>& runfilenames);
+              PatchContainerWriter(const PatchContainerWriter&) = delete;
+              PatchContainerWriter& operator = (const PatchContainerWriter&) = delete;
+
+            public:
+              void  Append(uint32_t                       runfile,
+                           uint32_t                       ssn,
+                           const std::vector<uint32_t>&   patches,
+                           const std::vector<PatchImage>& images);
+              void  Close();
+            private:
+              std::string              path;
+                /**< @brief  the container path */
+              ClassId                  label;
+                /**< @brief  the class of the container */
+              std::vector<std::string> runfilenames;
+                /**< @brief  the name of each runfile id */
+              std::ofstream            stream;
+                /**< @brief  the container, open for writing */
+              std::vector<PatchEntry>  entries;
+                /**< @brief  the entries appended so far, in no order */
+              std::mutex               mutex;
+                /**< @brief  guards the stream and the entries */
+          };
+
+/**
+ *  A patch container: the patches of one class extracted from the runfiles of a list, in
+ *  one file instead of one file per patch.  The file is mapped, so any patch is read at
+ *  random without reading the others.
+ *
+ *  The file is, in native byte order: a header (with the class code), the pixels of the
+ *  patches as they were appended, then (at an offset recorded in the header) the index
+ *  of entries sorted by runfile, subsample and patch index, runfiles + 1 name offsets
+ *  and the runfile names.
+ */
+
+        class PatchContainer
+          {
+            public:
+              explicit PatchContainer(const std::string& path);
+
+            public:
+              uint64_t           Size() const;
+              const PatchEntry&  Entry(uint64_t entry) const;
+              const uint8_t*     Pixels(uint64_t entry) const;
+              const PatchEntry*  Find(uint32_t runfile,
+                                      uint32_t ssn,
+                                      uint32_t patch) const;
+              std::string_view   Code() const;
+              uint32_t           Runfiles() const;
+              std::string_view   Runfile(uint32_t id) const;
+            private:
+              MappedFile         file;
+                /**< @brief  the mapped container */
+              uint64_t           entries;
+                /**< @brief  the number of patches */
+              uint32_t           runfiles;
+                /**< @brief  the number of runfile names */
+              std::string_view   code;
+                /**< @brief  the class code */
+              const PatchEntry*  index;
+                /**< @brief  the entries */
+              const uint64_t*    nameoffsets;
+                /**< @brief  the start of each runfile name, plus the end */
+              const char*        names;
+                /**< @brief  the runfile names */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of patches in the container.
+ *
+ *  @return  the number of patches
+ */
+
+    inline uint64_t APRT::PatchContainer::Size() const
+      {
+        return (this->entries);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the index entry of a patch.
+ *
+ *  @param [in]  entry  the position of the patch in the index
+ *
+ *  @return  the entry
+ */
+
+    inline const APRT::PatchEntry& APRT::PatchContainer::Entry(const uint64_t entry) const
+      {
+        assert(entry < this->entries);
+        return (this->index[entry]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the pixels of a patch: width*height RGB triplets, row by row.
+ *
+ *  @param [in]  entry  the position of the patch in the index
+ *
+ *  @return  the first pixel
+ */
+
+    inline const uint8_t* APRT::PatchContainer::Pixels(const uint64_t entry) const
+      {
+        return (reinterpret_cast<const uint8_t*>(this->file.Begin() + this->Entry(entry).offset));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of the class of the container.
+ *
+ *  @return  the class code
+ */
+
+    inline std::string_view APRT::PatchContainer::Code() const
+      {
+        return (this->code);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of runfile names in the container.
+ *
+ *  @return  the number of runfiles
+ */
+
+    inline uint32_t APRT::PatchContainer::Runfiles() const
+      {
+        return (this->runfiles);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the name of a runfile of the container.
+ *
+ *  @param [in]  id  the runfile id of an entry
+ *
+ *  @return  the runfile name
+ */
+
+    inline std::string_view APRT::PatchContainer::Runfile(const uint32_t id) const
+      {
+        assert(id < this->runfiles);
+        return (std::string_view(this->names + this->nameoffsets[id],
+                                 this->nameoffsets[id + 1] - this->nameoffsets[id]));
+      }
+
+  #endif
@@ -0,0 +1,43 @@
+/**
+ *  @file  PatchCounts.h
+ *
+ *  @brief  Definition of the PatchCounts struct.
+ *
+ *  Definition of the PatchCounts struct.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PATCH_COUNTS_H_INCLUDED
+    #define APRT_PATCH_COUNTS_H_INCLUDED
+
+    #include <stdint.h>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The number of patches found in each input of a comparison.  Only the first
+ *  min(pcl,acl) patches are compared; any difference is a length mismatch.
+ */
+
+        struct PatchCounts
+          {
+            uint64_t  pcl;  /**< @brief  the patches in the apr subsample  */
+            uint64_t  acl;  /**< @brief  the patches in the user subsample */
+            bool      Mismatched() const { return (this->pcl != this->acl); }
+            PatchCounts&
+                      operator += (const PatchCounts& other)
+                        {
+                          this->pcl += other.pcl;
+                          this->acl += other.acl;
+                          return (*this);
+                        }
+          };
+      }
+
+  #endif
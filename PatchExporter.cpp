@@ -0,0 +1,534 @@
+/**
+ *  @file  PatchExporter.cpp
+ *
+ *  @brief  Implementation of the PatchExporter class.
+ *
+ *  Implementation of the PatchExporter class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "PatchExporter.h"
+
+  #include <boost/filesystem.hpp>
+
+  #include <algorithm>
+  #include <fstream>
+  #include <iostream>
+  #include <stdexcept>
+  #include <unordered_set>
+  #include <utility>
+
+  #include <cassert>
+
+  #include "ClassificationTable.h"
+  #include "ClassVocabulary.h"
+  #include "ParallelFor.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  Writes a patch as a binary (P6) PPM file.
+ */
+
+        void WritePatch(const std::string&      path,
+                        const APRT::PatchImage& image)
+          {
+            std::ofstream stream(path.c_str(),std::ios_base::binary | std::ios_base::trunc);
+            stream << "P6\n" << image.width << ' ' << image.height << "\n255\n";
+            stream.write(reinterpret_cast<const char*>(image.pixels.data()),
+                         std::streamsize(image.pixels.size()));
+            stream.close();
+            if (!stream)
+              {
+                throw std::runtime_error("Unable to write " + path + ".");
+              }
+          }
+
+/**
+ *  Creates a directory (and its parents) unless it exists.
+ */
+
+        void MakeDirectory(const boost::filesystem::path& directory)
+          {
+            boost::system::error_code error;
+            boost::filesystem::create_directories(directory,error);
+            if (!boost::filesystem::is_directory(directory))
+              {
+                throw std::runtime_error("Unable to create the patch directory " + directory.string() + ".");
+              }
+          }
+
+/**
+ *  Reads the classifications of a subsample of a runfile from a cache, or else from the
+ *  text.
+ */
+
+        APRT::ClassificationTable LoadTable(const std::string&               path,
+                                            const uint32_t                   ssn,
+                                            const APRT::ClassificationCache* cache)
+          {
+            return ((cache != nullptr) ? cache->Load(path) : APRT::ClassificationTable(path,{ssn}));
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a PatchExporter.
+ *
+ *  @param [in]  destination   the directory to make the patch directories in
+ *  @param [in]  layout        the directory each patch is written to (not None)
+ *  @param [in]  open          opens the particles of a runfile
+ *  @param [in]  jobs          the number of runfiles extracted concurrently
+ *  @param [in]  particlejobs  the number of particles of a runfile decoded concurrently
+ *  @param [in]  size          the height and width of a tensor row (Tensor only)
+ *  @param [in]  features      the name of each feature measured (Features only)
+ */
+
+  APRT::PatchExporter::PatchExporter(const std::string&              destination,
+                                     const PatchLayout               layout,
+                                     ParticleSourceFactory           open,
+                                     const uint32_t                  jobs,
+                                     const uint32_t                  particlejobs,
+                                     const uint32_t                  size,
+                                     const std::vector<std::string>& features)
+    : destination(destination),
+      layout(layout),
+      open(std::move(open)),
+      jobs(std::max(jobs,1U)),
+      particlejobs(std::max(particlejobs,1U)),
+      size(std::max(size,1U)),
+      features(features),
+      patches(0)
+        {
+          assert(layout != PatchLayout::None);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Extracts the patches of a subsample of each runfile of a list, the runfiles spread
+ *  over the runfile jobs and the particles of each over the particle jobs.  A runfile
+ *  whose particles and user classifications differ in number is reported.
+ *
+ *  @param [in]  inputdirectory  the directory holding the runfiles
+ *  @param [in]  runfilenames    the runfiles to extract
+ *  @param [in]  ssn             the one-based subsample number
+ *  @param [in]  cache           the parsed acl cache (or nullptr)
+ */
+
+  void APRT::PatchExporter::Export(const std::string&              inputdirectory,
+                                   const std::vector<std::string>& runfilenames,
+                                   const uint32_t                  ssn,
+                                   const ClassificationCache*      cache)
+    {
+//
+//  A container, tensor or store holds each runfile once, however often it is listed ...
+//
+      const bool                      single = (this->layout == PatchLayout::Packed) ||
+                                               (this->layout == PatchLayout::Tensor) ||
+                                               (this->layout == PatchLayout::Features);
+      const std::vector<std::string>& runfiles = single ? this->Identify(runfilenames) : runfilenames;
+      if (this->layout == PatchLayout::Packed)
+        {
+          this->OpenContainers();
+        }
+      else if ((this->layout == PatchLayout::Tensor) || (this->layout == PatchLayout::Features))
+        {
+          this->OpenRows(inputdirectory,ssn,cache);
+        }
+      else
+        {
+          this->MakeDirectories(runfilenames);
+        }
+      ParallelFor(0,uint32_t(runfiles.size()),this->jobs,[&](const uint32_t index)
+        {
+          const PatchCounts counts = this->ExportRunfile(inputdirectory,runfiles[index],ssn,cache);
+          std::lock_guard<std::mutex> lock(this->mutex);
+          std::cout << "Extracted -> "
+                    << runfiles[index].c_str()
+                    << " ("
+                    << counts.pcl
+                    << " patches)"
+                    << std::endl;
+          if ((this->layout != PatchLayout::ByRunfile) && counts.Mismatched())
+            {
+              std::cout << "Warning: "
+                        << runfiles[index].c_str()
+                        << " subsample "
+                        << ssn
+                        << " has "
+                        << counts.pcl
+                        << " particles and "
+                        << counts.acl
+                        << " user classifications."
+                        << std::endl;
+            }
+        });
+      for (const std::unique_ptr<PatchContainerWriter>& container : this->containers)
+        {
+          container->Close();
+        }
+      this->containers.clear();
+      if (this->tensor)
+        {
+          this->tensor->Close();
+          this->tensor.reset();
+        }
+      if (this->store)
+        {
+          this->store->Close();
+          this->store.reset();
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of patches written so far.
+ *
+ *  @return  the number of patches
+ */
+
+  uint64_t APRT::PatchExporter::Patches() const
+    {
+      return (this->patches);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates every directory a patch may be written to (one per class, or one per listed
+ *  runfile) in one pass, so the workers only write files.
+ *
+ *  @param [in]  runfilenames  the runfiles to extract
+ */
+
+  void APRT::PatchExporter::MakeDirectories(const std::vector<std::string>& runfilenames) const
+    {
+      std::unordered_set<std::string> names;
+      if (this->layout == PatchLayout::ByClass)
+        {
+          for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+            {
+              names.emplace(ClassVocabulary::Code(ClassId(id)));
+            }
+        }
+      else
+        {
+          names.insert(runfilenames.begin(),runfilenames.end());
+        }
+      for (const std::string& name : names)
+        {
+          MakeDirectory(boost::filesystem::path(this->destination) / name);
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Numbers the distinct runfiles of a list: a runfile's id in a container or tensor is
+ *  its position among them.
+ *
+ *  @param [in]  runfilenames  the runfiles to extract
+ *
+ *  @return  the distinct runfiles, in list order
+ */
+
+  const std::vector<std::string>& APRT::PatchExporter::Identify(const std::vector<std::string>& runfilenames)
+    {
+      this->runfileids.clear();
+      this->runfilenames.clear();
+      for (const std::string& runfilename : runfilenames)
+        {
+          if (this->runfileids.emplace(runfilename,uint32_t(this->runfilenames.size())).second)
+            {
+              this->runfilenames.push_back(runfilename);
+            }
+        }
+      return (this->runfilenames);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates the destination and a patch container for every class.
+ */
+
+  void APRT::PatchExporter::OpenContainers()
+    {
+      MakeDirectory(this->destination);
+      this->containers.clear();
+      for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+        {
+          const std::string code(ClassVocabulary::Code(ClassId(id)));
+          this->containers.emplace_back(new PatchContainerWriter(this->destination + "/" + code + ".patches",
+                                                                 ClassId(id),
+                                                                 this->runfilenames));
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Reads the user (and, for a tensor, apr) classifications of the subsample of every
+ *  runfile concurrently, which fixes the rows of each runfile (one per user
+ *  classification), then creates the destination and the tensor or feature store at its
+ *  full size.
+ *
+ *  @param [in]  inputdirectory  the directory holding the runfiles
+ *  @param [in]  ssn             the one-based subsample number
+ *  @param [in]  cache           the parsed acl and pcl cache (or nullptr)
+ */
+
+  void APRT::PatchExporter::OpenRows(const std::string&         inputdirectory,
+                                     const uint32_t             ssn,
+                                     const ClassificationCache* cache)
+    {
+      const uint32_t runfiles = uint32_t(this->runfilenames.size());
+      this->acltables.assign(runfiles,ClassificationTable());
+      this->pcltables.assign(runfiles,ClassificationTable());
+      ParallelFor(0,runfiles,this->jobs,[&](const uint32_t runfile)
+        {
+          const std::string path = inputdirectory + this->runfilenames[runfile];
+          this->acltables[runfile] = LoadTable(path + ".acl",ssn,cache);
+          if (this->layout == PatchLayout::Tensor)
+            {
+              this->pcltables[runfile] = LoadTable(path + ".pcl",ssn,cache);
+            }
+        });
+      this->firstrows.assign(1,0);
+      for (const ClassificationTable& acltable : this->acltables)
+        {
+          this->firstrows.push_back(this->firstrows.back() + ((ssn != 0) ? acltable.Subsample(ssn).size() : 0));
+        }
+      MakeDirectory(this->destination);
+      if (this->layout == PatchLayout::Tensor)
+        {
+          this->tensor.reset(new PatchTensorWriter(this->destination + "/Patches.tensor",
+                                                   this->size,
+                                                   this->size,
+                                                   this->runfilenames,
+                                                   this->firstrows));
+        }
+      else
+        {
+          this->store.reset(new FeatureStoreWriter(this->destination + "/Features.store",
+                                                   this->features,
+                                                   this->runfilenames,
+                                                   this->firstrows,
+                                                   ssn));
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Appends the decoded patches of a runfile to the containers of their user classes,
+ *  the patches of each class in one batch.
+ *
+ *  @param [in]      runfilename  the runfile name (one of the list)
+ *  @param [in]      ssn          the one-based subsample number
+ *  @param [in]      aclpatches   the user class of each patch
+ *  @param [in,out]  images       the patches, in patch index order (moved from)
+ */
+
+  void APRT::PatchExporter::Append(const std::string&       runfilename,
+                                   const uint32_t           ssn,
+                                   const LabelSpan&         aclpatches,
+                                   std::vector<PatchImage>& images)
+    {
+      assert(this->runfileids.count(runfilename) != 0);
+      const uint32_t runfile = this->runfileids.find(runfilename)->second;
+      std::vector<std::vector<uint32_t>>   patches(ClassVocabulary::Size);
+      std::vector<std::vector<PatchImage>> batches(ClassVocabulary::Size);
+      for (uint32_t index = 0; index < images.size(); ++index)
+        {
+          const ClassId label = (index < aclpatches.size()) ? aclpatches[index] : ClassVocabulary::None;
+          patches[label].push_back(index);
+          batches[label].push_back(std::move(images[index]));
+        }
+      for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+        {
+          if (!batches[id].empty())
+            {
+              this->containers[id]->Append(runfile,ssn,patches[id],batches[id]);
+              this->patches += batches[id].size();
+            }
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Extracts the patches of a subsample of a runfile: the runfile is opened, then its
+ *  particles are decoded, debayered and written concurrently, each to the directory of
+ *  its user class (or of the runfile).  Packed, they are all decoded before they are
+ *  appended to the containers; as a tensor (or feature store), each is fitted (or
+ *  measured) straight into its row, the particles beyond the user classifications being
+ *  left out.
+ *
+ *  @param [in]  inputdirectory  the directory holding the runfile
+ *  @param [in]  runfilename     the runfile name
+ *  @param [in]  ssn             the one-based subsample number
+ *  @param [in]  cache           the parsed acl cache (or nullptr)
+ *
+ *  @return  the number of particles (pcl) and of user classifications (acl)
+ */
+
+  APRT::PatchCounts APRT::PatchExporter::ExportRunfile(const std::string&         inputdirectory,
+                                                       const std::string&         runfilename,
+                                                       const uint32_t             ssn,
+                                                       const ClassificationCache* cache)
+    {
+      const std::unique_ptr<ParticleSource> source = this->open(inputdirectory + runfilename,ssn);
+      if (this->layout == PatchLayout::Tensor)
+        {
+          return (this->FillTensor(runfilename,ssn,*source));
+        }
+      if (this->layout == PatchLayout::Features)
+        {
+          return (this->FillFeatures(runfilename,ssn,*source));
+        }
+//
+//  Look up the user classes of the subsample, if the patches are sorted by class ...
+//
+      ClassificationTable acltable;
+      if (this->layout != PatchLayout::ByRunfile)
+        {
+          acltable = LoadTable(inputdirectory + runfilename + ".acl",ssn,cache);
+        }
+      const LabelSpan aclpatches = (ssn != 0) ? acltable.Subsample(ssn) : LabelSpan{nullptr,nullptr};
+//
+//  Decode the particles concurrently, then append them to their containers ...
+//
+      if (this->layout == PatchLayout::Packed)
+        {
+          std::vector<PatchImage> images(source->Particles());
+          ParallelFor(0,source->Particles(),this->particlejobs,[&](const uint32_t index)
+            {
+              source->Decode(index,images[index]);
+            });
+          this->Append(runfilename,ssn,aclpatches,images);
+          return (PatchCounts{source->Particles(),aclpatches.size()});
+        }
+//
+//  ... or decode and write them concurrently ...
+//
+      const std::string prefix = runfilename + "_" + std::to_string(ssn) + "_";
+      ParallelFor(0,source->Particles(),this->particlejobs,[&](const uint32_t index)
+        {
+          PatchImage image;
+          source->Decode(index,image);
+          const std::string directory = (this->layout == PatchLayout::ByRunfile) ?
+                                            runfilename :
+                                            std::string(ClassVocabulary::Code((index < aclpatches.size()) ?
+                                                                                  aclpatches[index] :
+                                                                                  ClassVocabulary::None));
+          WritePatch(this->destination + "/" + directory + "/" + prefix + std::to_string(index) + ".ppm",image);
+          ++this->patches;
+        });
+
+      return (PatchCounts{source->Particles(),aclpatches.size()});
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Fills the tensor rows of a runfile: its particles are decoded concurrently, each
+ *  fitted into its row with its user and apr classes.  The tables of the runfile are
+ *  released once it is done.
+ *
+ *  @param [in]  runfilename  the runfile name (one of the list)
+ *  @param [in]  ssn          the one-based subsample number
+ *  @param [in]  source       the particles of the runfile
+ *
+ *  @return  the number of particles (pcl) and of user classifications (acl)
+ */
+
+  APRT::PatchCounts APRT::PatchExporter::FillTensor(const std::string&    runfilename,
+                                                    const uint32_t        ssn,
+                                                    const ParticleSource& source)
+    {
+      assert(this->runfileids.count(runfilename) != 0);
+      const uint32_t  runfile    = this->runfileids.find(runfilename)->second;
+      const LabelSpan aclpatches = (ssn != 0) ? this->acltables[runfile].Subsample(ssn) : LabelSpan{nullptr,nullptr};
+      const LabelSpan pclpatches = (ssn != 0) ? this->pcltables[runfile].Subsample(ssn) : LabelSpan{nullptr,nullptr};
+      const uint32_t  rows       = std::min(source.Particles(),uint32_t(aclpatches.size()));
+      ParallelFor(0,rows,this->particlejobs,[&](const uint32_t index)
+        {
+          PatchImage image;
+          source.Decode(index,image);
+          this->tensor->Fill(this->firstrows[runfile] + index,
+                             image,
+                             aclpatches[index],
+                             (index < pclpatches.size()) ? pclpatches[index] : ClassVocabulary::None);
+          ++this->patches;
+        });
+      const PatchCounts counts{source.Particles(),aclpatches.size()};
+      this->acltables[runfile] = ClassificationTable();
+      this->pcltables[runfile] = ClassificationTable();
+      return (counts);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Fills the feature store rows of a runfile: its particles are measured concurrently,
+ *  each row getting the features of its particle and its user class.  The table of the
+ *  runfile is released once it is done.
+ *
+ *  @param [in]  runfilename  the runfile name (one of the list)
+ *  @param [in]  ssn          the one-based subsample number
+ *  @param [in]  source       the particles of the runfile
+ *
+ *  @return  the number of particles (pcl) and of user classifications (acl)
+ */
+
+  APRT::PatchCounts APRT::PatchExporter::FillFeatures(const std::string&    runfilename,
+                                                      const uint32_t        ssn,
+                                                      const ParticleSource& source)
+    {
+      assert(this->runfileids.count(runfilename) != 0);
+      const uint32_t  runfile    = this->runfileids.find(runfilename)->second;
+      const LabelSpan aclpatches = (ssn != 0) ? this->acltables[runfile].Subsample(ssn) : LabelSpan{nullptr,nullptr};
+      const uint32_t  rows       = std::min(source.Particles(),uint32_t(aclpatches.size()));
+      ParallelFor(0,rows,this->particlejobs,[&](const uint32_t index)
+        {
+          std::vector<float> values(this->features.size());
+          source.Measure(index,values.data());
+          this->store->Fill(this->firstrows[runfile] + index,values.data(),aclpatches[index]);
+          ++this->patches;
+        });
+      const PatchCounts counts{source.Particles(),aclpatches.size()};
+      this->acltables[runfile] = ClassificationTable();
+      return (counts);
+    }
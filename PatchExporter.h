@@ -0,0 +1,161 @@
+/**
+ *  @file  PatchExporter.h
+ *
+ *  @brief  Definition of the PatchExporter class.
+ *
+ *  Definition of the PatchExporter class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PATCH_EXPORTER_H_INCLUDED
+    #define APRT_PATCH_EXPORTER_H_INCLUDED
+
+    #include <atomic>
+    #include <memory>
+    #include <mutex>
+    #include <string>
+    #include <unordered_map>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "ClassificationCache.h"
+    #include "FeatureStore.h"
+    #include "ParticleSource.h"
+    #include "PatchContainer.h"
+    #include "PatchCounts.h"
+    #include "PatchTensor.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  Where extracted patches are written.
+ */
+
+        enum class PatchLayout
+          {
+            None,       /**< @brief  no patches are extracted                        */
+            ByClass,    /**< @brief  one directory per user (acl) class             */
+            ByRunfile,  /**< @brief  one directory per runfile                      */
+            Packed,     /**< @brief  one patch container per user (acl) class       */
+            Tensor,     /**< @brief  one labelled NHWC tensor of fixed-size patches */
+            Features    /**< @brief  one labelled columnar store of particle features */
+          };
+
+/**
+ *  Extracts the patches of a subsample of the runfiles of a list into a directory per
+ *  user class (or per runfile), each patch debayered and written as a binary PPM named
+ *  <runfile>_<subsample>_<patch index>.ppm.  The directories are all created in one
+ *  batch before any patch is written.  Runfiles are extracted concurrently, and so are
+ *  the particles of each runfile; a patch beyond the end of the user classifications is
+ *  written to the NONE directory.
+ *
+ *  Packed, the patches are appended instead to one patch container per user class,
+ *  <class>.patches, so millions of patches make a few dozen files.  The patches of a
+ *  runfile are decoded concurrently and then appended class by class, each class of the
+ *  runfile in one write.
+ *
+ *  As a Tensor, every patch is fitted into a size x size row of one preallocated, mapped
+ *  NHWC tensor, Patches.tensor, labelled with its user and apr classes (see PatchTensor).
+ *  The classifications are read first, to size the tensor; the patches are then written
+ *  straight into their rows.  As Features, the particles are measured instead and their
+ *  feature vectors written the same way into the rows of one feature store,
+ *  Features.store (see FeatureStore).  Packed, as a Tensor or as Features, a runfile
+ *  listed twice is extracted once.
+ */
+
+        class PatchExporter
+          {
+            public:
+              PatchExporter(const std::string&              destination,
+                            PatchLayout                     layout,
+                            ParticleSourceFactory           open,
+                            uint32_t                        jobs,
+                            uint32_t                        particlejobs,
+                            uint32_t                        size,
+                            const std::vector<std::string>& features);
+
+            public:
+              void      Export(const std::string&              inputdirectory,
+                               const std::vector<std::string>& runfilenames,
+                               uint32_t                        ssn,
+                               const ClassificationCache*      cache);
+              uint64_t  Patches() const;
+            private:
+              void      MakeDirectories(const std::vector<std::string>& runfilenames) const;
+              const std::vector<std::string>&
+                        Identify(const std::vector<std::string>& runfilenames);
+              void      OpenContainers();
+              void      OpenRows(const std::string&         inputdirectory,
+                                 uint32_t                   ssn,
+                                 const ClassificationCache* cache);
+              void      Append(const std::string&       runfilename,
+                               uint32_t                 ssn,
+                               const LabelSpan&         aclpatches,
+                               std::vector<PatchImage>& images);
+              PatchCounts
+                        ExportRunfile(const std::string&         inputdirectory,
+                                      const std::string&         runfilename,
+                                      uint32_t                   ssn,
+                                      const ClassificationCache* cache);
+              PatchCounts
+                        FillTensor(const std::string&    runfilename,
+                                   uint32_t              ssn,
+                                   const ParticleSource& source);
+              PatchCounts
+                        FillFeatures(const std::string&    runfilename,
+                                     uint32_t              ssn,
+                                     const ParticleSource& source);
+            private:
+              const std::string            destination;
+                /**< @brief  the directory the patch directories are made in */
+              const PatchLayout            layout;
+                /**< @brief  the directory each patch is written to */
+              const ParticleSourceFactory  open;
+                /**< @brief  opens the particles of a runfile */
+              const uint32_t               jobs;
+                /**< @brief  the number of runfiles extracted concurrently */
+              const uint32_t               particlejobs;
+                /**< @brief  the number of particles of a runfile decoded concurrently */
+              const uint32_t               size;
+                /**< @brief  the height and width of a tensor row */
+              const std::vector<std::string>
+                                           features;
+                /**< @brief  the name of each feature measured */
+              std::atomic<uint64_t>        patches;
+                /**< @brief  the number of patches written */
+              std::vector<std::unique_ptr<PatchContainerWriter>>
+                                           containers;
+                /**< @brief  the container of each class, if Packed */
+              std::unique_ptr<PatchTensorWriter>
+                                           tensor;
+                /**< @brief  the tensor, if a Tensor */
+              std::unique_ptr<FeatureStoreWriter>
+                                           store;
+                /**< @brief  the feature store, if Features */
+              std::vector<ClassificationTable>
+                                           acltables;
+                /**< @brief  the user classes of each runfile not yet extracted, if a Tensor or
+                             Features */
+              std::vector<ClassificationTable>
+                                           pcltables;
+                /**< @brief  the apr classes of each runfile not yet extracted, if a Tensor */
+              std::vector<uint64_t>        firstrows;
+                /**< @brief  the first tensor row of each runfile, plus the row count */
+              std::vector<std::string>     runfilenames;
+                /**< @brief  the distinct runfiles, if Packed, a Tensor or Features */
+              std::unordered_map<std::string,uint32_t>
+                                           runfileids;
+                /**< @brief  the id of each of the distinct runfiles */
+              std::mutex                   mutex;
+                /**< @brief  keeps the progress lines whole */
+          };
+      }
+
+  #endif
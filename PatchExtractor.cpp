@@ -0,0 +1,1035 @@
+/**
+ *  @file  PatchExtractor.cpp
+ *
+ *  @brief  Implementation of the PatchExtractor.
+ *
+ *  Implementation of the PatchExtractor.  The PatchExtractor is a command-line program
+ *  for extracting and correcting patches from a runfile into a desired directory. It
+ *  operates in two modes. In the first mode, the expert classification file is not used
+ *  and all the patches in each runfile are extracted to a directory created specifically
+ *  for that runfile.  The second mode uses the expert classification file.  All the
+ *  patches that belong to a particular class are extracted to a directory for that class
+ *  regardless of the runfile from which the patch originated.  In the first mode, there
+ *  is a directory for each runfile, so the labeling of patches only reflects their
+ *  positions within their source runfile.  In the second mode, all the patches of a
+ *  given class are stored together in one directory, so the labeling of the patches
+ *  reflects the runfiles from which the patches come.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "PatchExtractor.h"
+
+  #include <algorithm>
+  #include <atomic>
+  #include <condition_variable>
+  #include <deque>
+  #include <exception>
+  #include <fstream>
+  #include <iomanip>
+  #include <iostream>
+  #include <map>
+  #include <mutex>
+  #include <stdexcept>
+  #include <string_view>
+  #include <thread>
+  #include <utility>
+
+  #include "LockstepComparator.h"
+  #include "MappedFile.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates an APRT::PatchExtractor object for extracting patches contained in runfiles
+ *  listed on a runfilelist to either their respective expert classification folders or
+ *  to a single folder for each runfile on the list.
+ *
+ *  @param [in]  destination  the output destination
+ *  @param [in]  runfilelist  the subsample number
+ *  @param [in]  options      the concurrency, read-ahead, cache, vocabulary and candidate
+ *                            options
+ */
+
+  APRT::PatchExtractor::PatchExtractor(const std::string destination,
+                                       const uint8_t     sample,
+                                       const SortOptions options)
+   : outputdirectory(destination),
+     subsamplenumber(sample),
+     workers((options.jobs != 0) ? options.jobs : std::max(std::thread::hardware_concurrency(),1U)),
+     prefetch(options.prefetch),
+     allsubsamples(options.allsubsamples),
+     subsamplejobs(std::max(options.subsamplejobs,1U)),
+     candidates(options.candidates),
+     candidatejobs((options.candidatejobs != 0) ? options.candidatejobs : std::max(uint32_t(options.candidates.size()),1U)),
+     indexdisagreements(options.disagreements),
+     reportmetrics(options.metrics),
+     candidatetotal(uint32_t(options.candidates.size()))
+      {
+        if (options.open && options.allsubsamples)
+          {
+            throw std::runtime_error("Every subsample can only be compared with the built vocabulary.");
+          }
+        if (!options.candidates.empty())
+          {
+            if (options.open || options.allsubsamples)
+              {
+                throw std::runtime_error("Candidates can only be compared one subsample at a time, "
+                                         "with the built vocabulary.");
+              }
+            if (options.prefetch != 0)
+              {
+                throw std::runtime_error("The candidate files are mapped as they are compared, "
+                                         "so they cannot be read ahead.");
+              }
+          }
+        if (options.disagreements && (options.open || options.allsubsamples || !options.candidates.empty()))
+          {
+            throw std::runtime_error("The disagreement index is only kept for one subsample, with the "
+                                     "built vocabulary and without candidates.");
+          }
+        if (options.metrics && (options.open || options.allsubsamples || !options.candidates.empty()))
+          {
+            throw std::runtime_error("The metrics are only reported for one subsample, with the built "
+                                     "vocabulary and without candidates.");
+          }
+        if (options.extract != PatchLayout::None)
+          {
+            if (!options.particles)
+              {
+                throw std::runtime_error("No particle source was given, so the runfile particles "
+                                         "cannot be decoded and no patches can be extracted.");
+              }
+            if (options.open || options.allsubsamples || !options.candidates.empty() ||
+                options.disagreements || options.metrics || (options.prefetch != 0))
+              {
+                throw std::runtime_error("Patches are extracted from one subsample with the built "
+                                         "vocabulary, without the comparison options.");
+              }
+            this->exporter.reset(new PatchExporter(destination,options.extract,options.particles,
+                                                   this->workers,options.particlejobs,options.patchsize,
+                                                   options.features));
+          }
+        for (const std::string& candidate : this->candidates)
+          {
+            const bool separated = !candidate.empty() && ((candidate.back() == '/') || (candidate.back() == '\\'));
+            this->candidatedirectories.push_back(separated ? candidate : candidate + "/");
+          }
+        if (!options.cache.empty())
+          {
+            if (options.open)
+              {
+                throw std::runtime_error("The acl cache holds only the classes of the built "
+                                         "vocabulary, so it cannot be used with an open one.");
+              }
+            this->cache.reset(new ClassificationCache(options.cache));
+          }
+        if (options.open)
+          {
+            this->labels.reset(new LabelTable);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  A driver function used to iterate through a runfile list to extract all the patches
+ *  of a specific classification to a single directory for that type of patch. This form
+ *  of output is ideal for optimizing classifiers and feature generators over particular
+ *  classes/types of patches.  Unless patches are extracted, the classifications of each
+ *  runfile are compared instead and the confusion matrices written.
+ *
+ *  @param [in]  runfilelist  the input list of runfiles
+ */
+
+  void APRT::PatchExtractor::Sort(const std::string runfilelist)
+    {
+//
+//  Read the input list of runfiles ...
+//
+      std::ifstream runfileliststream(runfilelist.c_str());
+//
+//  Get the output runfile directory ...
+//
+      std::getline(runfileliststream,this->inputdirectory);
+//
+//  Get the runfilenames to process (skipping blank lines) ...
+//
+      std::vector<std::string> runfilenames;
+      std::string nextline;
+      while (std::getline(runfileliststream,nextline))
+        {
+          if (!nextline.empty())
+            {
+              runfilenames.push_back(nextline);
+            }
+        }
+//
+//  Extract the patches instead, if asked to ...
+//
+      if (this->exporter)
+        {
+          this->exporter->Export(this->inputdirectory,runfilenames,this->subsamplenumber,this->cache.get());
+          return;
+        }
+//
+//  Open the output ...
+//
+      this->results.reset(new ResultWriter(this->outputdirectory + "/ConfusionMatrix.txt"));
+      if (this->indexdisagreements)
+        {
+          this->disagreements.reset(new DisagreementRecorder(runfilenames));
+        }
+      if (this->reportmetrics)
+        {
+          this->metrics.reset(new StreamingMetrics);
+        }
+//
+//  Start reading ahead, if asked to ...
+//
+      std::unique_ptr<RunfilePrefetcher> prefetcher;
+      if (this->prefetch != 0)
+        {
+          prefetcher.reset(new RunfilePrefetcher(this->inputdirectory,runfilenames,
+                                                 this->prefetch,!this->cache));
+        }
+//
+//  Process each listed runfile in turn ...
+//
+      if (!this->candidates.empty())
+        {
+          if (this->workers > 1)
+            {
+              this->ParallelSort<CandidateMatrices>(runfilenames,prefetcher.get());
+            }
+          else
+            {
+              this->SerialSort<CandidateMatrices>(runfilenames,prefetcher.get());
+            }
+        }
+      else if (this->allsubsamples)
+        {
+          if (this->workers > 1)
+            {
+              this->ParallelSort<ConfusionTensor>(runfilenames,prefetcher.get());
+            }
+          else
+            {
+              this->SerialSort<ConfusionTensor>(runfilenames,prefetcher.get());
+            }
+        }
+      else if (this->labels)
+        {
+          if (this->workers > 1)
+            {
+              this->ParallelSort<DynamicConfusionMatrix>(runfilenames,prefetcher.get());
+            }
+          else
+            {
+              this->SerialSort<DynamicConfusionMatrix>(runfilenames,prefetcher.get());
+            }
+          this->ReportUnknown();
+        }
+      else if (this->workers > 1)
+        {
+          this->ParallelSort<ConfusionMatrix<> >(runfilenames,prefetcher.get());
+        }
+      else
+        {
+          this->SerialSort<ConfusionMatrix<> >(runfilenames,prefetcher.get());
+        }
+//
+//  Write the disagreement index and the metrics, if asked to ...
+//
+      if (this->disagreements)
+        {
+          this->disagreements->Write(this->outputdirectory + "/Disagreements.idx");
+        }
+      if (this->metrics)
+        {
+          this->metrics->Write(this->outputdirectory + "/Metrics.txt");
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the sum of the confusion matrices of all the runfiles sorted so far.
+ *
+ *  @return  the summed confusion matrix
+ */
+
+  const APRT::ConfusionMatrix<>& APRT::PatchExtractor::Total() const
+    {
+      return (this->total);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the sum of the confusion matrices of all the runfiles sorted so far with an
+ *  open vocabulary.
+ *
+ *  @return  the summed confusion matrix (indexed by LabelTable id)
+ */
+
+  const APRT::DynamicConfusionMatrix& APRT::PatchExtractor::OpenTotal() const
+    {
+      return (this->opentotal);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the sum of the confusion tensors of all the runfiles sorted so far with every
+ *  subsample compared.
+ *
+ *  @return  the summed confusion tensor
+ */
+
+  const APRT::ConfusionTensor& APRT::PatchExtractor::TensorTotal() const
+    {
+      return (this->tensortotal);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the sum of the confusion matrices of each candidate over all the runfiles
+ *  sorted so far.
+ *
+ *  @return  the summed matrix of each candidate
+ */
+
+  const APRT::CandidateMatrices& APRT::PatchExtractor::CandidateTotal() const
+    {
+      return (this->candidatetotal);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The Sort() loop, comparing one runfile at a time (as read by the prefetcher, if there
+ *  is one).
+ *
+ *  @tparam  Matrix  the confusion matrix of the vocabulary (fixed or open)
+ *
+ *  @param [in]  runfilenames  the runfiles to process
+ *  @param [in]  prefetcher    the runfile reader stage (or nullptr)
+ */
+
+  template <typename Matrix>
+    void APRT::PatchExtractor::SerialSort(const std::vector<std::string>& runfilenames,
+                                          RunfilePrefetcher* const        prefetcher)
+      {
+        if (prefetcher != nullptr)
+          {
+            PrefetchedRunfile runfile;
+            while (prefetcher->Next(runfile))
+              {
+                const std::string& runfilename = runfile.runfilename;
+                std::cout << "Processing -> "
+                          << runfilename.c_str()
+                          << std::endl;
+                PatchCounts counts;
+                Matrix      conmatrix;
+                this->CompareSort(runfile,counts,conmatrix);
+                this->ReportMismatch(runfilename,counts,conmatrix);
+                this->Accumulate(conmatrix);
+                this->Append(runfilename,conmatrix);
+                this->results->Flush();
+              }
+            return;
+          }
+        for (const std::string& runfilename : runfilenames)
+          {
+            std::cout << "Processing -> "
+                      << runfilename.c_str()
+                      << std::endl;
+            this->WriteSort<Matrix>(runfilename);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The Sort() loop spread over a pool of workers.  Each worker claims the next unclaimed
+ *  runfile, compares it and sums it into its own accumulator; the matrices are written
+ *  in runfile list order as they become available, so the output is identical to that
+ *  of the serial loop.  Matrices that complete together are written in one batch.  A
+ *  worker does not start a runfile more than one per worker ahead of the next to be
+ *  written, so a slow runfile holds back at most that many finished matrices.  The
+ *  accumulators are merged in worker order at the end.  With a prefetcher the workers
+ *  take runfiles already read into memory from it instead of claiming them by index.
+ *  If a worker fails, no further runfiles are claimed but those already claimed are
+ *  finished, and the matrices completed in list order before the failure are written
+ *  before it is rethrown.
+ *
+ *  @tparam  Matrix  the confusion matrix of the vocabulary (fixed or open)
+ *
+ *  @param [in]  runfilenames  the runfiles to process
+ *  @param [in]  prefetcher    the runfile reader stage (or nullptr)
+ */
+
+  template <typename Matrix>
+    void APRT::PatchExtractor::ParallelSort(const std::vector<std::string>& runfilenames,
+                                            RunfilePrefetcher* const        prefetcher)
+      {
+        std::vector<Matrix>               accumulators(this->workers);
+        std::map<size_t,std::pair<Matrix,PatchCounts> >
+                                          completed;
+        std::atomic<size_t>               unclaimed(0);
+        size_t                            unwritten = 0;
+        std::exception_ptr                failure;
+        std::mutex                        mutex;
+        std::condition_variable           ready;
+        std::condition_variable           room;
+//
+//  Start the workers ...
+//
+        std::vector<std::thread> pool;
+        for (uint32_t worker = 0; worker < this->workers; ++worker)
+          {
+            pool.emplace_back([&,worker]()
+              {
+                try
+                  {
+                    for (;;)
+                      {
+                        size_t            index;
+                        PrefetchedRunfile runfile;
+                        if (prefetcher != nullptr)
+                          {
+                            if (!prefetcher->Next(runfile))
+                              {
+                                break;
+                              }
+                            index = runfile.index;
+                          }
+                        else if ((index = unclaimed++) >= runfilenames.size())
+                          {
+                            break;
+                          }
+                        {
+                          std::unique_lock<std::mutex> lock(mutex);
+                          room.wait(lock,[&]() { return (failure || (index < unwritten + this->workers)); });
+                        }
+                        PatchCounts counts;
+                        Matrix      conmatrix;
+                        if (prefetcher != nullptr)
+                          {
+                            this->CompareSort(runfile,counts,conmatrix);
+                          }
+                        else
+                          {
+                            this->CompareSort(runfilenames[index],counts,conmatrix);
+                          }
+                        accumulators[worker] += conmatrix;
+                        std::lock_guard<std::mutex> lock(mutex);
+                        completed.emplace(index,std::make_pair(conmatrix,counts));
+                        ready.notify_one();
+                      }
+                  }
+                catch (...)
+                  {
+                    unclaimed = runfilenames.size();
+                    if (prefetcher != nullptr)
+                      {
+                        prefetcher->Stop();
+                      }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!failure)
+                      {
+                        failure = std::current_exception();
+                      }
+                    ready.notify_one();
+                    room.notify_all();
+                  }
+              });
+          }
+//
+//  Write the matrices in list order as they complete ...
+//
+        auto write = [&](const size_t index, const std::pair<Matrix,PatchCounts>& result, const bool batched)
+          {
+            std::cout << "Processing -> "
+                      << runfilenames[index].c_str()
+                      << std::endl;
+            this->ReportMismatch(runfilenames[index],result.second,result.first);
+            this->Append(runfilenames[index],result.first);
+            if (!batched)
+              {
+                this->results->Flush();
+              }
+          };
+        while (unwritten < runfilenames.size())
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock,[&]() { return (failure || (completed.count(unwritten) != 0)); });
+            if (completed.count(unwritten) == 0)
+              {
+                break;
+              }
+            const size_t                        index  = unwritten++;
+            const std::pair<Matrix,PatchCounts> result = completed[index];
+            completed.erase(index);
+            const bool batched = (completed.count(index + 1) != 0);
+            room.notify_all();
+            lock.unlock();
+            write(index,result,batched);
+          }
+        for (std::thread& thread : pool)
+          {
+            thread.join();
+          }
+        if (failure)
+          {
+//
+//  ... and, after a failure, those that completed in order before it ...
+//
+            for (; completed.count(unwritten) != 0; ++unwritten)
+              {
+                write(unwritten,completed[unwritten],completed.count(unwritten + 1) != 0);
+              }
+            std::rethrow_exception(failure);
+          }
+//
+//  Merge the accumulators ...
+//
+        for (const Matrix& accumulator : accumulators)
+          {
+            this->Accumulate(accumulator);
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  A worker function that writes the contents of a runfile to directories common to their
+ *  patch types. This is ideal for optimizing the features and classifiers on all the
+ *  particles of a particular class contained in a group of runfiles.
+ *
+ *  @tparam  Matrix  the confusion matrix of the vocabulary (fixed or open)
+ *
+ *  @param [in]  runfilename  the input runfile name
+ */
+
+  template <typename Matrix>
+    void APRT::PatchExtractor::WriteSort(const std::string runfilename)
+      {
+        PatchCounts counts;
+        Matrix      conmatrix;
+        this->CompareSort(runfilename,counts,conmatrix);
+        this->ReportMismatch(runfilename,counts,conmatrix);
+        this->Accumulate(conmatrix);
+        this->Append(runfilename,conmatrix);
+        this->results->Flush();
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  A worker function that compares the apr and user classifications of the particles
+ *  in a runfile subsample.  Both files are mapped and tokenized in lockstep, so no
+ *  classification list is built (with a cache, the user classifications come from the
+ *  cache instead).  With candidates, the apr file of each candidate is mapped instead
+ *  and the user classifications are interned once for all of them.  It changes no
+ *  PatchExtractor state but the (thread-safe) open vocabulary and disagreement recorder,
+ *  so runfiles may be compared concurrently.
+ *
+ *  @param [in]      runfilename  the input runfile name
+ *  @param [out]     counts       the number of patches in each file's subsample
+ *  @param [in,out]  conmatrix    the confusion matrix to add the runfile subsample to
+ */
+
+  void APRT::PatchExtractor::CompareSort(const std::string  runfilename,
+                                         PatchCounts&       counts,
+                                         ConfusionMatrix<>& conmatrix) const
+    {
+      std::vector<Disagreement>        recorded;
+      std::vector<Disagreement>* const disagreements = this->disagreements ? &recorded : nullptr;
+      const MappedFile pclfile(this->inputdirectory + runfilename + ".pcl");
+      if (this->cache)
+        {
+          counts = this->CompareCached(pclfile.Begin(),pclfile.End(),runfilename,conmatrix,disagreements);
+        }
+      else
+        {
+          const MappedFile aclfile(this->inputdirectory + runfilename + ".acl");
+          counts = LockstepComparator::Compare(pclfile.Begin(),pclfile.End(),
+                                               aclfile.Begin(),aclfile.End(),
+                                               this->subsamplenumber,
+                                               conmatrix,
+                                               disagreements);
+        }
+      if (this->disagreements)
+        {
+          this->disagreements->Add(runfilename,recorded);
+        }
+    }
+
+  void APRT::PatchExtractor::CompareSort(const std::string       runfilename,
+                                         PatchCounts&            counts,
+                                         DynamicConfusionMatrix& conmatrix) const
+    {
+      const MappedFile pclfile(this->inputdirectory + runfilename + ".pcl");
+      const MappedFile aclfile(this->inputdirectory + runfilename + ".acl");
+      counts = LockstepComparator::Compare(pclfile.Begin(),pclfile.End(),
+                                           aclfile.Begin(),aclfile.End(),
+                                           this->subsamplenumber,
+                                           *this->labels,
+                                           conmatrix);
+    }
+
+  void APRT::PatchExtractor::CompareSort(const std::string runfilename,
+                                         PatchCounts&      counts,
+                                         ConfusionTensor&  tensor) const
+    {
+      const MappedFile pclfile(this->inputdirectory + runfilename + ".pcl");
+      if (this->cache)
+        {
+          const ClassificationTable acltable = this->cache->Load(this->inputdirectory + runfilename + ".acl");
+          LockstepComparator::CompareAll(pclfile.Begin(),pclfile.End(),acltable,tensor,this->subsamplejobs);
+        }
+      else
+        {
+          const MappedFile aclfile(this->inputdirectory + runfilename + ".acl");
+          LockstepComparator::CompareAll(pclfile.Begin(),pclfile.End(),
+                                         aclfile.Begin(),aclfile.End(),
+                                         tensor,
+                                         this->subsamplejobs);
+        }
+      counts = PatchCounts{0,0};
+      for (uint32_t ssn = 1; ssn <= tensor.Subsamples(); ++ssn)
+        {
+          counts += tensor.Counts(ssn);
+        }
+    }
+
+  void APRT::PatchExtractor::CompareSort(const std::string  runfilename,
+                                         PatchCounts&       counts,
+                                         CandidateMatrices& matrices) const
+    {
+//
+//  Map the apr classifications of every candidate ...
+//
+      std::deque<MappedFile>        pclfiles;
+      std::vector<std::string_view> pcltexts;
+      for (const std::string& directory : this->candidatedirectories)
+        {
+          pclfiles.emplace_back(directory + runfilename + ".pcl");
+          pcltexts.emplace_back(pclfiles.back().Begin(),pclfiles.back().Size());
+        }
+//
+//  Intern the user classifications once, then compare every candidate against them ...
+//
+      const std::string         aclpath  = this->inputdirectory + runfilename + ".acl";
+      const ClassificationTable acltable = this->cache ?
+                                               this->cache->Load(aclpath) :
+                                               ClassificationTable(aclpath,{this->subsamplenumber});
+      const LabelSpan aclpatches = (this->subsamplenumber != 0) ?
+                                       acltable.Subsample(this->subsamplenumber) :
+                                       LabelSpan{nullptr,nullptr};
+      matrices += CandidateMatrices(uint32_t(this->candidates.size()));
+      LockstepComparator::CompareCandidates(pcltexts,aclpatches,this->subsamplenumber,
+                                            matrices,this->candidatejobs);
+      counts = PatchCounts{0,0};
+      for (uint32_t candidate = 0; candidate < matrices.Candidates(); ++candidate)
+        {
+          counts += matrices.Counts(candidate);
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Compares the apr and user classifications of a runfile subsample whose files have
+ *  already been read into memory by the RunfilePrefetcher.
+ *
+ *  @param [in]      runfile    the prefetched runfile
+ *  @param [out]     counts     the number of patches in each file's subsample
+ *  @param [in,out]  conmatrix  the confusion matrix to add the runfile subsample to
+ */
+
+  void APRT::PatchExtractor::CompareSort(const PrefetchedRunfile& runfile,
+                                         PatchCounts&             counts,
+                                         ConfusionMatrix<>&       conmatrix) const
+    {
+      std::vector<Disagreement>        recorded;
+      std::vector<Disagreement>* const disagreements = this->disagreements ? &recorded : nullptr;
+      if (this->cache)
+        {
+          counts = this->CompareCached(runfile.pcl.data(),runfile.pcl.data() + runfile.pcl.size(),
+                                       runfile.runfilename,conmatrix,disagreements);
+        }
+      else
+        {
+          counts = LockstepComparator::Compare(runfile.pcl.data(),runfile.pcl.data() + runfile.pcl.size(),
+                                               runfile.acl.data(),runfile.acl.data() + runfile.acl.size(),
+                                               this->subsamplenumber,
+                                               conmatrix,
+                                               disagreements);
+        }
+      if (this->disagreements)
+        {
+          this->disagreements->Add(runfile.runfilename,recorded);
+        }
+    }
+
+  void APRT::PatchExtractor::CompareSort(const PrefetchedRunfile& runfile,
+                                         PatchCounts&             counts,
+                                         DynamicConfusionMatrix&  conmatrix) const
+    {
+      counts = LockstepComparator::Compare(runfile.pcl.data(),runfile.pcl.data() + runfile.pcl.size(),
+                                           runfile.acl.data(),runfile.acl.data() + runfile.acl.size(),
+                                           this->subsamplenumber,
+                                           *this->labels,
+                                           conmatrix);
+    }
+
+  void APRT::PatchExtractor::CompareSort(const PrefetchedRunfile& runfile,
+                                         PatchCounts&             counts,
+                                         ConfusionTensor&         tensor) const
+    {
+      const char* const pclfirst = runfile.pcl.data();
+      const char* const pcllast  = runfile.pcl.data() + runfile.pcl.size();
+      if (this->cache)
+        {
+          const ClassificationTable acltable = this->cache->Load(this->inputdirectory + runfile.runfilename + ".acl");
+          LockstepComparator::CompareAll(pclfirst,pcllast,acltable,tensor,this->subsamplejobs);
+        }
+      else
+        {
+          LockstepComparator::CompareAll(pclfirst,pcllast,
+                                         runfile.acl.data(),runfile.acl.data() + runfile.acl.size(),
+                                         tensor,
+                                         this->subsamplejobs);
+        }
+      counts = PatchCounts{0,0};
+      for (uint32_t ssn = 1; ssn <= tensor.Subsamples(); ++ssn)
+        {
+          counts += tensor.Counts(ssn);
+        }
+    }
+
+  void APRT::PatchExtractor::CompareSort(const PrefetchedRunfile& runfile,
+                                         PatchCounts&             counts,
+                                         CandidateMatrices&       matrices) const
+    {
+//
+//  The candidate files are not read ahead, so compare the runfile by name ...
+//
+      this->CompareSort(runfile.runfilename,counts,matrices);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Compares apr classification text with the user classifications of the runfile
+ *  subsample loaded through the acl cache.
+ *
+ *  @param [in]      pclfirst       the start of the apr (pcl) text
+ *  @param [in]      pcllast        the end of the apr (pcl) text
+ *  @param [in]      runfilename    the input runfile name
+ *  @param [in,out]  conmatrix      the confusion matrix to add to
+ *  @param [in,out]  disagreements  the disagreements to append to (or nullptr)
+ *
+ *  @return  the number of patches in each file's subsample
+ */
+
+  APRT::PatchCounts APRT::PatchExtractor::CompareCached(const char* const                pclfirst,
+                                                        const char* const                pcllast,
+                                                        const std::string&               runfilename,
+                                                        ConfusionMatrix<>&               conmatrix,
+                                                        std::vector<Disagreement>* const disagreements) const
+    {
+      const ClassificationTable acltable = this->cache->Load(this->inputdirectory + runfilename + ".acl");
+      const LabelSpan aclpatches = (this->subsamplenumber != 0) ?
+                                       acltable.Subsample(this->subsamplenumber) :
+                                       LabelSpan{nullptr,nullptr};
+
+      return (LockstepComparator::Compare(pclfirst,pcllast,aclpatches,this->subsamplenumber,conmatrix,disagreements));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the confusion matrix of a runfile to the total of its vocabulary.
+ *
+ *  @param [in]  conmatrix  the runfile confusion matrix
+ */
+
+  void APRT::PatchExtractor::Accumulate(const ConfusionMatrix<>& conmatrix)
+    {
+      this->total += conmatrix;
+    }
+
+  void APRT::PatchExtractor::Accumulate(const DynamicConfusionMatrix& conmatrix)
+    {
+      this->opentotal += conmatrix;
+    }
+
+  void APRT::PatchExtractor::Accumulate(const ConfusionTensor& tensor)
+    {
+      this->tensortotal += tensor;
+    }
+
+  void APRT::PatchExtractor::Accumulate(const CandidateMatrices& matrices)
+    {
+      this->candidatetotal += matrices;
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Buffers the confusion matrix of a runfile for the results file (an open vocabulary
+ *  matrix with the codes of its classes).
+ *
+ *  @param [in]  runfilename  the input runfile name
+ *  @param [in]  conmatrix    the runfile confusion matrix
+ */
+
+  void APRT::PatchExtractor::Append(const std::string&       runfilename,
+                                    const ConfusionMatrix<>& conmatrix)
+    {
+      this->results->Append(runfilename,conmatrix);
+      if (this->metrics)
+        {
+          this->ReportMetrics(conmatrix);
+        }
+    }
+
+  void APRT::PatchExtractor::Append(const std::string&            runfilename,
+                                    const DynamicConfusionMatrix& conmatrix)
+    {
+      this->results->Append(runfilename,conmatrix,*this->labels);
+    }
+
+  void APRT::PatchExtractor::Append(const std::string&     runfilename,
+                                    const ConfusionTensor& tensor)
+    {
+      this->results->Append(runfilename,tensor);
+    }
+
+  void APRT::PatchExtractor::Append(const std::string&       runfilename,
+                                    const CandidateMatrices& matrices)
+    {
+      this->results->Append(runfilename,matrices,this->candidates);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Reports a runfile whose apr and user classification files hold different numbers of
+ *  patches for the sorted subsample, or for any subsample when every one is compared, or
+ *  for any candidate when there are candidates (only the patches common to both are
+ *  compared).
+ *
+ *  @tparam  Matrix  the confusion matrix of the vocabulary (fixed or open)
+ *
+ *  @param [in]  runfilename  the input runfile name
+ *  @param [in]  counts       the number of patches in each file's subsample
+ *  @param [in]  conmatrix    the confusion matrix of the subsample
+ */
+
+  template <typename Matrix>
+    void APRT::PatchExtractor::ReportMismatch(const std::string& runfilename,
+                                              const PatchCounts& counts,
+                                              const Matrix&      /*conmatrix*/) const
+      {
+        this->ReportMismatch(runfilename,this->subsamplenumber,counts);
+      }
+
+  void APRT::PatchExtractor::ReportMismatch(const std::string&     runfilename,
+                                            const PatchCounts&     /*counts*/,
+                                            const ConfusionTensor& tensor) const
+    {
+      for (uint32_t ssn = 1; ssn <= tensor.Subsamples(); ++ssn)
+        {
+          this->ReportMismatch(runfilename,ssn,tensor.Counts(ssn));
+        }
+    }
+
+  void APRT::PatchExtractor::ReportMismatch(const std::string&       runfilename,
+                                            const PatchCounts&       /*counts*/,
+                                            const CandidateMatrices& matrices) const
+    {
+      for (uint32_t candidate = 0; candidate < matrices.Candidates(); ++candidate)
+        {
+          this->ReportMismatch(runfilename + " (" + this->candidates[candidate] + ")",
+                               this->subsamplenumber,
+                               matrices.Counts(candidate));
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Reports a subsample whose apr and user classification files hold different numbers
+ *  of patches.
+ *
+ *  @param [in]  runfilename  the input runfile name
+ *  @param [in]  ssn          the one-based subsample number
+ *  @param [in]  counts       the number of patches in each file's subsample
+ */
+
+  void APRT::PatchExtractor::ReportMismatch(const std::string& runfilename,
+                                            const uint32_t     ssn,
+                                            const PatchCounts& counts) const
+    {
+      if (counts.Mismatched())
+        {
+          std::cout << "Warning: "
+                    << runfilename.c_str()
+                    << " subsample "
+                    << ssn
+                    << " has "
+                    << counts.pcl
+                    << " apr and "
+                    << counts.acl
+                    << " user classifications."
+                    << std::endl;
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Reports each code found in the compared patches that the ClassVocabulary does not
+ *  know (and that the fixed vocabulary would have counted as NONE), in code order, with
+ *  the number of apr and user classifications it had.
+ */
+
+  void APRT::PatchExtractor::ReportUnknown() const
+    {
+      std::vector<std::pair<std::string_view,uint32_t> > unknown;
+      for (uint32_t id = ClassVocabulary::Size; id < this->opentotal.Dim1(); ++id)
+        {
+          unknown.emplace_back(this->labels->Code(id),id);
+        }
+      std::sort(unknown.begin(),unknown.end());
+      for (const std::pair<std::string_view,uint32_t>& label : unknown)
+        {
+          int64_t pcl = 0;
+          int64_t acl = 0;
+          for (uint32_t other = 0; other < this->opentotal.Dim1(); ++other)
+            {
+              pcl += this->opentotal(label.second,other);
+              acl += this->opentotal(other,label.second);
+            }
+          std::cout << "Warning: unknown class code "
+                    << label.first
+                    << " in "
+                    << pcl
+                    << " apr and "
+                    << acl
+                    << " user classifications."
+                    << std::endl;
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the matrix of a runfile to the running metrics and reports the accuracy, macro
+ *  F1 and Cohen's kappa of the runfile and of the runfiles so far.  Runfiles are added in
+ *  list order as their matrices are written, whatever the number of workers; Metrics.txt
+ *  is written once they all are.
+ *
+ *  @param [in]  conmatrix  the runfile confusion matrix
+ */
+
+  void APRT::PatchExtractor::ReportMetrics(const ConfusionMatrix<>& conmatrix)
+    {
+      const ClassificationMetrics runfile = this->metrics->Add(conmatrix);
+      const ClassificationMetrics sofar   = this->metrics->Metrics();
+      std::cout << std::fixed << std::setprecision(4)
+                << "  runfile: accuracy "
+                << runfile.accuracy
+                << ", F1 "
+                << runfile.f1
+                << ", kappa "
+                << runfile.kappa
+                << "   all "
+                << this->metrics->Runfiles()
+                << ": accuracy "
+                << sofar.accuracy
+                << ", F1 "
+                << sofar.f1
+                << ", kappa "
+                << sofar.kappa
+                << std::defaultfloat
+                << std::endl;
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  An external function to create and run a PatchExtractor to write particles
+ *  contained in all the runfiles listed on a runfilelist into directories associated
+ *  created for their particle types. This is ideal for opitmizing a feature selector
+ *  or classifier over images of particular types/classes obtained from a collection
+ *  of runfiles in a runfilelist.
+ *
+ *  @param [in]  runfilelist  the list of runfiles to extract
+ *  @param [in]  destination  the output image directory
+ *  @param [in]  sample       the runfile sample number of interest
+ *  @param [in]  options      the concurrency, read-ahead, cache, vocabulary and candidate
+ *                            options
+ */
+
+  void APRT::Sort(const std::string runfilelist,
+                  const std::string destination,
+                  const uint8_t     sample,
+                  const SortOptions options)
+    {
+//
+//  Extract the patches contained in the runfile listed in the runfilelist
+//  into the output image directories ...
+//
+      PatchExtractor extractor = PatchExtractor(destination,sample,options);
+      extractor.Sort(runfilelist);
+//
+//  Characterize the contents of the output directories ...
+//
+      /* Skipped for now.  This would produce the "Runfile List
+         Statistics Report" file. */
+    }
@@ -0,0 +1,268 @@
+/**
+ *  @file  PatchExtractor.h
+ *
+ *  @brief  Definition of the PatchExtractor class.
+ *
+ *  Definition of the PatchExtractor class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PATCH_EXTRACTOR_H_INCLUDED
+    #define APRT_PATCH_EXTRACTOR_H_INCLUDED
+
+    #include <memory>
+    #include <string>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "CandidateMatrices.h"
+    #include "ClassificationCache.h"
+    #include "ConfusionMatrix.h"
+    #include "ConfusionTensor.h"
+    #include "DisagreementIndex.h"
+    #include "DynamicConfusionMatrix.h"
+    #include "LabelTable.h"
+    #include "LockstepComparator.h"
+    #include "ParticleSource.h"
+    #include "PatchExporter.h"
+    #include "ResultWriter.h"
+    #include "RunfilePrefetcher.h"
+    #include "StreamingMetrics.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  @brief  The options controlling how a runfile list is sorted.
+ */
+
+        struct SortOptions
+          {
+            uint32_t  jobs;      /**< @brief  the runfiles processed concurrently (0 for one
+                                              per hardware thread)                     */
+            uint32_t  prefetch;  /**< @brief  the runfiles read ahead of the comparisons (0
+                                              for none)                                */
+            std::string
+                      cache;     /**< @brief  the directory of the parsed acl cache (empty
+                                              for none)                                */
+            bool      open;      /**< @brief  whether codes the ClassVocabulary does not
+                                              know become classes of their own         */
+            bool      allsubsamples;
+                                 /**< @brief  whether every subsample is compared (into
+                                              a ConfusionTensor)                       */
+            uint32_t  subsamplejobs;
+                                 /**< @brief  the subsamples of a runfile compared
+                                              concurrently                             */
+            std::vector<std::string>
+                      candidates;
+                                 /**< @brief  the directories of the candidate apr
+                                              classifications compared against the
+                                              user ones (empty for the runfile list's)  */
+            uint32_t  candidatejobs;
+                                 /**< @brief  the candidates of a runfile compared
+                                              concurrently (0 for all of them)          */
+            bool      disagreements;
+                                 /**< @brief  whether a disagreement index is written
+                                              (Disagreements.idx)                       */
+            bool      metrics;   /**< @brief  whether the running agreement metrics are
+                                              reported (and written to Metrics.txt)    */
+            PatchLayout
+                      extract;   /**< @brief  where the patches are extracted to, instead
+                                              of being compared (None to compare)      */
+            uint32_t  particlejobs;
+                                 /**< @brief  the particles of a runfile extracted
+                                              concurrently                             */
+            uint32_t  patchsize; /**< @brief  the height and width of the patches of
+                                              an extracted tensor                      */
+            std::vector<std::string>
+                      features;  /**< @brief  the features the particles measure, in
+                                              order (empty without a particle source)  */
+            ParticleSourceFactory
+                      particles; /**< @brief  opens the particles of a runfile (empty
+                                              if none can be decoded)                  */
+            SortOptions() : jobs(1), prefetch(0), open(false), allsubsamples(false), subsamplejobs(1), candidatejobs(0),
+                            disagreements(false), metrics(false), extract(PatchLayout::None), particlejobs(1),
+                            patchsize(64) {}
+          };
+
+/**
+ *  @brief  A class for extracting patches from runfiles and storing the patches in
+ *          directories corresponding to either their runfiles or their patch
+ *          classifications.
+ */
+
+        class PatchExtractor
+          {
+            public:
+              PatchExtractor(const std::string destination,
+                             const uint8_t     sample,
+                             const SortOptions options);
+                /**< @brief  creates a PatchExtractor for a
+                             runfilelist and subsample number */
+
+            public:
+              void  Sort(const std::string runfilelist);
+                /**< @brief  a driver function used to iterate through a
+                             runfile list to extract all the patches of a specific
+                             classification to a single directory for that type of
+                             patch, ideal for optimizing classifiers and feature
+                             generators over particular classes/types of patches */
+              const ConfusionMatrix<>&  Total() const;
+                /**< @brief  the sum of the matrices of all the sorted runfiles */
+              const DynamicConfusionMatrix&  OpenTotal() const;
+                /**< @brief  the sum of the matrices of all the sorted runfiles,
+                             over the open vocabulary */
+              const ConfusionTensor&  TensorTotal() const;
+                /**< @brief  the sum of the tensors of all the sorted runfiles,
+                             when every subsample is compared */
+              const CandidateMatrices&  CandidateTotal() const;
+                /**< @brief  the sum of the matrices of each candidate over all
+                             the sorted runfiles */
+
+            private:
+              template <typename Matrix>
+                void  SerialSort(const std::vector<std::string>& runfilenames,
+                                 RunfilePrefetcher*              prefetcher);
+                /**< @brief  the Sort() loop, one runfile at a time */
+              template <typename Matrix>
+                void  ParallelSort(const std::vector<std::string>& runfilenames,
+                                   RunfilePrefetcher*              prefetcher);
+                /**< @brief  the Sort() loop spread over a pool of workers */
+              template <typename Matrix>
+                void  WriteSort(const std::string runfilename);
+                /**< @brief  a worker function that writes the contents of a
+                             runfile to directories created for their patch types */
+              void  CompareSort(const std::string  runfilename,
+                                PatchCounts&       counts,
+                                ConfusionMatrix<>& conmatrix) const;
+              void  CompareSort(const std::string       runfilename,
+                                PatchCounts&            counts,
+                                DynamicConfusionMatrix& conmatrix) const;
+              void  CompareSort(const std::string runfilename,
+                                PatchCounts&      counts,
+                                ConfusionTensor&  tensor) const;
+              void  CompareSort(const std::string  runfilename,
+                                PatchCounts&       counts,
+                                CandidateMatrices& matrices) const;
+                /**< @brief  a worker function that compares the classifications
+                             of a runfile subsample */
+              void  CompareSort(const PrefetchedRunfile& runfile,
+                                PatchCounts&             counts,
+                                ConfusionMatrix<>&       conmatrix) const;
+              void  CompareSort(const PrefetchedRunfile& runfile,
+                                PatchCounts&             counts,
+                                DynamicConfusionMatrix&  conmatrix) const;
+              void  CompareSort(const PrefetchedRunfile& runfile,
+                                PatchCounts&             counts,
+                                ConfusionTensor&         tensor) const;
+              void  CompareSort(const PrefetchedRunfile& runfile,
+                                PatchCounts&             counts,
+                                CandidateMatrices&       matrices) const;
+                /**< @brief  compares the classifications of a prefetched runfile
+                             subsample */
+              PatchCounts  CompareCached(const char*                pclfirst,
+                                         const char*                pcllast,
+                                         const std::string&         runfilename,
+                                         ConfusionMatrix<>&         conmatrix,
+                                         std::vector<Disagreement>* disagreements) const;
+                /**< @brief  compares apr text with the cached user classifications */
+              void  Accumulate(const ConfusionMatrix<>&      conmatrix);
+              void  Accumulate(const DynamicConfusionMatrix& conmatrix);
+              void  Accumulate(const ConfusionTensor&        tensor);
+              void  Accumulate(const CandidateMatrices&      matrices);
+                /**< @brief  adds a runfile matrix to the total */
+              void  Append(const std::string&       runfilename,
+                           const ConfusionMatrix<>& conmatrix);
+              void  Append(const std::string&            runfilename,
+                           const DynamicConfusionMatrix& conmatrix);
+              void  Append(const std::string&     runfilename,
+                           const ConfusionTensor& tensor);
+              void  Append(const std::string&       runfilename,
+                           const CandidateMatrices& matrices);
+                /**< @brief  buffers a runfile matrix for the results file */
+              template <typename Matrix>
+                void  ReportMismatch(const std::string& runfilename,
+                                     const PatchCounts& counts,
+                                     const Matrix&      conmatrix) const;
+              void  ReportMismatch(const std::string&     runfilename,
+                                   const PatchCounts&     counts,
+                                   const ConfusionTensor& tensor) const;
+              void  ReportMismatch(const std::string&       runfilename,
+                                   const PatchCounts&       counts,
+                                   const CandidateMatrices& matrices) const;
+              void  ReportMismatch(const std::string& runfilename,
+                                   uint32_t           ssn,
+                                   const PatchCounts& counts) const;
+                /**< @brief  warns of apr and user subsamples of different lengths */
+              void  ReportUnknown() const;
+                /**< @brief  warns of the codes the ClassVocabulary does not know */
+              void  ReportMetrics(const ConfusionMatrix<>& conmatrix);
+                /**< @brief  adds a runfile matrix to the running metrics and reports
+                             them */
+
+            private:
+              std::string  outputdirectory;
+                /**< @brief  the output directory containing images */
+              std::string  inputdirectory;
+                /**< @brief  the input directory containing runfiles */
+              const uint8_t subsamplenumber;
+                /**< @brief  the runfile subsample (stream) to write */
+              const uint32_t workers;
+                /**< @brief  the number of runfiles processed concurrently */
+              const uint32_t prefetch;
+                /**< @brief  the number of runfiles read ahead (0 for none) */
+              const bool allsubsamples;
+                /**< @brief  whether every subsample is compared */
+              const uint32_t subsamplejobs;
+                /**< @brief  the number of subsamples of a runfile compared concurrently */
+              const std::vector<std::string> candidates;
+                /**< @brief  the name of each candidate (its directory, as given) */
+              std::vector<std::string> candidatedirectories;
+                /**< @brief  the directory of each candidate, ending in a separator */
+              const uint32_t candidatejobs;
+                /**< @brief  the number of candidates of a runfile compared concurrently */
+              const bool indexdisagreements;
+                /**< @brief  whether a disagreement index is written */
+              const bool reportmetrics;
+                /**< @brief  whether the running metrics are reported */
+              std::unique_ptr<ClassificationCache> cache;
+                /**< @brief  the parsed acl cache (or none) */
+              ConfusionMatrix<> total;
+                /**< @brief  the sum of the runfile confusion matrices */
+              std::unique_ptr<LabelTable> labels;
+                /**< @brief  the open vocabulary (or none, for the fixed one) */
+              DynamicConfusionMatrix opentotal;
+                /**< @brief  the sum of the runfile matrices over the open vocabulary */
+              ConfusionTensor tensortotal;
+                /**< @brief  the sum of the runfile tensors */
+              CandidateMatrices candidatetotal;
+                /**< @brief  the sum of the runfile matrices of each candidate */
+              std::unique_ptr<DisagreementRecorder> disagreements;
+                /**< @brief  the disagreements of the sorted runfiles (or none) */
+              std::unique_ptr<StreamingMetrics> metrics;
+                /**< @brief  the running metrics of the sorted runfiles (or none) */
+              std::unique_ptr<PatchExporter> exporter;
+                /**< @brief  the patch extraction (or none, to compare) */
+              std::unique_ptr<ResultWriter> results;
+                /**< @brief  the ConfusionMatrix.txt output */
+          };
+
+/**
+ *  @brief  An external function to create and run a PatchExtractor to write particles
+ *          contained in all the runfiles listed on a runfilelist into directories
+ *          associated created for their particle types.
+ */
+
+        void Sort(const std::string runfilelist,
+                  const std::string destination,
+                  const uint8_t     sample,
+                  const SortOptions options);
+      }
+
+  #endif
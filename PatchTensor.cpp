@@ -0,0 +1,287 @@
+/**
+ *  @file  PatchTensor.cpp
+ *
+ *  @brief  Implementation of the PatchTensor and PatchTensorWriter classes.
+ *
+ *  Implementation of the PatchTensor and PatchTensorWriter classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "PatchTensor.h"
+
+  #include <algorithm>
+  #include <stdexcept>
+
+  #include <cstring>
+
+  #include "BinaryLayout.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace
+      {
+
+/**
+ *  The fixed-size start of a patch tensor (see PatchTensor for what follows it).
+ */
+
+        struct TensorHeader
+          {
+            char      magic[8];   /**< @brief  "APRTTEN" and the format version  */
+            uint64_t  rows;       /**< @brief  the number of rows                */
+            uint64_t  height;     /**< @brief  the height of a row               */
+            uint64_t  width;      /**< @brief  the width of a row                */
+            uint64_t  channels;   /**< @brief  the bytes per pixel (3, RGB)      */
+            uint64_t  classes;    /**< @brief  the number of class codes         */
+            uint64_t  runfiles;   /**< @brief  the number of runfile names       */
+            uint64_t  codebytes;  /**< @brief  the length of the class codes     */
+            uint64_t  namebytes;  /**< @brief  the length of the runfile names   */
+          };
+
+        static_assert(sizeof(TensorHeader) == 72,"the pixels of a patch tensor start at byte 72");
+
+        const char Magic[8] = {'A','P','R','T','T','E','N','\x01'};
+
+/**
+ *  Where each part of a patch tensor starts, given its header.
+ */
+
+        struct TensorLayout
+          {
+            uint64_t  pixels;
+            uint64_t  acllabels;
+            uint64_t  pcllabels;
+            uint64_t  firstrows;
+            uint64_t  codeoffsets;
+            uint64_t  nameoffsets;
+            uint64_t  codes;
+            uint64_t  names;
+            uint64_t  size;
+
+            explicit TensorLayout(const TensorHeader& header)
+              : pixels(sizeof(header)),
+                acllabels(pixels + APRT::Padded(header.rows * header.height * header.width * header.channels)),
+                pcllabels(acllabels + APRT::Padded(header.rows)),
+                firstrows(pcllabels + APRT::Padded(header.rows)),
+                codeoffsets(firstrows + (header.runfiles + 1) * sizeof(uint64_t)),
+                nameoffsets(codeoffsets + (header.classes + 1) * sizeof(uint64_t)),
+                codes(nameoffsets + (header.runfiles + 1) * sizeof(uint64_t)),
+                names(codes + APRT::Padded(header.codebytes)),
+                size(names + APRT::Padded(header.namebytes)) {}
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a patch tensor, with every row black and labelled NONE, and maps it for
+ *  writing.
+ *
+ *  @param [in]  path          the tensor path
+ *  @param [in]  height        the height of a row
+ *  @param [in]  width         the width of a row
+ *  @param [in]  runfilenames  the name of each runfile id
+ *  @param [in]  firstrows     the first row of each runfile, plus the row count
+ */
+
+  APRT::PatchTensorWriter::PatchTensorWriter(const std::string&              path,
+                                             const uint32_t                  height,
+                                             const uint32_t                  width,
+                                             const std::vector<std::string>& runfilenames,
+                                             const std::vector<uint64_t>&    firstrows)
+    : path(path),
+      rows(firstrows.back()),
+      height(height),
+      width(width)
+      {
+        assert(firstrows.size() == runfilenames.size() + 1);
+        std::vector<std::string_view> codes;
+        for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+          {
+            codes.push_back(ClassVocabulary::Code(ClassId(id)));
+          }
+        std::vector<uint64_t> codeoffsets;
+        std::vector<uint64_t> nameoffsets;
+        const std::string codetext = Concatenate(codes,codeoffsets);
+        const std::string nametext = Concatenate(runfilenames,nameoffsets);
+
+        TensorHeader header;
+        std::memcpy(header.magic,Magic,sizeof(Magic));
+        header.rows      = this->rows;
+        header.height    = height;
+        header.width     = width;
+        header.channels  = 3;
+        header.classes   = ClassVocabulary::Size;
+        header.runfiles  = runfilenames.size();
+        header.codebytes = codeoffsets.back();
+        header.namebytes = nameoffsets.back();
+        const TensorLayout layout(header);
+//
+//  Create the file at its full size (the pixels start black) and map it ...
+//
+        boost::iostreams::mapped_file_params params(path);
+        params.new_file_size = int64_t(layout.size);
+        try
+          {
+            this->file.open(params);
+          }
+        catch (const std::exception&)
+          {
+            throw std::runtime_error("Unable to write the patch tensor " + path + ".");
+          }
+        char* const begin = this->file.data();
+        this->pixels    = reinterpret_cast<uint8_t*>(begin + layout.pixels);
+        this->acllabels = reinterpret_cast<ClassId*>(begin + layout.acllabels);
+        this->pcllabels = reinterpret_cast<ClassId*>(begin + layout.pcllabels);
+//
+//  ... and write everything but the pixels and the labels of the patches ...
+//
+        std::memcpy(begin,&header,sizeof(header));
+        std::fill(this->acllabels,this->acllabels + this->rows,ClassVocabulary::None);
+        std::fill(this->pcllabels,this->pcllabels + this->rows,ClassVocabulary::None);
+        std::memcpy(begin + layout.firstrows,firstrows.data(),firstrows.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.codeoffsets,codeoffsets.data(),codeoffsets.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.nameoffsets,nameoffsets.data(),nameoffsets.size() * sizeof(uint64_t));
+        std::memcpy(begin + layout.codes,codetext.data(),codetext.size());
+        std::memcpy(begin + layout.names,nametext.data(),nametext.size());
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Fills a row with a patch and its labels.  The patch is scaled down by the nearest
+ *  pixel if it does not fit, then centred.  May be called from any thread, for distinct
+ *  rows.
+ *
+ *  @param [in]  row    the row
+ *  @param [in]  image  the patch
+ *  @param [in]  acl    the user class of the patch
+ *  @param [in]  pcl    the apr class of the patch
+ */
+
+  void APRT::PatchTensorWriter::Fill(const uint64_t    row,
+                                     const PatchImage& image,
+                                     const ClassId     acl,
+                                     const ClassId     pcl)
+    {
+      assert(row < this->rows);
+      assert(image.pixels.size() == size_t(image.width) * image.height * 3);
+      this->acllabels[row] = acl;
+      this->pcllabels[row] = pcl;
+      if ((image.width == 0) || (image.height == 0))
+        {
+          return;
+        }
+//
+//  Scale by the larger of the two ratios, so the whole patch fits ...
+//
+      uint32_t width  = image.width;
+      uint32_t height = image.height;
+      if ((width > this->width) || (height > this->height))
+        {
+          if (uint64_t(width) * this->height >= uint64_t(height) * this->width)
+            {
+              height = std::max(1U,uint32_t(uint64_t(height) * this->width / width));
+              width  = this->width;
+            }
+          else
+            {
+              width  = std::max(1U,uint32_t(uint64_t(width) * this->height / height));
+              height = this->height;
+            }
+        }
+      const uint32_t left   = (this->width  - width)  / 2;
+      const uint32_t top    = (this->height - height) / 2;
+      uint8_t* const target = this->pixels + row * this->height * this->width * 3;
+      for (uint32_t y = 0; y < height; ++y)
+        {
+          const uint32_t sourcey = uint32_t((2 * uint64_t(y) + 1) * image.height / (2 * uint64_t(height)));
+          uint8_t*       pixel   = target + ((size_t(top) + y) * this->width + left) * 3;
+          for (uint32_t x = 0; x < width; ++x, pixel += 3)
+            {
+              const uint32_t sourcex = uint32_t((2 * uint64_t(x) + 1) * image.width / (2 * uint64_t(width)));
+              std::memcpy(pixel,&image.pixels[(size_t(sourcey) * image.width + sourcex) * 3],3);
+            }
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Unmaps the tensor, flushing it to the file.
+ */
+
+  void APRT::PatchTensorWriter::Close()
+    {
+      try
+        {
+          this->file.close();
+        }
+      catch (const std::exception&)
+        {
+          throw std::runtime_error("Unable to write the patch tensor " + this->path + ".");
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Maps a patch tensor.
+ *
+ *  @param [in]  path  the tensor path
+ */
+
+  APRT::PatchTensor::PatchTensor(const std::string& path)
+    : file(path)
+      {
+        const std::runtime_error invalid(path + " is not a patch tensor.");
+        TensorHeader header;
+        if (!ReadHeader(this->file,Magic,header) ||
+            (header.channels != 3) ||
+            (header.height   > UINT32_MAX) ||
+            (header.width    > UINT32_MAX) ||
+            (header.classes  > UINT32_MAX) ||
+            (header.runfiles > UINT32_MAX) ||
+            (header.rows     > this->file.Size()) ||
+            ((header.height * header.width != 0) &&
+             (header.rows * 3 > this->file.Size() / (header.height * header.width))))
+          {
+            throw invalid;
+          }
+        const TensorLayout layout(header);
+        if (this->file.Size() != layout.size)
+          {
+            throw invalid;
+          }
+        const char* const begin = this->file.Begin();
+        this->rows        = header.rows;
+        this->height      = uint32_t(header.height);
+        this->width       = uint32_t(header.width);
+        this->classes     = uint32_t(header.classes);
+        this->runfiles    = uint32_t(header.runfiles);
+        this->pixels      = reinterpret_cast<const uint8_t*>(begin + layout.pixels);
+        this->acllabels   = reinterpret_cast<const ClassId*>(begin + layout.acllabels);
+        this->pcllabels   = reinterpret_cast<const ClassId*>(begin + layout.pcllabels);
+        this->firstrows   = reinterpret_cast<const uint64_t*>(begin + layout.firstrows);
+        this->codeoffsets = reinterpret_cast<const uint64_t*>(begin + layout.codeoffsets);
+        this->nameoffsets = reinterpret_cast<const uint64_t*>(begin + layout.nameoffsets);
+        this->codes       = begin + layout.codes;
+        this->names       = begin + layout.names;
+        if (!Ascending(this->firstrows,this->runfiles,header.rows)        ||
+            !Ascending(this->codeoffsets,this->classes,header.codebytes) ||
+            !Ascending(this->nameoffsets,this->runfiles,header.namebytes))
+          {
+            throw invalid;
+          }
+      }
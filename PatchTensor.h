@@ -0,0 +1,327 @@
+/**
+ *  @file  PatchTensor.h
+ *
+ *  @brief  Definition of the PatchTensor and PatchTensorWriter classes.
+ *
+ *  Definition of the PatchTensor and PatchTensorWriter classes.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_PATCH_TENSOR_H_INCLUDED
+    #define APRT_PATCH_TENSOR_H_INCLUDED
+
+    #include <boost/iostreams/device/mapped_file.hpp>
+
+    #include <string>
+    #include <string_view>
+    #include <vector>
+
+    #include <cassert>
+
+    #include <stdint.h>
+
+    #include "ClassVocabulary.h"
+    #include "MappedFile.h"
+    #include "ParticleSource.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  Creates a patch tensor file of a known number of rows and maps it for writing.  Each
+ *  row is filled (its pixels fitted in place and its labels set) by whichever thread
+ *  extracts its patch; rows are independent, so distinct rows may be filled at once.  A
+ *  row never filled is black and labelled NONE.
+ */
+
+        class PatchTensorWriter
+          {
+            public:
+              PatchTensorWriter(const std::string&              path,
+                                uint32_t                        height,
+                                uint32_t                        width,
+                                const std::vector<std::string>& runfilenames,
+                                const std::vector<uint64_t>&    firstrows);
+              PatchTensorWriter(const PatchTensorWriter&) = delete;
+              PatchTensorWriter& operator = (const PatchTensorWriter&) = delete;
+
+            public:
+              void  Fill(uint64_t          row,
+                         const PatchImage& image,
+                         ClassId           acl,
+                         ClassId           pcl);
+              void  Close();
+            private:
+              std::string                        path;
+                /**< @brief  the tensor path */
+              boost::iostreams::mapped_file_sink file;
+                /**< @brief  the mapping of the tensor */
+              uint64_t                           rows;
+                /**< @brief  the number of rows */
+              uint32_t                           height;
+                /**< @brief  the height of a row */
+              uint32_t                           width;
+                /**< @brief  the width of a row */
+              uint8_t*                           pixels;
+                /**< @brief  the first row */
+              ClassId*                           acllabels;
+                /**< @brief  the user class of each row */
+              ClassId*                           pcllabels;
+                /**< @brief  the apr class of each row */
+          };
+
+/**
+ *  A patch tensor: the patches of a subsample of the runfiles of a list as one dense
+ *  rows x height x width x 3 (NHWC) uint8 RGB array, with the user (acl) and apr (pcl)
+ *  class id of each row, ready to be mapped by a training job.  Each runfile has a row
+ *  per user classification, in patch index order, from its first row.  A patch larger
+ *  than a row is scaled down (keeping its aspect) to fit; each patch is centred on a
+ *  black row.
+ *
+ *  The file is, in native byte order: a header, the pixels (at byte 72), the acl class
+ *  of each row, the pcl class of each row, runfiles + 1 first rows, classes + 1 code
+ *  offsets, runfiles + 1 name offsets, the class codes and the runfile names, each part
+ *  after the pixels padded to a multiple of eight bytes.
+ */
+
+        class PatchTensor
+          {
+            public:
+              explicit PatchTensor(const std::string& path);
+
+            public:
+              uint64_t          Rows() const;
+              uint32_t          Height() const;
+              uint32_t          Width() const;
+              const uint8_t*    Pixels(uint64_t row) const;
+              ClassId           Acl(uint64_t row) const;
+              ClassId           Pcl(uint64_t row) const;
+              uint32_t          Classes() const;
+              std::string_view  Code(uint32_t id) const;
+              uint32_t          Runfiles() const;
+              std::string_view  Runfile(uint32_t id) const;
+              uint64_t          FirstRow(uint32_t id) const;
+            private:
+              MappedFile        file;
+                /**< @brief  the mapped tensor */
+              uint64_t          rows;
+                /**< @brief  the number of rows */
+              uint32_t          height;
+                /**< @brief  the height of a row */
+              uint32_t          width;
+                /**< @brief  the width of a row */
+              uint32_t          classes;
+                /**< @brief  the number of class codes */
+              uint32_t          runfiles;
+                /**< @brief  the number of runfile names */
+              const uint8_t*    pixels;
+                /**< @brief  the first row */
+              const ClassId*    acllabels;
+                /**< @brief  the user class of each row */
+              const ClassId*    pcllabels;
+                /**< @brief  the apr class of each row */
+              const uint64_t*   firstrows;
+                /**< @brief  the first row of each runfile, plus the row count */
+              const uint64_t*   codeoffsets;
+                /**< @brief  the start of each class code, plus the end */
+              const uint64_t*   nameoffsets;
+                /**< @brief  the start of each runfile name, plus the end */
+              const char*       codes;
+                /**< @brief  the class codes */
+              const char*       names;
+                /**< @brief  the runfile names */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of rows (patches) of the tensor.
+ *
+ *  @return  the number of rows
+ */
+
+    inline uint64_t APRT::PatchTensor::Rows() const
+      {
+        return (this->rows);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the height of a row in pixels.
+ *
+ *  @return  the height
+ */
+
+    inline uint32_t APRT::PatchTensor::Height() const
+      {
+        return (this->height);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the width of a row in pixels.
+ *
+ *  @return  the width
+ */
+
+    inline uint32_t APRT::PatchTensor::Width() const
+      {
+        return (this->width);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the pixels of a row: height*width RGB triplets, row by row.
+ *
+ *  @param [in]  row  the row
+ *
+ *  @return  the first pixel
+ */
+
+    inline const uint8_t* APRT::PatchTensor::Pixels(const uint64_t row) const
+      {
+        assert(row < this->rows);
+        return (this->pixels + row * this->height * this->width * 3);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the user class of a row.
+ *
+ *  @param [in]  row  the row
+ *
+ *  @return  the acl class id (a position in the tensor's codes)
+ */
+
+    inline APRT::ClassId APRT::PatchTensor::Acl(const uint64_t row) const
+      {
+        assert(row < this->rows);
+        return (this->acllabels[row]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the apr class of a row.
+ *
+ *  @param [in]  row  the row
+ *
+ *  @return  the pcl class id (a position in the tensor's codes)
+ */
+
+    inline APRT::ClassId APRT::PatchTensor::Pcl(const uint64_t row) const
+      {
+        assert(row < this->rows);
+        return (this->pcllabels[row]);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of classes the labels index.
+ *
+ *  @return  the number of class codes
+ */
+
+    inline uint32_t APRT::PatchTensor::Classes() const
+      {
+        return (this->classes);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of a class of the tensor.
+ *
+ *  @param [in]  id  the class id
+ *
+ *  @return  the class code
+ */
+
+    inline std::string_view APRT::PatchTensor::Code(const uint32_t id) const
+      {
+        assert(id < this->classes);
+        return (std::string_view(this->codes + this->codeoffsets[id],
+                                 this->codeoffsets[id + 1] - this->codeoffsets[id]));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of runfiles of the tensor.
+ *
+ *  @return  the number of runfiles
+ */
+
+    inline uint32_t APRT::PatchTensor::Runfiles() const
+      {
+        return (this->runfiles);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the name of a runfile of the tensor.
+ *
+ *  @param [in]  id  the runfile id
+ *
+ *  @return  the runfile name
+ */
+
+    inline std::string_view APRT::PatchTensor::Runfile(const uint32_t id) const
+      {
+        assert(id < this->runfiles);
+        return (std::string_view(this->names + this->nameoffsets[id],
+                                 this->nameoffsets[id + 1] - this->nameoffsets[id]));
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the first row of a runfile; its patch index i is the row FirstRow(id) + i, up
+ *  to FirstRow(id + 1).
+ *
+ *  @param [in]  id  the runfile id (or the number of runfiles, for the row count)
+ *
+ *  @return  the first row
+ */
+
+    inline uint64_t APRT::PatchTensor::FirstRow(const uint32_t id) const
+      {
+        assert(id <= this->runfiles);
+        return (this->firstrows[id]);
+      }
+
+  #endif
@@ -0,0 +1,310 @@
+/**
+ *  @file  ResultWriter.cpp
+ *
+ *  @brief  Implementation of the ResultWriter class.
+ *
+ *  Implementation of the ResultWriter class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "ResultWriter.h"
+
+  #include <algorithm>
+  #include <charconv>
+  #include <stdexcept>
+  #include <utility>
+  #include <vector>
+
+  #include <cassert>
+  #include <cerrno>
+
+  #include <fcntl.h>
+  #include <sys/stat.h>
+
+  #ifdef _WIN32
+    #include <io.h>
+  #else
+    #include <unistd.h>
+  #endif
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Opens a results file for appending, creating it if necessary.
+ *
+ *  @param [in]  path  the results file path
+ */
+
+  APRT::ResultWriter::ResultWriter(const std::string& path)
+    : path(path)
+      {
+        #ifdef _WIN32
+          this->descriptor = ::_open(path.c_str(),
+                                     _O_WRONLY | _O_APPEND | _O_CREAT | _O_TEXT,
+                                     _S_IREAD | _S_IWRITE);
+        #else
+          this->descriptor = ::open(path.c_str(),
+                                    O_WRONLY | O_APPEND | O_CREAT,
+                                    0666);
+        #endif
+        if (this->descriptor < 0)
+          {
+            throw std::runtime_error("Unable to open " + path + " for writing.");
+          }
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes any buffered matrices and closes the results file.
+ */
+
+  APRT::ResultWriter::~ResultWriter()
+    {
+      try
+        {
+          this->Flush();
+        }
+      catch (...)
+        {
+          ;
+        }
+      #ifdef _WIN32
+        ::_close(this->descriptor);
+      #else
+        ::close(this->descriptor);
+      #endif
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Appends a labeled matrix to the results file with a single write.
+ *
+ *  @param [in]  label   the matrix label (the runfile name)
+ *  @param [in]  matrix  the confusion matrix
+ */
+
+  void APRT::ResultWriter::Write(const std::string_view   label,
+                                 const ConfusionMatrix<>& matrix)
+    {
+      this->Append(label,matrix);
+      this->Flush();
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Formats a labeled matrix into the buffer.  The label is on a line of its own, followed
+ *  by one line per row with each count followed by a tab.
+ *
+ *  @param [in]  label   the matrix label (the runfile name)
+ *  @param [in]  matrix  the confusion matrix
+ */
+
+  void APRT::ResultWriter::Append(const std::string_view   label,
+                                  const ConfusionMatrix<>& matrix)
+    {
+      this->buffer.append(label);
+      this->buffer.push_back('\n');
+      for (uint32_t i = 0; i < matrix.Dim1(); ++i)
+        {
+          for (uint32_t j = 0; j < matrix.Dim2(); ++j)
+            {
+              this->AppendCount(matrix(i,j));
+            }
+          this->buffer.push_back('\n');
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Formats a labeled matrix over an open vocabulary into the buffer.  The rows and
+ *  columns are the classes of the ClassVocabulary followed by the discovered classes
+ *  that have counts, in code order, so the output does not depend on the order in
+ *  which the classes were discovered.  Without discovered classes the format is that of
+ *  a fixed vocabulary matrix; with them, the label line is followed by a line of the
+ *  codes of the rows and columns, each followed by a tab.
+ *
+ *  @param [in]  label   the matrix label (the runfile name)
+ *  @param [in]  matrix  the confusion matrix
+ *  @param [in]  labels  the vocabulary of the matrix
+ */
+
+  void APRT::ResultWriter::Append(const std::string_view        label,
+                                  const DynamicConfusionMatrix& matrix,
+                                  const LabelTable&             labels)
+    {
+//
+//  Choose the classes to write ...
+//
+      std::vector<std::pair<std::string_view,uint32_t> > discovered;
+      for (uint32_t id = ClassVocabulary::Size; id < matrix.Dim1(); ++id)
+        {
+          for (uint32_t other = 0; other < matrix.Dim1(); ++other)
+            {
+              if ((matrix(id,other) != 0) || (matrix(other,id) != 0))
+                {
+                  discovered.emplace_back(labels.Code(id),id);
+                  break;
+                }
+            }
+        }
+      std::sort(discovered.begin(),discovered.end());
+      std::vector<uint32_t> classes;
+      for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+        {
+          classes.push_back(id);
+        }
+      for (const std::pair<std::string_view,uint32_t>& code : discovered)
+        {
+          classes.push_back(code.second);
+        }
+//
+//  Write them ...
+//
+      this->buffer.append(label);
+      this->buffer.push_back('\n');
+      if (!discovered.empty())
+        {
+          for (const uint32_t id : classes)
+            {
+              this->buffer.append(labels.Code(id));
+              this->buffer.push_back('\t');
+            }
+          this->buffer.push_back('\n');
+        }
+      for (const uint32_t i : classes)
+        {
+          for (const uint32_t j : classes)
+            {
+              this->AppendCount(matrix(i,j));
+            }
+          this->buffer.push_back('\n');
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Formats the matrices of a labeled tensor into the buffer, subsample by subsample.
+ *  Each is labeled with the tensor label and its subsample number, separated by a tab.
+ *
+ *  @param [in]  label   the tensor label (the runfile name)
+ *  @param [in]  tensor  the confusion tensor
+ */
+
+  void APRT::ResultWriter::Append(const std::string_view label,
+                                  const ConfusionTensor& tensor)
+    {
+      std::string subsamplelabel;
+      for (uint32_t ssn = 1; ssn <= tensor.Subsamples(); ++ssn)
+        {
+          subsamplelabel.assign(label);
+          subsamplelabel.push_back('\t');
+          subsamplelabel.append(std::to_string(ssn));
+          this->Append(subsamplelabel,tensor(ssn));
+        }
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Formats the matrices of the candidates of a runfile into the buffer, candidate by
+ *  candidate.  Each is labeled with the runfile label and the candidate name, separated
+ *  by a tab.
+ *
+ *  @param [in]  label       the label (the runfile name)
+ *  @param [in]  matrices    the confusion matrix of each candidate
+ *  @param [in]  candidates  the name of each candidate
+ */
+
+  void APRT::ResultWriter::Append(const std::string_view          label,
+                                  const CandidateMatrices&        matrices,
+                                  const std::vector<std::string>& candidates)
+    {
+      assert(matrices.Candidates() == candidates.size());
+      std::string candidatelabel;
+      for (uint32_t candidate = 0; candidate < matrices.Candidates(); ++candidate)
+        {
+          candidatelabel.assign(label);
+          candidatelabel.push_back('\t');
+          candidatelabel.append(candidates[candidate]);
+          this->Append(candidatelabel,matrices(candidate));
+        }
+    }
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes the buffered matrices to the results file with a single write (retried if it
+ *  is interrupted before writing anything).  A write that stores only part of the
+ *  buffer is an error, since the rest could no longer be appended without interleaving
+ *  with other writers; the part written is not written again.
+ */
+
+  void APRT::ResultWriter::Flush()
+    {
+      if (this->buffer.empty())
+        {
+          return;
+        }
+      for (;;)
+        {
+          #ifdef _WIN32
+            const int written = ::_write(this->descriptor,this->buffer.data(),unsigned(this->buffer.size()));
+          #else
+            const ssize_t written = ::write(this->descriptor,this->buffer.data(),this->buffer.size());
+          #endif
+          if ((written < 0) && (errno == EINTR))
+            {
+              continue;
+            }
+          if (written < 0)
+            {
+              throw std::runtime_error("Unable to write to " + this->path + ".");
+            }
+          if (size_t(written) != this->buffer.size())
+            {
+              this->buffer.clear();
+              throw std::runtime_error("Unable to write all of the results to " + this->path + ".");
+            }
+          break;
+        }
+      this->buffer.clear();
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Formats a count, followed by a tab, into the buffer.
+ *
+ *  @param [in]  count  the count
+ */
+
+  void APRT::ResultWriter::AppendCount(const int32_t count)
+    {
+      char digits[16];
+      const std::to_chars_result result = std::to_chars(digits,digits + sizeof(digits),count);
+      this->buffer.append(digits,result.ptr);
+      this->buffer.push_back('\t');
+    }
@@ -0,0 +1,74 @@
+/**
+ *  @file  ResultWriter.h
+ *
+ *  @brief  Definition of the ResultWriter class.
+ *
+ *  Definition of the ResultWriter class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_RESULT_WRITER_H_INCLUDED
+    #define APRT_RESULT_WRITER_H_INCLUDED
+
+    #include <string>
+    #include <string_view>
+    #include <vector>
+
+    #include <stdint.h>
+
+    #include "CandidateMatrices.h"
+    #include "ConfusionMatrix.h"
+    #include "ConfusionTensor.h"
+    #include "DynamicConfusionMatrix.h"
+    #include "LabelTable.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  Appends labeled confusion matrices to a results file.  Matrices are formatted into an
+ *  in-memory buffer and each flush of the buffer is a single append-mode write, so the
+ *  matrices of processes sharing a results file do not interleave; a write the system
+ *  splits (a full disk, ...) fails the flush rather than appending the rest later.
+ */
+
+        class ResultWriter
+          {
+            public:
+              ResultWriter(const std::string& path);
+              ~ResultWriter();
+              ResultWriter(const ResultWriter&) = delete;
+              ResultWriter& operator = (const ResultWriter&) = delete;
+
+            public:
+              void  Write(std::string_view         label,
+                          const ConfusionMatrix<>& matrix);
+              void  Append(std::string_view         label,
+                           const ConfusionMatrix<>& matrix);
+              void  Append(std::string_view              label,
+                           const DynamicConfusionMatrix& matrix,
+                           const LabelTable&             labels);
+              void  Append(std::string_view       label,
+                           const ConfusionTensor& tensor);
+              void  Append(std::string_view                label,
+                           const CandidateMatrices&        matrices,
+                           const std::vector<std::string>& candidates);
+              void  Flush();
+            private:
+              void  AppendCount(int32_t count);
+            private:
+              std::string path;
+                /**< @brief  the results file path */
+              int         descriptor;
+                /**< @brief  the results file, opened for appending */
+              std::string buffer;
+                /**< @brief  the formatted matrices not yet written */
+          };
+      }
+
+  #endif
@@ -0,0 +1,264 @@
+/**
+ *  @file  RunfilePrefetcher.cpp
+ *
+ *  @brief  Implementation of the RunfilePrefetcher class.
+ *
+ *  Implementation of the RunfilePrefetcher class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "RunfilePrefetcher.h"
+
+  #include <algorithm>
+  #include <fstream>
+  #include <stdexcept>
+
+  #include <cerrno>
+
+  #ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+  #endif
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a RunfilePrefetcher and starts its reader thread.
+ *
+ *  @param [in]  directory     the directory containing the runfiles
+ *  @param [in]  runfilenames  the runfiles to read (which must outlive the prefetcher)
+ *  @param [in]  depth         the most runfiles to hold in memory ahead of the consumer
+ *  @param [in]  readacl       whether to read the .acl files as well as the .pcl files
+ */
+
+  APRT::RunfilePrefetcher::RunfilePrefetcher(const std::string&              directory,
+                                             const std::vector<std::string>& runfilenames,
+                                             const uint32_t                  depth,
+                                             const bool                      readacl)
+    : directory(directory),
+      runfilenames(runfilenames),
+      depth(std::max<uint32_t>(depth,1)),
+      readacl(readacl),
+      finished(false),
+      stopped(false)
+        {
+          this->reader = std::thread(&RunfilePrefetcher::Read,this);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Stops the reader thread and waits for it.
+ */
+
+  APRT::RunfilePrefetcher::~RunfilePrefetcher()
+    {
+      this->Stop();
+      this->reader.join();
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Takes the next runfile from the queue, waiting for the reader if necessary.  It may be
+ *  called from several threads; runfiles are handed out in list order.  If the reader
+ *  failed, the runfiles it read before the failure are still handed out, and the failure
+ *  is rethrown once they have all been taken.
+ *
+ *  @param [out]  runfile  the runfile
+ *
+ *  @return  false once every runfile has been taken (or the prefetcher was stopped)
+ */
+
+  bool APRT::RunfilePrefetcher::Next(PrefetchedRunfile& runfile)
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->changed.wait(lock,[this]()
+        {
+          return (!this->queue.empty() || this->finished || this->stopped);
+        });
+      if (this->queue.empty() && this->failure)
+        {
+          std::rethrow_exception(this->failure);
+        }
+      if (this->queue.empty() || this->stopped)
+        {
+          return (false);
+        }
+      runfile = std::move(this->queue.front());
+      this->queue.pop_front();
+      this->changed.notify_all();
+
+      return (true);
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Asks the reader to stop and releases any waiting consumers.
+ */
+
+  void APRT::RunfilePrefetcher::Stop()
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->stopped = true;
+      this->changed.notify_all();
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  The reader thread: reads each runfile's classification files in turn, blocking while
+ *  the queue is full.
+ */
+
+  void APRT::RunfilePrefetcher::Read()
+    {
+      try
+        {
+          for (size_t index = 0; index < this->runfilenames.size(); ++index)
+            {
+              if (index + 1 < this->runfilenames.size())
+                {
+                  Advise(this->directory + this->runfilenames[index + 1] + ".pcl");
+                  if (this->readacl)
+                    {
+                      Advise(this->directory + this->runfilenames[index + 1] + ".acl");
+                    }
+                }
+              PrefetchedRunfile runfile;
+              runfile.index       = index;
+              runfile.runfilename = this->runfilenames[index];
+              ReadFile(this->directory + runfile.runfilename + ".pcl",runfile.pcl);
+              if (this->readacl)
+                {
+                  ReadFile(this->directory + runfile.runfilename + ".acl",runfile.acl);
+                }
+
+              std::unique_lock<std::mutex> lock(this->mutex);
+              this->changed.wait(lock,[this]()
+                {
+                  return ((this->queue.size() < this->depth) || this->stopped);
+                });
+              if (this->stopped)
+                {
+                  break;
+                }
+              this->queue.push_back(std::move(runfile));
+              this->changed.notify_all();
+            }
+        }
+      catch (...)
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->failure = std::current_exception();
+        }
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->finished = true;
+      this->changed.notify_all();
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Asks the kernel to start reading a file into the page cache.  Missing files are
+ *  ignored here and reported when they are read.
+ *
+ *  @param [in]  path  the file path
+ */
+
+  void APRT::RunfilePrefetcher::Advise(const std::string& path)
+    {
+      #if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+        const int descriptor = ::open(path.c_str(),O_RDONLY);
+        if (descriptor >= 0)
+          {
+            ::posix_fadvise(descriptor,0,0,POSIX_FADV_WILLNEED);
+            ::close(descriptor);
+          }
+      #else
+        (void)path;
+      #endif
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Reads a whole file into a buffer with as few reads as possible.  A read error, or
+ *  fewer bytes than the file size, is an error.
+ *
+ *  @param [in]   path    the file path
+ *  @param [out]  buffer  the file contents
+ */
+
+  void APRT::RunfilePrefetcher::ReadFile(const std::string& path,
+                                         std::vector<char>& buffer)
+    {
+      #ifndef _WIN32
+        const int descriptor = ::open(path.c_str(),O_RDONLY);
+        struct stat status;
+        if ((descriptor < 0) || (::fstat(descriptor,&status) != 0))
+          {
+            if (descriptor >= 0)
+              {
+                ::close(descriptor);
+              }
+            throw std::runtime_error("Unable to read " + path + ".");
+          }
+        #ifdef POSIX_FADV_SEQUENTIAL
+          ::posix_fadvise(descriptor,0,0,POSIX_FADV_SEQUENTIAL);
+        #endif
+        buffer.resize(size_t(status.st_size));
+        size_t filled = 0;
+        while (filled < buffer.size())
+          {
+            const ssize_t count = ::read(descriptor,buffer.data() + filled,buffer.size() - filled);
+            if ((count < 0) && (errno == EINTR))
+              {
+                continue;
+              }
+            if (count <= 0)
+              {
+                break;
+              }
+            filled += size_t(count);
+          }
+        ::close(descriptor);
+//
+//  ... failing on an error or a file that ended early, rather than comparing part of it.
+//
+        if (filled != buffer.size())
+          {
+            throw std::runtime_error("Unable to read " + path + ".");
+          }
+      #else
+        std::ifstream stream(path.c_str(),std::ios_base::binary | std::ios_base::ate);
+        if (!stream)
+          {
+            throw std::runtime_error("Unable to read " + path + ".");
+          }
+        buffer.resize(size_t(stream.tellg()));
+        stream.seekg(0);
+        stream.read(buffer.data(),std::streamsize(buffer.size()));
+        if (size_t(stream.gcount()) != buffer.size())
+          {
+            throw std::runtime_error("Unable to read " + path + ".");
+          }
+      #endif
+    }
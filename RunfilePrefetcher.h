@@ -0,0 +1,100 @@
+/**
+ *  @file  RunfilePrefetcher.h
+ *
+ *  @brief  Definition of the RunfilePrefetcher class.
+ *
+ *  Definition of the RunfilePrefetcher class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_RUNFILE_PREFETCHER_H_INCLUDED
+    #define APRT_RUNFILE_PREFETCHER_H_INCLUDED
+
+    #include <condition_variable>
+    #include <deque>
+    #include <exception>
+    #include <mutex>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+    #include <stdint.h>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The classification files of a runfile, read into memory.
+ */
+
+        struct PrefetchedRunfile
+          {
+            size_t             index;        /**< @brief  the position on the runfile list */
+            std::string        runfilename;  /**< @brief  the runfile name                 */
+            std::vector<char>  pcl;          /**< @brief  the apr classification file      */
+            std::vector<char>  acl;          /**< @brief  the user classification file (empty
+                                                          if not read)                     */
+          };
+
+/**
+ *  The reader stage of a two-stage runfile pipeline.  A reader thread reads the .pcl and
+ *  .acl files of the listed runfiles, in list order, into a bounded queue of the given
+ *  depth while the compute stage takes them from the front.  Before reading a runfile
+ *  the reader asks the kernel to start reading the files of the next one
+ *  (posix_fadvise WILLNEED), so the disk is kept busy while a file is copied.  The .acl
+ *  files may be left unread when the user classifications come from elsewhere.
+ */
+
+        class RunfilePrefetcher
+          {
+            public:
+              RunfilePrefetcher(const std::string&              directory,
+                                const std::vector<std::string>& runfilenames,
+                                uint32_t                        depth,
+                                bool                            readacl = true);
+              ~RunfilePrefetcher();
+              RunfilePrefetcher(const RunfilePrefetcher&) = delete;
+              RunfilePrefetcher& operator = (const RunfilePrefetcher&) = delete;
+
+            public:
+              bool  Next(PrefetchedRunfile& runfile);
+              void  Stop();
+            private:
+              void  Read();
+              static void
+                    Advise(const std::string& path);
+              static void
+                    ReadFile(const std::string& path,
+                             std::vector<char>& buffer);
+            private:
+              const std::string               directory;
+                /**< @brief  the directory containing the runfiles */
+              const std::vector<std::string>& runfilenames;
+                /**< @brief  the runfiles to read */
+              const size_t                    depth;
+                /**< @brief  the most runfiles held in the queue */
+              const bool                      readacl;
+                /**< @brief  whether the .acl files are read */
+              std::deque<PrefetchedRunfile>   queue;
+                /**< @brief  the runfiles read but not yet taken */
+              bool                            finished;
+                /**< @brief  whether the reader has stopped */
+              bool                            stopped;
+                /**< @brief  whether the consumer has asked the reader to stop */
+              std::exception_ptr              failure;
+                /**< @brief  the error that stopped the reader, if any */
+              std::mutex                      mutex;
+                /**< @brief  guards the queue and the flags */
+              std::condition_variable         changed;
+                /**< @brief  signals a change to the queue or the flags */
+              std::thread                     reader;
+                /**< @brief  the reader thread */
+          };
+      }
+
+  #endif
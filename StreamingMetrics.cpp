@@ -0,0 +1,111 @@
+/**
+ *  @file  StreamingMetrics.cpp
+ *
+ *  @brief  Implementation of the StreamingMetrics class.
+ *
+ *  Implementation of the StreamingMetrics class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #include "StreamingMetrics.h"
+
+  #include <boost/filesystem.hpp>
+
+  #include <fstream>
+  #include <stdexcept>
+
+  #include "ClassVocabulary.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Creates a StreamingMetrics with no runfiles added.
+ */
+
+  APRT::StreamingMetrics::StreamingMetrics()
+    : runfiles(0)
+      {
+        ;
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Adds the matrix of a runfile.
+ *
+ *  @param [in]  conmatrix  the runfile confusion matrix
+ *
+ *  @return  the metrics of the runfile alone
+ */
+
+  APRT::ClassificationMetrics APRT::StreamingMetrics::Add(const ConfusionMatrix<>& conmatrix)
+    {
+      const ClassTally<> runfile(conmatrix);
+      this->tally += runfile;
+      ++this->runfiles;
+      return (Summarize(runfile));
+    }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Writes the metrics of every runfile added as tab-separated tables: a header line and
+ *  a line of the runfiles, patches, accuracy, macro precision, recall and F1 and Cohen's
+ *  kappa, a blank line, then a header line and per class in use its code, the patches
+ *  the apr and the user called it and both did, its precision, recall and F1.  The file
+ *  is written beside the path and renamed over it, so a reader never sees half of it.
+ *
+ *  @param [in]  path  the metrics file path
+ */
+
+  void APRT::StreamingMetrics::Write(const std::string& path) const
+    {
+      const std::string           partial = path + ".partial";
+      const ClassificationMetrics metrics = this->Metrics();
+      std::ofstream stream(partial.c_str(),std::ios_base::trunc);
+      stream.precision(6);
+      stream << "runfiles\tpatches\taccuracy\tprecision\trecall\tf1\tkappa\n"
+             << this->runfiles
+             << '\t' << metrics.patches
+             << '\t' << metrics.accuracy
+             << '\t' << metrics.precision
+             << '\t' << metrics.recall
+             << '\t' << metrics.f1
+             << '\t' << metrics.kappa
+             << "\n\nclass\tapr\tuser\tagreed\tprecision\trecall\tf1\n";
+      for (uint32_t id = 0; id < ClassVocabulary::Size; ++id)
+        {
+          if ((this->tally.called[id] != 0) || (this->tally.present[id] != 0))
+            {
+              stream << ClassVocabulary::Code(ClassId(id))
+                     << '\t' << this->tally.called[id]
+                     << '\t' << this->tally.present[id]
+                     << '\t' << this->tally.agreed[id]
+                     << '\t' << this->tally.Precision(id)
+                     << '\t' << this->tally.Recall(id)
+                     << '\t' << this->tally.F1(id)
+                     << '\n';
+            }
+        }
+      stream.close();
+//
+//  Publish the file ...
+//
+      boost::system::error_code error;
+      if (stream)
+        {
+          boost::filesystem::rename(partial,path,error);
+        }
+      if (!stream || error)
+        {
+          boost::filesystem::remove(partial,error);
+          throw std::runtime_error("Unable to write the metrics file " + path + ".");
+        }
+    }
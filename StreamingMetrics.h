@@ -0,0 +1,100 @@
+/**
+ *  @file  StreamingMetrics.h
+ *
+ *  @brief  Definition of the StreamingMetrics class.
+ *
+ *  Definition of the StreamingMetrics class.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_STREAMING_METRICS_H_INCLUDED
+    #define APRT_STREAMING_METRICS_H_INCLUDED
+
+    #include <string>
+
+    #include <stdint.h>
+
+    #include "ClassificationMetrics.h"
+    #include "ConfusionMatrix.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  Keeps the agreement metrics of a runfile list up to date as its runfiles are
+ *  compared.  Each runfile's matrix is reduced once to its margins (a ClassTally); from
+ *  then on adding it to the running tally and summing up the runfile and the list so far
+ *  (accuracy, macro precision, recall and F1, Cohen's kappa, and the per-class scores)
+ *  cost O(classes), so nothing is re-read from ConfusionMatrix.txt.
+ */
+
+        class StreamingMetrics
+          {
+            public:
+              StreamingMetrics();
+
+            public:
+              ClassificationMetrics  Add(const ConfusionMatrix<>& conmatrix);
+              uint32_t               Runfiles() const;
+              const ClassTally<>&    Tally() const;
+              ClassificationMetrics  Metrics() const;
+              void                   Write(const std::string& path) const;
+            private:
+              ClassTally<>  tally;
+                /**< @brief  the margins of every runfile added */
+              uint32_t      runfiles;
+                /**< @brief  the number of runfiles added */
+          };
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the number of runfiles added.
+ *
+ *  @return  the number of runfiles
+ */
+
+    inline uint32_t APRT::StreamingMetrics::Runfiles() const
+      {
+        return (this->runfiles);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the margins of every runfile added, for the per-class scores.
+ *
+ *  @return  the tally
+ */
+
+    inline const APRT::ClassTally<>& APRT::StreamingMetrics::Tally() const
+      {
+        return (this->tally);
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the metrics of every runfile added.
+ *
+ *  @return  the metrics
+ */
+
+    inline APRT::ClassificationMetrics APRT::StreamingMetrics::Metrics() const
+      {
+        return (Summarize(this->tally));
+      }
+
+  #endif
@@ -0,0 +1,261 @@
+/**
+ *  @file  Taxonomy.h
+ *
+ *  @brief  Definition of the Taxonomy class template.
+ *
+ *  Definition of the Taxonomy class template.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_TAXONOMY_H_INCLUDED
+    #define APRT_TAXONOMY_H_INCLUDED
+
+    #include <stdexcept>
+    #include <string_view>
+
+    #include <stdint.h>
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The interned form of a patch class; also the row/column of the class in a confusion
+ *  matrix.
+ */
+
+        typedef uint8_t ClassId;
+
+/**
+ *  A class taxonomy: the class codes of an assay in confusion matrix order, the last
+ *  being the class of empty and unrecognized codes.  A taxonomy is built at compile
+ *  time from its code table, which also generates a perfect hash of the codes: each
+ *  code (of up to eight characters) is packed into an integer and a multiplicative hash
+ *  maps the packed codes to distinct slots of a table of at least 4N entries.  Interning
+ *  a code is then one multiply, one shift and a comparison of the packed code and its
+ *  length.  A table with an empty, long or repeated code does not compile.
+ *
+ *  @tparam  N  the number of classes (including the unrecognized class)
+ */
+
+        template <uint32_t N>
+          class Taxonomy
+            {
+              static_assert((N >= 1) && (N <= 256),"a ClassId holds at most 256 classes");
+
+              public:
+                static constexpr uint32_t Size = N;
+                  /**< @brief  the number of classes */
+
+              public:
+                constexpr Taxonomy(const std::string_view (&codes)[N]);
+
+              public:
+                constexpr ClassId           Intern(std::string_view code) const;
+                constexpr std::string_view  Code(ClassId id) const;
+                constexpr ClassId           None() const;
+              private:
+                static constexpr uint64_t   Key(std::string_view code);
+                constexpr uint32_t          Slot(uint64_t key) const;
+                constexpr bool              Place(uint64_t multiplier);
+              private:
+                static constexpr uint32_t Bits = (N <= 4) ? 4 : (N <= 16) ? 6 : (N <= 64) ? 8 : 10;
+                  /**< @brief  log2 of the hash table size */
+                std::string_view  codes[N];
+                  /**< @brief  the class codes indexed by ClassId */
+                uint64_t          multiplier;
+                  /**< @brief  the hash multiplier found for the codes */
+                uint64_t          keys[size_t(1) << Bits];
+                  /**< @brief  the packed code in each slot (0 for an empty slot) */
+                ClassId           ids[size_t(1) << Bits];
+                  /**< @brief  the class in each slot (None() for an empty slot) */
+            };
+
+        template <uint32_t N>
+          Taxonomy(const std::string_view (&codes)[N]) -> Taxonomy<N>;
+      }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Builds a taxonomy and its perfect hash from a table of class codes.
+ *
+ *  @param [in]  codes  the class codes in confusion matrix order (the last for empty and
+ *                      unrecognized codes)
+ */
+
+    template <uint32_t N>
+      constexpr APRT::Taxonomy<N>::Taxonomy(const std::string_view (&codes)[N])
+        : codes(),
+          multiplier(0),
+          keys(),
+          ids()
+            {
+              for (uint32_t id = 0; id < N; ++id)
+                {
+                  if (Key(codes[id]) == 0)
+                    {
+                      throw std::logic_error("a class code must have one to eight characters");
+                    }
+                  for (uint32_t other = 0; other < id; ++other)
+                    {
+                      if (codes[other] == codes[id])
+                        {
+                          throw std::logic_error("the class codes must be distinct");
+                        }
+                    }
+                  this->codes[id] = codes[id];
+                }
+//
+//  Try multipliers from a fixed pseudo-random sequence until one separates the codes ...
+//
+              uint64_t state = 0x9E3779B97F4A7C15ULL;
+              for (uint32_t attempt = 0; attempt < 10000; ++attempt)
+                {
+                  state = state*6364136223846793005ULL + 1442695040888963407ULL;
+                  if (this->Place(state | 1))
+                    {
+                      return;
+                    }
+                }
+              throw std::logic_error("no perfect hash was found for the class codes");
+            }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Interns a class code.
+ *
+ *  @param [in]  code  the apr- or user-assigned class code
+ *
+ *  @return  the class of the code (None() for an empty or unrecognized code)
+ */
+
+    template <uint32_t N>
+      constexpr APRT::ClassId APRT::Taxonomy<N>::Intern(const std::string_view code) const
+        {
+          const uint64_t key  = Key(code);
+          const uint32_t slot = this->Slot(key);
+          return (((this->keys[slot] == key) && (this->codes[this->ids[slot]].size() == code.size())) ?
+                      this->ids[slot] : this->None());
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the code of a class.
+ *
+ *  @param [in]  id  the class
+ *
+ *  @return  the class code
+ */
+
+    template <uint32_t N>
+      constexpr std::string_view APRT::Taxonomy<N>::Code(const ClassId id) const
+        {
+          return (this->codes[id]);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the class of empty and unrecognized codes.
+ *
+ *  @return  the last class
+ */
+
+    template <uint32_t N>
+      constexpr APRT::ClassId APRT::Taxonomy<N>::None() const
+        {
+          return (ClassId(N - 1));
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Packs a code of one to eight characters into an integer.
+ *
+ *  @param [in]  code  the code
+ *
+ *  @return  the packed code, or 0 for a code that cannot be a class code
+ */
+
+    template <uint32_t N>
+      constexpr uint64_t APRT::Taxonomy<N>::Key(const std::string_view code)
+        {
+          if (code.size() > 8)
+            {
+              return (0);
+            }
+          uint64_t key = 0;
+          for (const char c : code)
+            {
+              key = (key << 8) | uint8_t(c);
+            }
+          return (key);
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Returns the hash table slot of a packed code.
+ */
+
+    template <uint32_t N>
+      constexpr uint32_t APRT::Taxonomy<N>::Slot(const uint64_t key) const
+        {
+          return (uint32_t((key*this->multiplier) >> (64 - Bits)));
+        }
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+/**
+ *  Fills the hash table using a multiplier.
+ *
+ *  @param [in]  multiplier  the multiplier to try
+ *
+ *  @return  true if every code has a slot of its own
+ */
+
+    template <uint32_t N>
+      constexpr bool APRT::Taxonomy<N>::Place(const uint64_t multiplier)
+        {
+          this->multiplier = multiplier;
+          for (uint32_t slot = 0; slot < (uint32_t(1) << Bits); ++slot)
+            {
+              this->keys[slot] = 0;
+              this->ids[slot]  = this->None();
+            }
+          for (uint32_t id = 0; id < N; ++id)
+            {
+              const uint64_t key  = Key(this->codes[id]);
+              const uint32_t slot = this->Slot(key);
+              if (this->keys[slot] != 0)
+                {
+                  return (false);
+                }
+              this->keys[slot] = key;
+              this->ids[slot]  = ClassId(id);
+            }
+          return (true);
+        }
+
+  #endif
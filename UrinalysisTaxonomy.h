@@ -0,0 +1,37 @@
+/**
+ *  @file  UrinalysisTaxonomy.h
+ *
+ *  @brief  Definition of the urinalysis class taxonomy.
+ *
+ *  Definition of the urinalysis class taxonomy, the default AssayTaxonomy.  A build for
+ *  another assay names its own taxonomy header (one defining APRT::AssayTaxonomy) with
+ *  APRT_TAXONOMY_HEADER.
+ *
+ *  Copyright &copy; 2014  -  IRIS International, Inc.  -  All rights reserved
+ */
+
+  #ifndef   APRT_URINALYSIS_TAXONOMY_H_INCLUDED
+    #define APRT_URINALYSIS_TAXONOMY_H_INCLUDED
+
+    #include "Taxonomy.h"
+
+
+//-----------------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------------
+
+    namespace APRT
+      {
+
+/**
+ *  The urinalysis classes, in confusion matrix order.
+ */
+
+        inline constexpr Taxonomy AssayTaxonomy(
+          {
+            "RBC",  "DRBC", "RBCC", "WBC",  "WBCC", "BACT", "SQEP", "NSE",  "TREP",
+            "REEP", "CAOX", "URIC", "TPO4", "CAPH", "CYST", "LEUC", "AMOR", "CELL",
+            "GRAN", "MUCS", "SPRM", "BYST", "HYST", "TRCH", "BUBB", "NONE"
+          });
+      }
+
+  #endif